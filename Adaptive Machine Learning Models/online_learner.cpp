@@ -1,8 +1,22 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
-#include <vector>
+#include <limits>
 #include <numeric>
 #include <random>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../Common/ctr_rng.hpp"
+#include "../Common/util.hpp"
 
 enum class Signal { SHORT = -1, FLAT = 0, LONG = 1 };
 
@@ -20,51 +34,401 @@ Signal mean_reversion_expert(double ret_prev) {
     return static_cast<Signal>(-sign(ret_prev));
 }
 
-Signal noise_expert(std::mt19937& rng) {
-    std::uniform_int_distribution<int> U(-1, 1);
+Signal noise_expert(std::mt19937& rng, std::uniform_int_distribution<int>& U) {
     return static_cast<Signal>(U(rng));
 }
 
-int main() {
+// Every row of the engine starts on a cache line.
+using Row = std::vector<double, util::AlignedAllocator<double>>;
+
+// --- Hedge engine: exponential weights over n experts (Hedge / exponentiated
+// gradient on linear gains). Expert i has signal s_i in [-1, 1] and log-weight
+// l_i; after the return r of a step, l_i += eta * s_i * r. The weights are
+//     w_i = exp(l_i - lse),   lse = log sum_j exp(l_j) = m + log sum_j exp(l_j - m)
+// with m = max_j l_j (log-sum-exp), so no weight overflows or vanishes to 0
+// however long the run or large eta * r. Each update also subtracts the last
+// lse from every l_i, which keeps them normalized (sum_i exp(l_i) = 1 before
+// the gain) and near 0.
+//
+// With min_weight > 0, log-weights are floored at log(min_weight) after every
+// update (relative to the previous normalization), so an expert that lost
+// never drops below about min_weight and can win again after a regime change:
+// a cheap form of fixed share (Herbster & Warmuth) for tracking the best expert.
+//
+// Signals and log-weights are aligned rows padded to a multiple of 4 experts
+// (padding: signal 0, log-weight -inf). predict() is one pass over them (exp,
+// normalizer and weighted signal sum) and update() another (gain and running
+// max), four experts per AVX2 instruction with the polynomial exp of
+// ../Common/ctr_rng.hpp. Nothing is allocated after construction.
+class Hedge {
+public:
+    Hedge(size_t n, double eta, double min_weight = 0.0)
+        : n_(n), stride_((n + 3) / 4 * 4), eta_(eta),
+          floor_(min_weight > 0.0 ? std::log(min_weight) : -std::numeric_limits<double>::infinity()),
+          s_(stride_, 0.0), l_(stride_, -std::numeric_limits<double>::infinity()) {
+        std::fill(l_.begin(), l_.begin() + n, 0.0);
+    }
+
+    size_t size() const { return n_; }
+    double eta() const { return eta_; }
+
+    // Signals of the current step, written by the caller (i < size()).
+    double* signals() { return s_.data(); }
+    const double* signals() const { return s_.data(); }
+
+    // Aggregate signal sum_i w_i s_i of the current signals.
+    double predict() {
+        double z = 0.0, a = 0.0;
+#if defined(__AVX2__)
+        const __m256d m = _mm256_set1_pd(m_);
+        __m256d vz = _mm256_setzero_pd(), va = _mm256_setzero_pd();
+        for (size_t i = 0; i < stride_; i += 4) {
+            const __m256d e = ctr::detail::exp4(_mm256_sub_pd(_mm256_load_pd(&l_[i]), m));
+            vz = _mm256_add_pd(vz, e);
+            va = ctr::detail::fmadd(e, _mm256_load_pd(&s_[i]), va);
+        }
+        z = hsum(vz);
+        a = hsum(va);
+#else
+        // padding has weight 0: the scalar passes stop at n_
+        for (size_t i = 0; i < n_; ++i) {
+            const double e = std::exp(l_[i] - m_);
+            z += e;
+            a += e * s_[i];
+        }
+#endif
+        lse_ = m_ + std::log(z);
+        normalized_ = true;
+        return a / z;
+    }
+
+    // Gains of the current signals for the return r: l_i += eta * s_i * r.
+    void update(double r) {
+        if (!normalized_) predict();
+        const double g = eta_ * r;
+        double mx;
+#if defined(__AVX2__)
+        const __m256d vg = _mm256_set1_pd(g), lse = _mm256_set1_pd(lse_), lo = _mm256_set1_pd(floor_);
+        __m256d vm = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        for (size_t i = 0; i < stride_; i += 4) {
+            const __m256d l = _mm256_max_pd(
+                ctr::detail::fmadd(vg, _mm256_load_pd(&s_[i]), _mm256_sub_pd(_mm256_load_pd(&l_[i]), lse)), lo);
+            _mm256_store_pd(&l_[i], l);
+            vm = _mm256_max_pd(vm, l);
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, vm);
+        mx = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#else
+        mx = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < n_; ++i) {
+            l_[i] = std::max((l_[i] - lse_) + g * s_[i], floor_);
+            mx = std::max(mx, l_[i]);
+        }
+#endif
+        // the floor lifted the padding too; every live expert is above it
+        for (size_t i = n_; i < stride_; ++i) l_[i] = -std::numeric_limits<double>::infinity();
+        m_ = mx;
+        normalized_ = false;
+    }
+
+    // Normalized weight of expert i.
+    double weight(size_t i) {
+        if (!normalized_) predict();
+        return std::exp(l_[i] - lse_);
+    }
+
+    // Log of the normalized weight of expert i.
+    double log_weight(size_t i) {
+        if (!normalized_) predict();
+        return l_[i] - lse_;
+    }
+
+private:
+#if defined(__AVX2__)
+    static double hsum(__m256d v) {
+        const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+#endif
+
+    size_t n_, stride_;
+    double eta_, floor_;
+    Row s_, l_;
+    double m_ = 0.0;            // max_i l_i
+    double lse_ = 0.0;          // log sum_i exp(l_i), valid when normalized_
+    bool normalized_ = false;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Largest library: two rows of doubles per expert, 256 MB at this size.
+constexpr uint64_t kMaxExperts = 1 << 24;
+
+// --- Signal library: 2K experts, trend-following and mean-reverting rules on
+// the cumulative return over lookbacks 1..K, aggregated tick by tick on an
+// AR(1) stream whose autocorrelation switches sign every `regime` steps.
+static int run_library(int n_experts, long T, int regime, double eta, double min_weight, uint64_t seed) {
+    const int K = std::max(1, n_experts / 2);
+    Hedge hedge(2 * (size_t)K, eta, min_weight);
+    double* s = hedge.signals();
+
+    // cumulative returns of the last K + 1 steps, ring
+    std::vector<double> S(K + 1, 0.0);
+    double cum = 0.0, r_prev = 0.0, pnl = 0.0;
+    ctr::Stream rng(seed, 0, 0);
+
+    std::cout << "Signal library: " << 2 * K << " experts (trend / mean reversion, lookbacks 1.." << K
+              << "), eta=" << eta << ", min weight=" << min_weight << ", regime switch every " << regime << " steps\n";
+    std::cout << std::fixed;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (long t = 1; t <= T; ++t) {
+        // expert k / K + k: sign of the return over the last k + 1 steps, and its opposite
+        size_t j = (size_t)((t - 2 + 2 * (K + 1)) % (K + 1));   // slot of the cumulative return 2 steps back
+        for (int k = 0; k < K; ++k) {
+            const double v = sign(cum - S[j]);
+            s[k] = v;
+            s[K + k] = -v;
+            j = j ? j - 1 : (size_t)K;
+        }
+        const double decision = sign(hedge.predict());
+
+        const double phi = ((t / regime) % 2 == 0) ? 0.3 : -0.3;
+        const double r = phi * r_prev + 0.01 * rng.normal();
+        pnl += decision * r;
+        hedge.update(r);
+
+        cum += r;
+        S[(size_t)(t % (K + 1))] = cum;
+        r_prev = r;
+
+        if (t % (T / 10 > 0 ? T / 10 : 1) == 0) {
+            size_t best = 0;
+            double h = 0.0;
+            for (size_t i = 0; i < hedge.size(); ++i) {
+                const double lw = hedge.log_weight(i);
+                if (lw > hedge.log_weight(best)) best = i;
+                h -= std::exp(lw) * lw;
+            }
+            std::cout << "t=" << std::setw(8) << t << " | pnl=" << std::setprecision(4) << std::setw(8) << pnl
+                      << " | top: " << (best < (size_t)K ? "trend " : "mean-rev ") << "L=" << best % K + 1
+                      << " w=" << std::setprecision(3) << hedge.weight(best) << " | effective experts "
+                      << std::setprecision(1) << std::exp(h) << "\n";
+        }
+    }
+    const double secs = seconds_since(t0);
+    std::cout << std::setprecision(1) << T << " steps in " << std::setprecision(2) << secs << " s: "
+              << std::setprecision(1) << (double)T * hedge.size() / secs / 1e6
+              << " M expert-weight updates/s (signals included)\n";
+    return 0;
+}
+
+static volatile double sink_;   // keeps the benchmark loops
+
+// --- Throughput: predict + update per step on fixed random signals, against the
+// per-step allocation / std::exp / renormalize loop of the original engine.
+static int run_bench(double updates) {
+    std::vector<double> returns(4096);
+    ctr::Stream rng(7, 0, 0);
+    for (double& r : returns) r = 0.01 * rng.normal();
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Expert-weight updates per second (predict + update per step):\n";
+    for (size_t n : {3, 64, 1024, 4096, 65536}) {
+        const long steps = std::max(1L, (long)(updates / (double)n));
+        Hedge hedge(n, 0.5);
+        for (size_t i = 0; i < n; ++i) hedge.signals()[i] = 2.0 * rng.uniform() - 1.0;
+        double sink = 0.0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (long t = 0; t < steps; ++t) {
+            sink += hedge.predict();
+            hedge.update(returns[(size_t)t & 4095]);
+        }
+        const double secs = seconds_since(t0);
+
+        // original loop: vector per step, std::exp per weight, separate normalization
+        std::vector<double> w(n, 1.0 / n), sig(hedge.signals(), hedge.signals() + n);
+        const long ref_steps = std::max(1L, steps / 20);
+        t0 = std::chrono::steady_clock::now();
+        for (long t = 0; t < ref_steps; ++t) {
+            std::vector<double> experts(sig.begin(), sig.end());
+            double agg = 0.0;
+            for (size_t i = 0; i < n; ++i) agg += w[i] * experts[i];
+            sink += agg;
+            const double r = returns[(size_t)t & 4095];
+            for (size_t i = 0; i < n; ++i) w[i] *= std::exp(0.5 * experts[i] * r);
+            const double norm = std::accumulate(w.begin(), w.end(), 0.0);
+            for (auto& x : w) x /= norm;
+        }
+        const double ref_secs = seconds_since(t0);
+
+        std::cout << "  " << std::setw(6) << n << " experts: engine " << std::setw(7)
+                  << (double)steps * n / secs / 1e6 << " M/s (" << std::setprecision(0) << secs / steps * 1e9
+                  << " ns/step), original loop " << std::setprecision(1) << std::setw(6)
+                  << (double)ref_steps * n / ref_secs / 1e6 << " M/s\n";
+        sink_ = sink;
+    }
+    return 0;
+}
+
+// Engine vs the linear-domain update (std::exp, renormalize) on random signals,
+// and vs the closed form w_i = softmax(eta * G_i) (G_i: cumulative gain) where
+// the linear update overflows.
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAILED: " << what << "\n";
+            ++failures;
+        }
+    };
+
+    ctr::Stream rng(99, 0, 0);
+    double max_w = 0.0, max_p = 0.0;
+    for (size_t n : {1, 3, 4, 5, 1000, 4099}) {
+        Hedge hedge(n, 0.5);
+        std::vector<double> w(n, 1.0 / n);
+        for (int t = 0; t < 3000; ++t) {
+            double* s = hedge.signals();
+            double agg = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                s[i] = (t % 3 == 0) ? (double)((int)(rng.next_u32() % 3) - 1) : 2.0 * rng.uniform() - 1.0;
+                agg += w[i] * s[i];
+            }
+            max_p = std::max(max_p, std::fabs(hedge.predict() - agg));
+            const double r = 0.05 * rng.normal();
+            hedge.update(r);
+            double norm = 0.0;
+            for (size_t i = 0; i < n; ++i) norm += (w[i] *= std::exp(0.5 * s[i] * r));
+            for (size_t i = 0; i < n; ++i) w[i] /= norm;
+        }
+        for (size_t i = 0; i < n; ++i) max_w = std::max(max_w, std::fabs(hedge.weight(i) - w[i]) / std::max(w[i], 1e-300));
+    }
+    expect(max_w < 1e-10, "weights vs linear-domain update");
+    expect(max_p < 1e-12, "aggregate signal vs linear-domain update");
+    std::cout << std::scientific << std::setprecision(2) << "Engine vs linear-domain update (1 to 4099 experts, 3000 steps): "
+              << "max relative weight diff " << max_w << ", max aggregate diff " << max_p << "\n";
+
+    // eta * gain of up to +-40 per step: linear weights overflow within 20 steps
+    {
+        const size_t n = 777;
+        Hedge hedge(n, 40.0);
+        std::vector<double> G(n, 0.0);
+        for (int t = 0; t < 500; ++t) {
+            for (size_t i = 0; i < n; ++i) {
+                hedge.signals()[i] = 2.0 * rng.uniform() - 1.0;
+                G[i] += hedge.signals()[i] * (t % 2 ? 1.0 : -0.9);
+            }
+            hedge.predict();
+            hedge.update(t % 2 ? 1.0 : -0.9);
+        }
+        double mx = -1e300, z = 0.0, sum = 0.0, diff = 0.0;
+        for (double g : G) mx = std::max(mx, 40.0 * g);
+        for (double g : G) z += std::exp(40.0 * g - mx);
+        for (size_t i = 0; i < n; ++i) {
+            const double ref = 40.0 * G[i] - mx - std::log(z);
+            const double lw = hedge.log_weight(i);
+            sum += hedge.weight(i);
+            if (ref > -700.0) diff = std::max(diff, std::fabs(lw - ref));
+        }
+        const bool ok = std::isfinite(sum) && std::fabs(sum - 1.0) < 1e-12 && diff < 1e-8;
+        expect(ok, "log-domain weights under large gains");
+        std::cout << "Large gains (eta * gain up to 40 per step, 500 steps): weights sum to 1 - " << std::fabs(1.0 - sum)
+                  << ", max log-weight diff vs softmax(eta G) " << diff << "\n";
+    }
+
+    // weight floor: expert 0 wins for 2000 steps, then expert 1; nobody drops
+    // below the floor, expert 1 takes over, the padding stays at weight 0
+    {
+        const size_t n = 501;
+        const double min_weight = 1e-4;
+        Hedge hedge(n, 0.5, min_weight);
+        Hedge plain(n, 0.5);
+        double lowest = 1.0;
+        for (int t = 0; t < 4000; ++t) {
+            for (Hedge* h : {&hedge, &plain}) {
+                for (size_t i = 0; i < n; ++i) h->signals()[i] = 0.2 * (rng.uniform() - 0.5);
+                h->signals()[t < 2000 ? 0 : 1] = 1.0;
+                h->predict();
+                h->update(0.02);
+            }
+            for (size_t i = 0; i < n; ++i) lowest = std::min(lowest, hedge.weight(i));
+        }
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) sum += hedge.weight(i);
+        const bool ok = lowest > 0.9 * min_weight && std::fabs(sum - 1.0) < 1e-12 && hedge.weight(1) > 0.5 &&
+                        plain.weight(1) < 0.5;
+        expect(ok, "weight floor");
+        std::cout << "Weight floor 1e-4: lowest weight " << lowest << ", weights sum to 1 - " << std::fabs(1.0 - sum)
+                  << ", second leader " << std::fixed << std::setprecision(3) << hedge.weight(1)
+                  << " (without floor " << plain.weight(1) << ")\n";
+    }
+
+    std::cout << (failures == 0 ? "Hedge check: OK" : "Hedge check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// ./online_learner                     three experts (trend, mean reversion, noise), weights every 500 steps
+// ./online_learner library [experts=2000] [T=200000] [regime=20000] [eta=0.5] [min_weight=1e-5] [seed=123]   signal library
+// ./online_learner bench [updates=200000000]   engine throughput vs the original loop
+// ./online_learner check                engine vs linear-domain and closed-form weights
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    std::string err;
+    if (mode == "library") {
+        uint64_t experts, T, regime;
+        if (!util::arg_count_in(argc, argv, "experts", 2000, 1, kMaxExperts, experts, err) ||
+            !util::arg_count_in(argc, argv, "T", 200000, 1, LONG_MAX, T, err) ||
+            !util::arg_count_in(argc, argv, "regime", 20000, 1, INT_MAX, regime, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        return run_library((int)experts, (long)T, (int)regime, util::arg_value(argc, argv, "eta", 0.5),
+                           util::arg_value(argc, argv, "min_weight", 1e-5), util::arg_u64(argc, argv, "seed", 123));
+    }
+    if (mode == "bench") {
+        uint64_t updates;
+        if (!util::arg_count_in(argc, argv, "updates", 200000000, 1, UINT64_MAX, updates, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        return run_bench((double)updates);
+    }
+    if (mode == "check") return run_check();
+
     const int T = 3000;
     const double eta = 0.5;
 
     std::mt19937 rng(123);
     std::normal_distribution<double> N(0.0, 0.01);
+    std::uniform_int_distribution<int> U(-1, 1);
 
-    std::vector<double> weights = {1.0/3, 1.0/3, 1.0/3};
-    std::vector<double> returns(T);
+    Hedge hedge(3, eta);
+    double* experts = hedge.signals();
+    double ret_prev = 0.0;
 
     for (int t = 1; t < T; ++t) {
         double r = N(rng);
-        returns[t] = r;
 
-        Signal e1 = trend_expert(returns[t-1]);
-        Signal e2 = mean_reversion_expert(returns[t-1]);
-        Signal e3 = noise_expert(rng);
+        experts[0] = static_cast<int>(trend_expert(ret_prev));
+        experts[1] = static_cast<int>(mean_reversion_expert(ret_prev));
+        experts[2] = static_cast<int>(noise_expert(rng, U));
 
-        std::vector<Signal> experts = {e1, e2, e3};
-
-        double agg = 0.0;
-        for (size_t i = 0; i < experts.size(); ++i)
-            agg += weights[i] * static_cast<int>(experts[i]);
-
-        Signal decision = static_cast<Signal>(sign(agg));
+        Signal decision = static_cast<Signal>(sign(hedge.predict()));
 
         double realized = static_cast<int>(decision) * r;
+        (void)realized;
 
-        for (size_t i = 0; i < weights.size(); ++i) {
-            weights[i] *= std::exp(eta * static_cast<int>(experts[i]) * r);
-        }
-
-        double norm = std::accumulate(weights.begin(), weights.end(), 0.0);
-        for (auto& w : weights) w /= norm;
+        hedge.update(r);
+        ret_prev = r;
 
         if (t % 500 == 0) {
             std::cout << "t=" << t
-                      << " | w_trend=" << weights[0]
-                      << " w_mr=" << weights[1]
-                      << " w_noise=" << weights[2]
+                      << " | w_trend=" << hedge.weight(0)
+                      << " w_mr=" << hedge.weight(1)
+                      << " w_noise=" << hedge.weight(2)
                       << "\n";
         }
     }
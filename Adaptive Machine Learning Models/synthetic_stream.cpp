@@ -1,8 +1,17 @@
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <random>
+#include <string>
 #include <vector>
 
+#include "../Common/async_writer.hpp"
+#include "../Common/columnar.hpp"
+#include "../Common/ctr_rng.hpp"
+#include "../Common/util.hpp"
+
 enum class Regime { TREND, MEAN_REVERT, NOISE };
 
 struct MarketPoint {
@@ -11,9 +20,15 @@ struct MarketPoint {
     Regime regime;
 };
 
-std::vector<MarketPoint> generate_market(int T, unsigned seed = 42) {
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
+// Step t draws its shock from block t / kStepBlock of path 0 (Common/ctr_rng.hpp).
+// Shocks are filled block by block on n_threads threads; the mean-reverting drift
+// needs the previous price, so prices follow in one pass and the series does not
+// depend on the thread count.
+std::vector<MarketPoint> generate_market(int T, unsigned seed = 42, int n_threads = 0) {
+    std::vector<double> z(T);
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        ctr::Stream(seed, 0, b).normals(&z[t0], t1 - t0);
+    });
 
     std::vector<MarketPoint> data;
     data.reserve(T);
@@ -33,7 +48,7 @@ std::vector<MarketPoint> generate_market(int T, unsigned seed = 42) {
         if (regime == Regime::MEAN_REVERT) mu = -0.001 * (price - 100.0);
         if (regime == Regime::NOISE) mu = 0.0;
 
-        double ret = mu + sigma * N(rng);
+        double ret = mu + sigma * z[t];
         price *= std::exp(ret);
 
         data.push_back({price, ret, regime});
@@ -42,11 +57,50 @@ std::vector<MarketPoint> generate_market(int T, unsigned seed = 42) {
     return data;
 }
 
-int main() {
-    auto market = generate_market(3000);
+// Columnar output: price, ret (f64), regime (u8: 0 TREND, 1 MEAN_REVERT, 2 NOISE).
+static int write_columnar(const std::string& path, const std::vector<MarketPoint>& market) {
+    col::Writer w;
+    if (!w.open(path, {{"price", col::Type::F64}, {"ret", col::Type::F64}, {"regime", col::Type::U8}},
+                market.size())) {
+        std::cerr << w.error() << "\n";
+        return 1;
+    }
+    for (const auto& p : market) w.append(p.price, p.ret, static_cast<uint8_t>(p.regime));
+    if (!w.close()) {
+        std::cerr << w.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
 
-    for (const auto& p : market) {
-        std::cout << p.price << " " << p.ret << "\n";
+// Text output to stdout: "price ret" per point, written by a background thread.
+static int write_text(const std::vector<MarketPoint>& market) {
+    aout::Writer out;
+    out.open_fd(1);
+    for (const auto& p : market) out << p.price << ' ' << p.ret << '\n';
+    if (!out.close()) {
+        std::cerr << out.error() << "\n";
+        return 1;
     }
     return 0;
 }
+
+// ./synthetic_stream [n=T]                text to stdout
+// ./synthetic_stream write FILE [n=T]     columnar binary file
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    const bool to_file = (mode == "write");
+    if (to_file ? (argc < 3 || std::strchr(argv[2], '=') != nullptr)
+                : !(mode.empty() || mode.compare(0, 2, "n=") == 0)) {
+        std::cerr << "Usage: synthetic_stream [n=T] | synthetic_stream write FILE [n=T]\n";
+        return 1;
+    }
+    uint64_t n = 0;
+    if (!util::arg_count(argc, argv, "n", 3000, n) || n == 0 || n > INT_MAX) {
+        std::cerr << "n= must be a count in [1, " << INT_MAX << "]\n";
+        return 1;
+    }
+    const int T = (int)n;
+    if (to_file) return write_columnar(argv[2], generate_market(T));
+    return write_text(generate_market(T));
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+// Asynchronous batched output: records are formatted into large blocks by the
+// producing thread and written by a background thread. Header-only.
+//
+// aout::Writer is used like an ostream (out << t << ' ' << price << '\n').
+// Numbers are formatted with std::to_chars: no locale, no virtual calls, no
+// stream state. Integers come out as with std::ostream, and doubles as with the
+// default ostream format (%g, 6 significant digits), so a program switched from
+// std::cout keeps its output byte for byte. aout::Fixed{x, p} matches
+// std::fixed << std::setprecision(p). raw(v) appends the bytes of a trivially
+// copyable record, for binary streams.
+//
+// The writer owns a ring of n_blocks blocks (default 8 x 1 MB). The producer
+// fills one block, publishes it and moves on to the next free one. The writer
+// thread writes published blocks in order, one write(2) per block, and gives
+// them back. The ring is single-producer / single-consumer, synchronized by two
+// counters (blocks published, blocks written) with acquire / release ordering;
+// there is no lock. The producer waits only when every block is still waiting
+// to be written, i.e. when the disk cannot keep up. One Writer belongs to one
+// producing thread; threads that emit in parallel use one Writer each.
+//
+// Output to stdout (open_fd(1)) flushes std::cout and stdio first; nothing else
+// should write to the same descriptor until close().
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace aout {
+
+// std::fixed << std::setprecision(decimals) << value
+struct Fixed {
+    double value;
+    int decimals;
+};
+
+class Writer {
+public:
+    explicit Writer(size_t block_bytes = 1 << 20, int n_blocks = 8)
+        : block_bytes_(std::max<size_t>(block_bytes, 64)), n_blocks_(std::max(n_blocks, 2)) {}
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer() { close(); }
+
+    // Creates / truncates path.
+    bool open(const std::string& path) {
+        close();
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            failed_.store(false, std::memory_order_relaxed);
+            error_.clear();
+            return fail("cannot create " + path);
+        }
+        return start(fd, true);
+    }
+
+    // Writes to an open descriptor, left open by close().
+    bool open_fd(int fd) {
+        close();
+        if (fd == 1) {
+            std::cout.flush();
+            std::fflush(stdout);
+        }
+        return start(fd, false);
+    }
+
+    bool ok() const { return !failed_.load(std::memory_order_acquire); }
+    const std::string& error() const { return error_; }   // after close()
+    uint64_t bytes() const { return bytes_ + (uint64_t)(cur_ - base_); }
+
+    // --- Text
+    Writer& write(const char* s, size_t n) {
+        while (n > 0) {
+            if (cur_ == end_) next_block();
+            const size_t k = std::min(n, (size_t)(end_ - cur_));
+            std::memcpy(cur_, s, k);
+            cur_ += k;
+            s += k;
+            n -= k;
+        }
+        return *this;
+    }
+    Writer& operator<<(const char* s) { return write(s, std::strlen(s)); }
+    Writer& operator<<(const std::string& s) { return write(s.data(), s.size()); }
+    Writer& operator<<(char c) {
+        if (cur_ == end_) next_block();
+        *cur_++ = c;
+        return *this;
+    }
+
+    template <class I, std::enable_if_t<std::is_integral<I>::value && !std::is_same<I, char>::value, int> = 0>
+    Writer& operator<<(I v) {
+        reserve(24);
+        cur_ = std::to_chars(cur_, end_, v).ptr;
+        return *this;
+    }
+
+    Writer& operator<<(double v) {
+        reserve(32);
+        cur_ = std::to_chars(cur_, end_, v, std::chars_format::general, 6).ptr;
+        return *this;
+    }
+
+    Writer& operator<<(const Fixed& f) {
+        const int p = std::min(std::max(f.decimals, 0), 64);
+        auto r = std::to_chars(cur_, end_, f.value, std::chars_format::fixed, p);
+        if (r.ec == std::errc()) {
+            cur_ = r.ptr;
+            return *this;
+        }
+        char buf[400];   // 309 integer digits at most, sign, point, decimals
+        r = std::to_chars(buf, buf + sizeof buf, f.value, std::chars_format::fixed, p);
+        return write(buf, (size_t)(r.ptr - buf));
+    }
+
+    // --- Binary
+    template <class T>
+    Writer& raw(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw() needs a trivially copyable record");
+        return write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    // Hands the current block over and waits until everything is written.
+    void flush() {
+        if (!running_) return;
+        publish();
+        int spin = 0;
+        while (written_.load(std::memory_order_acquire) != published_.load(std::memory_order_relaxed)) backoff_pause(spin);
+        acquire_block();
+    }
+
+    // Writes everything out, stops the writer thread and closes the file.
+    bool close() {
+        if (!running_) return ok();
+        publish();
+        closing_.store(true, std::memory_order_release);
+        thread_.join();
+        running_ = false;
+        if (own_fd_ && ::close(fd_) != 0) fail("close failed");
+        fd_ = -1;
+        cur_ = base_ = end_ = nullptr;
+        return ok();
+    }
+
+private:
+    bool fail(const std::string& msg) {
+        if (!failed_.exchange(true, std::memory_order_acq_rel)) error_ = msg;
+        return false;
+    }
+
+    bool start(int fd, bool own) {
+        error_.clear();
+        failed_.store(false, std::memory_order_relaxed);
+        fd_ = fd;
+        own_fd_ = own;
+        bytes_ = 0;
+        blocks_.assign((size_t)n_blocks_ * block_bytes_, 0);
+        lengths_.assign((size_t)n_blocks_, 0);
+        published_.store(0, std::memory_order_relaxed);
+        written_.store(0, std::memory_order_relaxed);
+        closing_.store(false, std::memory_order_relaxed);
+        running_ = true;
+        acquire_block();
+        thread_ = std::thread([this] { drain(); });
+        return true;
+    }
+
+    // Waits (yield, then short sleeps) in a polling loop; spin counts the calls.
+    static void backoff_pause(int& spin) {
+        if (spin < 64) {
+            ++spin;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void reserve(size_t n) {
+        if ((size_t)(end_ - cur_) < n) next_block();
+    }
+
+    void next_block() {
+        publish();
+        acquire_block();
+    }
+
+    // Publishes the current block if it holds anything.
+    void publish() {
+        const size_t used = (size_t)(cur_ - base_);
+        if (used == 0) return;
+        const uint64_t p = published_.load(std::memory_order_relaxed);
+        lengths_[p % n_blocks_] = used;
+        bytes_ += used;
+        published_.store(p + 1, std::memory_order_release);
+        cur_ = end_ = base_;
+    }
+
+    // Points cur_ at the next block, once the writer has given it back.
+    void acquire_block() {
+        const uint64_t p = published_.load(std::memory_order_relaxed);
+        int spin = 0;
+        while (p - written_.load(std::memory_order_acquire) >= (uint64_t)n_blocks_) backoff_pause(spin);
+        base_ = cur_ = blocks_.data() + (p % n_blocks_) * block_bytes_;
+        end_ = base_ + block_bytes_;
+    }
+
+    // Writer thread: writes published blocks in order until closed and drained.
+    void drain() {
+        int spin = 0;
+        for (;;) {
+            const uint64_t w = written_.load(std::memory_order_relaxed);
+            if (w == published_.load(std::memory_order_acquire)) {
+                if (closing_.load(std::memory_order_acquire) && w == published_.load(std::memory_order_acquire)) return;
+                backoff_pause(spin);
+                continue;
+            }
+            spin = 0;
+            const char* p = blocks_.data() + (w % n_blocks_) * block_bytes_;
+            size_t n = lengths_[w % n_blocks_];
+            while (n > 0 && ok()) {   // after a failure, blocks are dropped
+                const ssize_t k = ::write(fd_, p, n);
+                if (k < 0) {
+                    if (errno == EINTR) continue;
+                    fail(std::string("write failed: ") + std::strerror(errno));
+                    break;
+                }
+                p += k;
+                n -= (size_t)k;
+            }
+            written_.store(w + 1, std::memory_order_release);
+        }
+    }
+
+    const size_t block_bytes_;
+    const int n_blocks_;
+    std::vector<char> blocks_;
+    std::vector<size_t> lengths_;
+    std::atomic<uint64_t> published_{0}, written_{0};
+    std::atomic<bool> closing_{false}, failed_{false};
+    std::thread thread_;
+    bool running_ = false;
+
+    char *base_ = nullptr, *cur_ = nullptr, *end_ = nullptr;   // producer's current block
+    uint64_t bytes_ = 0;                                       // published so far
+    int fd_ = -1;
+    bool own_fd_ = false;
+    std::string error_;   // first failure, set once with failed_
+};
+
+} // namespace aout
@@ -0,0 +1,459 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ctr_rng.hpp"
+#include "order_book.hpp"
+#include "util.hpp"
+
+// Heap allocation counter: the book's hot path must not allocate once warm.
+static std::atomic<uint64_t> g_allocs{0};
+
+// (out of line, so the compiler does not pair the inlined free() with new)
+__attribute__((noinline)) void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// --- Reference book: std::map of price levels, std::list FIFOs, hash map of IDs
+// (the textbook layout, one heap node per order and per level). Same rules as
+// lob::Book, used as the oracle in check mode and as the baseline in bench mode.
+class RefBook {
+public:
+    int64_t best_bid() const { return bids_.empty() ? lob::kNoBid : bids_.rbegin()->first; }
+    int64_t best_ask() const { return asks_.empty() ? lob::kNoAsk : asks_.begin()->first; }
+    size_t order_count() const { return orders_.size(); }
+
+    uint64_t add(lob::Side s, int64_t px, int64_t qty, lob::Exec& ex) {
+        ex = match(s, qty, px);
+        qty -= ex.filled;
+        if (qty == 0) return 0;
+        const uint64_t id = ++next_id_;
+        rest(id, s, px, qty);
+        return id;
+    }
+
+    bool cancel(uint64_t id) {
+        auto it = orders_.find(id);
+        if (it == orders_.end()) return false;
+        remove(it->second);
+        orders_.erase(it);
+        return true;
+    }
+
+    bool modify(uint64_t id, int64_t px, int64_t qty, lob::Exec& ex) {
+        ex = {};
+        auto it = orders_.find(id);
+        if (it == orders_.end()) return false;
+        if (qty <= 0) return cancel(id);
+        Entry e = it->second;
+        if (px == e.px && qty <= e.pos->second) {
+            e.pos->second = qty;
+            return true;
+        }
+        remove(e);
+        orders_.erase(it);
+        ex = match(e.side, qty, px);
+        qty -= ex.filled;
+        if (qty > 0) rest(id, e.side, px, qty);
+        return true;
+    }
+
+    lob::Exec market(lob::Side taker, int64_t qty) {
+        return match(taker, qty, taker == lob::Side::Buy ? lob::kNoAsk : lob::kNoBid);
+    }
+
+    int64_t depth(lob::Side s, int64_t px) const {
+        const Levels& side = s == lob::Side::Buy ? bids_ : asks_;
+        auto it = side.find(px);
+        if (it == side.end()) return 0;
+        int64_t q = 0;
+        for (const auto& o : it->second) q += o.second;
+        return q;
+    }
+
+    // Quantities of one level in queue order.
+    std::vector<int64_t> queue(lob::Side s, int64_t px) const {
+        std::vector<int64_t> q;
+        const Levels& side = s == lob::Side::Buy ? bids_ : asks_;
+        auto it = side.find(px);
+        if (it != side.end()) for (const auto& o : it->second) q.push_back(o.second);
+        return q;
+    }
+
+private:
+    using Fifo = std::list<std::pair<uint64_t, int64_t>>;   // (id, qty)
+    using Levels = std::map<int64_t, Fifo>;
+    struct Entry {
+        lob::Side side;
+        int64_t px;
+        Fifo::iterator pos;
+    };
+
+    void rest(uint64_t id, lob::Side s, int64_t px, int64_t qty) {
+        Fifo& f = (s == lob::Side::Buy ? bids_ : asks_)[px];
+        f.emplace_back(id, qty);
+        orders_[id] = {s, px, std::prev(f.end())};
+    }
+
+    void remove(const Entry& e) {
+        Levels& side = e.side == lob::Side::Buy ? bids_ : asks_;
+        auto lv = side.find(e.px);
+        lv->second.erase(e.pos);
+        if (lv->second.empty()) side.erase(lv);
+    }
+
+    lob::Exec match(lob::Side taker, int64_t qty, int64_t limit) {
+        lob::Exec ex;
+        Levels& side = taker == lob::Side::Buy ? asks_ : bids_;
+        while (qty > 0 && !side.empty()) {
+            auto lv = taker == lob::Side::Buy ? side.begin() : std::prev(side.end());
+            const int64_t px = lv->first;
+            if (taker == lob::Side::Buy ? px > limit : px < limit) break;
+            Fifo& f = lv->second;
+            while (qty > 0 && !f.empty()) {
+                auto& o = f.front();
+                const int64_t take = std::min(qty, o.second);
+                o.second -= take;
+                qty -= take;
+                ex.filled += take;
+                ex.notional += take * px;
+                if (o.second == 0) {
+                    orders_.erase(o.first);
+                    f.pop_front();
+                }
+            }
+            if (f.empty()) side.erase(lv);
+        }
+        return ex;
+    }
+
+    Levels bids_, asks_;
+    std::unordered_map<uint64_t, Entry> orders_;
+    uint64_t next_id_ = 0;
+};
+
+// --- Workload
+// One operation per index: 50% limit adds (5% of them marketable), 30% cancels,
+// 10% modifies (quantity down in place, or a one-tick price move), 10% market
+// orders. Adds turn into cancels while the book holds kDepth orders or more, so
+// its size stays stationary. Prices are placed relative to the current touch,
+// within 20 ticks of it, around 100,000 ticks when a side is empty. Random words
+// come from ctr::Stream so a run is reproducible.
+
+enum class OpType : uint8_t { Add, Cancel, Modify, Market };
+
+struct Op {
+    OpType type;
+    lob::Side side;
+    int64_t px;
+    int64_t qty;
+};
+
+static constexpr int64_t kMid = 100000;
+static constexpr size_t kDepth = 20000;
+
+struct Workload {
+    std::vector<uint32_t> words;   // 4 per operation
+
+    explicit Workload(size_t n_ops, uint64_t seed) : words(4 * n_ops) {
+        ctr::for_blocks(words.size(), 0, [&](uint32_t b, size_t t0, size_t t1) {
+            ctr::Stream rng(seed, 0, b);
+            for (size_t i = t0; i < t1; ++i) words[i] = rng.next_u32();
+        });
+    }
+
+    // Operation k against the current touch.
+    Op op(size_t k, int64_t bid, int64_t ask, int64_t last_px, size_t resting) const {
+        const uint32_t* w = &words[4 * k];
+        Op o;
+        const uint32_t r = w[0] % 100;
+        o.side = (w[0] >> 8) & 1 ? lob::Side::Sell : lob::Side::Buy;
+        const int64_t off = w[1] % 20;
+        const int64_t ref_bid = bid != lob::kNoBid ? bid : (ask != lob::kNoAsk ? ask - 1 : kMid);
+        const int64_t ref_ask = ask != lob::kNoAsk ? ask : ref_bid + 1;
+        if (r < 50 && resting < kDepth) {
+            o.type = OpType::Add;
+            o.qty = 1 + w[2] % 100;
+            const bool marketable = (w[1] >> 16) % 20 == 0;
+            if (o.side == lob::Side::Buy) o.px = marketable ? ref_ask + off / 4 : ref_ask - 1 - off;
+            else                          o.px = marketable ? ref_bid - off / 4 : ref_bid + 1 + off;
+        } else if (r < 80) {
+            o.type = OpType::Cancel;   // (and adds on a full book)
+        } else if (r < 90) {
+            o.type = OpType::Modify;
+            const bool move = (w[1] >> 16) % 2 == 0;
+            o.qty = 1 + w[2] % 100;
+            o.px = last_px + (move ? ((w[2] >> 16) & 1 ? 1 : -1) : 0);
+        } else {
+            o.type = OpType::Market;
+            o.qty = 1 + w[2] % 200;
+        }
+        return o;
+    }
+};
+
+// Runs the workload on a book. `ids` holds live (or recently filled) order IDs;
+// cancels and modifies pick one of them, and dead IDs are dropped when picked.
+template <class BookT, class Id>
+struct Driver {
+    BookT& book;
+    std::vector<Id> ids;
+    std::vector<int64_t> prices;   // price each ID was last placed at
+    uint64_t filled = 0, notional = 0, rejected = 0;
+
+    Driver(BookT& b, size_t cap) : book(b) {
+        ids.reserve(cap);
+        prices.reserve(cap);
+    }
+
+    void drop(size_t j) {
+        ids[j] = ids.back();
+        prices[j] = prices.back();
+        ids.pop_back();
+        prices.pop_back();
+    }
+};
+
+static void record(uint64_t& filled, uint64_t& notional, const lob::Exec& ex) {
+    filled += (uint64_t)ex.filled;
+    notional += (uint64_t)ex.notional;
+}
+
+// One operation on lob::Book.
+static void step(Driver<lob::Book, lob::OrderId>& d, const Workload& w, size_t k) {
+    lob::Book& b = d.book;
+    const size_t j0 = d.ids.empty() ? 0 : w.words[4 * k + 3] % d.ids.size();
+    const Op o = w.op(k, b.best_bid(), b.best_ask(), d.ids.empty() ? kMid : d.prices[j0], b.order_count());
+    auto fill = [&](lob::OrderId, int64_t px, int64_t q) { d.filled += (uint64_t)q; d.notional += (uint64_t)(px * q); };
+    switch (o.type) {
+        case OpType::Add: {
+            lob::OrderId id = b.add(o.side, o.px, o.qty, fill);
+            if (id != lob::kNoOrder && d.ids.size() < d.ids.capacity()) { d.ids.push_back(id); d.prices.push_back(o.px); }
+            break;
+        }
+        case OpType::Cancel:
+            if (d.ids.empty()) break;
+            if (!b.cancel(d.ids[j0])) d.rejected++;
+            d.drop(j0);
+            break;
+        case OpType::Modify:
+            if (d.ids.empty()) break;
+            if (!b.modify(d.ids[j0], o.px, o.qty, fill)) { d.rejected++; d.drop(j0); break; }
+            if (b.find(d.ids[j0])) d.prices[j0] = o.px;
+            else d.drop(j0);
+            break;
+        case OpType::Market:
+            b.market(o.side, o.qty, fill);
+            break;
+    }
+}
+
+// The same operation on the reference book.
+static void step(Driver<RefBook, uint64_t>& d, const Workload& w, size_t k) {
+    RefBook& b = d.book;
+    const size_t j0 = d.ids.empty() ? 0 : w.words[4 * k + 3] % d.ids.size();
+    const Op o = w.op(k, b.best_bid(), b.best_ask(), d.ids.empty() ? kMid : d.prices[j0], b.order_count());
+    lob::Exec ex;
+    switch (o.type) {
+        case OpType::Add: {
+            uint64_t id = b.add(o.side, o.px, o.qty, ex);
+            record(d.filled, d.notional, ex);
+            if (id != 0 && d.ids.size() < d.ids.capacity()) { d.ids.push_back(id); d.prices.push_back(o.px); }
+            break;
+        }
+        case OpType::Cancel:
+            if (d.ids.empty()) break;
+            if (!b.cancel(d.ids[j0])) d.rejected++;
+            d.drop(j0);
+            break;
+        case OpType::Modify: {
+            if (d.ids.empty()) break;
+            bool ok = b.modify(d.ids[j0], o.px, o.qty, ex);
+            record(d.filled, d.notional, ex);
+            if (!ok) { d.rejected++; d.drop(j0); break; }
+            if (ex.filled < o.qty) d.prices[j0] = o.px;   // still resting
+            else d.drop(j0);
+            break;
+        }
+        case OpType::Market:
+            record(d.filled, d.notional, b.market(o.side, o.qty));
+            break;
+    }
+}
+
+// --- Modes
+
+static int bench(size_t n_ops) {
+    const size_t cap = 1 << 20;
+    std::cout << "Generating " << n_ops << " operations\n";
+    Workload w(n_ops, 42);
+    std::cout << std::fixed << std::setprecision(1);
+
+    lob::Book book(cap);
+    book.reserve_prices(kMid - 4096, kMid + 4096);
+    Driver<lob::Book, lob::OrderId> d(book, cap);
+    const size_t warm = std::min<size_t>(n_ops / 10, 1000000);
+    for (size_t k = 0; k < warm; ++k) step(d, w, k);
+    uint64_t a0 = g_allocs.load();
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t k = warm; k < n_ops; ++k) step(d, w, k);
+    double secs = seconds_since(t0);
+    uint64_t allocs = g_allocs.load() - a0;
+    const double rate = (n_ops - warm) / secs / 1e6;
+    std::cout << "lob::Book (tick ladder + order pool): " << rate << " M ops/s, "
+              << allocs << " heap allocations after warm-up, " << book.order_count() << " resting orders, best "
+              << book.best_bid() << " / " << book.best_ask() << "\n";
+
+    RefBook ref;
+    Driver<RefBook, uint64_t> r(ref, cap);
+    for (size_t k = 0; k < warm; ++k) step(r, w, k);
+    a0 = g_allocs.load();
+    t0 = std::chrono::steady_clock::now();
+    for (size_t k = warm; k < n_ops; ++k) step(r, w, k);
+    double ref_secs = seconds_since(t0);
+    allocs = g_allocs.load() - a0;
+    std::cout << "std::map + std::list + unordered_map:  " << (n_ops - warm) / ref_secs / 1e6 << " M ops/s, "
+              << allocs << " heap allocations (x" << std::setprecision(2) << ref_secs / secs << " slower)\n";
+
+    const bool same = d.filled == r.filled && d.notional == r.notional && book.best_bid() == ref.best_bid() &&
+                      book.best_ask() == ref.best_ask() && book.order_count() == ref.order_count();
+    std::cout << "Same executions and final book: " << (same ? "yes" : "NO") << "\n";
+    return same ? 0 : 1;
+}
+
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            failures++;
+            std::cout << "FAILED: " << what << "\n";
+        }
+    };
+    using lob::Side;
+
+    // FIFO priority, partial fills, level removal
+    {
+        lob::Book b;
+        lob::OrderId a = b.add(Side::Sell, 101, 5), c = b.add(Side::Sell, 101, 7), e = b.add(Side::Sell, 103, 4);
+        b.add(Side::Buy, 99, 10);
+        expect(b.best_bid() == 99 && b.best_ask() == 101, "touch after adds");
+        std::vector<std::pair<lob::OrderId, int64_t>> fills;
+        lob::Exec ex = b.market(Side::Buy, 8, [&](lob::OrderId id, int64_t px, int64_t q) {
+            fills.push_back({id, q});
+            expect(px == 101, "fill price");
+        });
+        expect(ex.filled == 8 && ex.notional == 808, "market fill totals");
+        expect(fills.size() == 2 && fills[0] == std::make_pair(a, (int64_t)5) && fills[1] == std::make_pair(c, (int64_t)3),
+               "fills in time priority");
+        expect(!b.find(a) && b.find(c) && b.find(c)->qty == 4, "partially filled order stays");
+        ex = b.market(Side::Buy, 10);
+        expect(ex.filled == 8 && b.best_ask() == lob::kNoAsk && !b.find(e), "sweep through levels");
+        expect(b.order_count() == 1, "order count");
+        expect(!b.cancel(a) && !b.modify(c, 101, 1), "dead IDs are misses");
+    }
+
+    // modify: decrease keeps priority, increase and price change re-queue
+    {
+        lob::Book b;
+        lob::OrderId x = b.add(Side::Buy, 50, 10), y = b.add(Side::Buy, 50, 10);
+        b.modify(x, 50, 6);
+        std::vector<lob::OrderId> q;
+        b.for_each_order(Side::Buy, 50, [&](lob::OrderId id, int64_t) { q.push_back(id); });
+        expect(q.size() == 2 && q[0] == x && b.depth(Side::Buy, 50) == 16, "decrease keeps place");
+        b.modify(x, 50, 20);
+        q.clear();
+        b.for_each_order(Side::Buy, 50, [&](lob::OrderId id, int64_t) { q.push_back(id); });
+        expect(q.size() == 2 && q[0] == y && q[1] == x && b.depth(Side::Buy, 50) == 30, "increase loses place");
+        expect(b.newest(Side::Buy, 50) == x && b.newest(Side::Buy, 51) == lob::kNoOrder, "newest order of a level");
+        b.modify(y, 52, 10);
+        expect(b.best_bid() == 52 && b.depth(Side::Buy, 50) == 20 && b.find(y)->price == 52, "price change");
+        b.add(Side::Sell, 55, 3);
+        b.modify(y, 56, 10);   // crosses: takes 3 at 55, rests 7 at 56
+        expect(b.best_ask() == lob::kNoAsk && b.best_bid() == 56 && b.find(y)->qty == 7, "crossing modify");
+        expect(b.cancel(y) && b.best_bid() == 50, "cancel at touch falls back");
+    }
+
+    // marketable limit rests its remainder; far prices grow the ladder
+    {
+        lob::Book b;
+        b.add(Side::Sell, 100, 5);
+        b.add(Side::Sell, 102, 5);
+        lob::OrderId id = b.add(Side::Buy, 101, 8);
+        expect(b.find(id) && b.find(id)->qty == 3 && b.best_bid() == 101 && b.best_ask() == 102, "limit rests remainder");
+        b.add(Side::Sell, 1000000, 1);
+        b.add(Side::Buy, -1000000, 1);
+        int64_t px[4], qty[4];
+        expect(b.top_levels(Side::Sell, 4, px, qty) == 2 && px[1] == 1000000, "top levels across a grown ladder");
+        expect(b.top_levels(Side::Buy, 4, px, qty) == 2 && px[0] == 101 && qty[0] == 3 && px[1] == -1000000,
+               "negative prices");
+    }
+
+    // random workload: lob::Book against the map / list reference, step by step
+    {
+        const size_t n = 400000;
+        Workload w(n, 7);
+        lob::Book book(1024);   // small pool: exercises growth
+        RefBook ref;
+        Driver<lob::Book, lob::OrderId> d(book, 1 << 16);
+        Driver<RefBook, uint64_t> r(ref, 1 << 16);
+        bool same = true;
+        size_t k = 0;
+        for (; k < n && same; ++k) {
+            step(d, w, k);
+            step(r, w, k);
+            same = d.filled == r.filled && d.notional == r.notional && d.rejected == r.rejected &&
+                   book.best_bid() == ref.best_bid() && book.best_ask() == ref.best_ask() &&
+                   book.order_count() == ref.order_count() && d.ids.size() == r.ids.size();
+            if (same && k % 97 == 0) {
+                int64_t px[10], qty[10];
+                for (Side s : {Side::Buy, Side::Sell}) {
+                    int m = book.top_levels(s, 10, px, qty);
+                    for (int i = 0; i < m; ++i) same = same && qty[i] == ref.depth(s, px[i]);
+                    if (m > 0) {
+                        std::vector<int64_t> q;
+                        book.for_each_order(s, px[0], [&](lob::OrderId, int64_t v) { q.push_back(v); });
+                        same = same && q == ref.queue(s, px[0]);
+                    }
+                }
+            }
+        }
+        expect(same, "random workload vs reference book (diverged at op " + std::to_string(k - 1) + ")");
+        std::cout << "Random workload vs std::map reference: " << n << " ops, " << book.order_count()
+                  << " resting, " << d.filled << " filled: " << (same ? "identical" : "DIVERGED") << "\n";
+
+        // warm book: no heap allocation per operation
+        const uint64_t a0 = g_allocs.load();
+        for (size_t k2 = 0; k2 < n; ++k2) step(d, w, k2);
+        const uint64_t allocs = g_allocs.load() - a0;
+        std::cout << "Heap allocations over " << n << " more ops on the warm book: " << allocs << "\n";
+        expect(allocs == 0, "allocation-free hot path");
+    }
+
+    std::cout << (failures == 0 ? "Order book check: OK" : "Order book check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "bench") return bench(util::arg_u64(argc, argv, "n", 20000000));
+    if (mode == "check") return run_check();
+    std::cerr << "usage: book_bench bench [n=20000000] | book_bench check\n";
+    return 1;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+// Calendar queue: priority queue of timed events for discrete-event simulation
+// (R. Brown, "Calendar queues: a fast O(1) priority queue implementation for the
+// simulation event set problem", CACM 31(10), 1988). Header-only.
+//
+// Time is cut into "days" of `width`; day d goes to bucket d mod n_buckets, and
+// each bucket keeps its events sorted by (time, insertion sequence). pop() walks
+// the buckets day by day from the current one and takes the head of a bucket when
+// it belongs to the current day, so with the width set to a few mean gaps between
+// events, push and pop touch O(1) events each, whatever the number pending.
+// The bucket count doubles / halves when the size crosses 2x / 0.5x of it, and
+// the width is re-estimated from the gaps between the earliest events.
+//
+// Events with equal times come out in insertion order. Nodes live in one pool
+// with a free list and are chained by index, so a warm queue does not allocate.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace cq {
+
+template <class T>
+class CalendarQueue {
+public:
+    explicit CalendarQueue(size_t capacity = 1024, double width = 1.0) : width_(width), inv_width_(1.0 / width) {
+        pool_.reserve(capacity);
+        heads_.assign(kMinBuckets, kNil);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t buckets() const { return heads_.size(); }
+    double width() const { return width_; }
+
+    void clear() {
+        pool_.clear();
+        free_ = kNil;
+        size_ = 0;
+        heads_.assign(kMinBuckets, kNil);
+        day_ = 0;
+        cur_ = 0;
+    }
+
+    void push(double t, const T& item) {
+        uint32_t i;
+        if (free_ != kNil) {
+            i = free_;
+            free_ = pool_[i].next;
+        } else {
+            i = (uint32_t)pool_.size();
+            pool_.emplace_back();
+        }
+        Node& n = pool_[i];
+        n.t = t;
+        n.seq = seq_++;
+        n.item = item;
+        n.day = day_of(t);
+        if (size_ == 0 || n.day < day_) {   // first event, or one earlier than the current day
+            day_ = n.day;
+            cur_ = (size_t)(day_ & mask());
+        }
+        insert(i);
+        if (++size_ > 2 * heads_.size()) resize(2 * heads_.size());
+    }
+
+    // Time of the earliest event, left in the queue; false if the queue is empty.
+    bool top(double& t) {
+        if (size_ == 0) return false;
+        t = pool_[earliest()].t;
+        return true;
+    }
+
+    // Removes the earliest event; false if the queue is empty.
+    bool pop(double& t, T& item) {
+        if (size_ == 0) return false;
+        const uint32_t i = earliest();
+        Node& n = pool_[i];
+        heads_[cur_] = n.next;
+        t = n.t;
+        item = n.item;
+        n.next = free_;
+        free_ = i;
+        if (--size_ < heads_.size() / 2 && heads_.size() > kMinBuckets) resize(heads_.size() / 2);
+        return true;
+    }
+
+private:
+    static constexpr uint32_t kNil = 0xFFFFFFFFu;
+    static constexpr size_t kMinBuckets = 16;
+    static constexpr size_t kSample = 32;   // earliest events used to size the day
+
+    struct Node {
+        double t = 0.0;
+        uint64_t seq = 0;
+        uint64_t day = 0;
+        T item{};
+        uint32_t next = kNil;
+    };
+
+    static bool before(const Node& a, const Node& b) { return a.t < b.t || (a.t == b.t && a.seq < b.seq); }
+
+    uint64_t mask() const { return heads_.size() - 1; }
+    uint64_t day_of(double t) const { return (uint64_t)std::max(0.0, t * inv_width_); }
+
+    // Advances the current day to the earliest event's and returns its node,
+    // which is the head of bucket cur_. The queue must not be empty.
+    uint32_t earliest() {
+        const size_t nb = heads_.size();
+        for (size_t k = 0; k < nb; ++k) {
+            const uint32_t h = heads_[cur_];
+            if (h != kNil && pool_[h].day <= day_) return h;
+            cur_ = (cur_ + 1) & mask();
+            ++day_;
+        }
+        // nothing within a whole year: jump to the earliest event
+        uint32_t i = kNil;
+        for (uint32_t h : heads_)
+            if (h != kNil && (i == kNil || before(pool_[h], pool_[i]))) i = h;
+        day_ = pool_[i].day;
+        cur_ = (size_t)(day_ & mask());
+        return i;
+    }
+
+    // Sorted insert of node i into its bucket.
+    void insert(uint32_t i) {
+        uint32_t* link = &heads_[(size_t)(pool_[i].day & mask())];
+        while (*link != kNil && !before(pool_[i], pool_[*link])) link = &pool_[*link].next;
+        pool_[i].next = *link;
+        *link = i;
+    }
+
+    // Rebuilds the calendar with nb buckets and a width of 3 mean gaps between
+    // the earliest events (Brown's rule).
+    void resize(size_t nb) {
+        live_.clear();
+        for (uint32_t h : heads_)
+            for (uint32_t i = h; i != kNil; i = pool_[i].next) live_.push_back(i);
+        auto earlier = [&](uint32_t a, uint32_t b) { return before(pool_[a], pool_[b]); };
+        const size_t k = std::min(live_.size(), kSample);
+        std::partial_sort(live_.begin(), live_.begin() + k, live_.end(), earlier);
+        if (k >= 2) {
+            const double span = pool_[live_[k - 1]].t - pool_[live_[0]].t;
+            if (span > 0.0) {
+                width_ = 3.0 * span / (double)(k - 1);
+                inv_width_ = 1.0 / width_;
+            }
+        }
+
+        heads_.assign(nb, kNil);
+        for (uint32_t i : live_) {
+            pool_[i].day = day_of(pool_[i].t);
+            insert(i);
+        }
+        if (!live_.empty()) {
+            day_ = pool_[live_[0]].day;
+            cur_ = (size_t)(day_ & mask());
+        }
+    }
+
+    std::vector<Node> pool_;
+    std::vector<uint32_t> heads_;
+    std::vector<uint32_t> live_;   // resize scratch
+    uint32_t free_ = kNil;
+    size_t size_ = 0;
+    uint64_t seq_ = 0;
+    double width_, inv_width_;
+    uint64_t day_ = 0;             // current day
+    size_t cur_ = 0;               // its bucket
+};
+
+} // namespace cq
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "columnar.hpp"
+#include "util.hpp"
+
+// Sum of a column through its typed view (forces every page of the column in).
+static double column_sum(const col::Reader& r, int c) {
+    const std::string name = r.name(c);
+    double s = 0.0;
+    switch (r.type(c)) {
+        case col::Type::F64: for (double v : r.column<double>(name)) s += v; break;
+        case col::Type::F32: for (float v : r.column<float>(name)) s += v; break;
+        case col::Type::I64: for (int64_t v : r.column<int64_t>(name)) s += (double)v; break;
+        case col::Type::I32: for (int32_t v : r.column<int32_t>(name)) s += v; break;
+        case col::Type::I16: for (int16_t v : r.column<int16_t>(name)) s += v; break;
+        case col::Type::I8:  for (int8_t v : r.column<int8_t>(name)) s += v; break;
+        case col::Type::U8:  for (uint8_t v : r.column<uint8_t>(name)) s += v; break;
+    }
+    return s;
+}
+
+// Schema, chunk index summary and a full scan of every column.
+static int inspect(const std::string& path) {
+    auto t0 = std::chrono::steady_clock::now();
+    col::Reader r;
+    if (!r.open(path)) {
+        std::cerr << r.error() << "\n";
+        return 1;
+    }
+    double t_open = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << path << ": " << r.rows() << " rows, " << r.columns() << " columns, "
+              << r.chunks() << " chunks of " << r.chunk_rows() << " rows (open " << std::fixed
+              << std::setprecision(6) << t_open << "s)\n\n";
+    std::cout << std::setw(14) << "column" << std::setw(6) << "type" << std::setw(14) << "offset"
+              << std::setw(16) << "min" << std::setw(16) << "max" << std::setw(22) << "sum" << std::setw(10) << "scan s" << "\n";
+
+    uint64_t bytes = 0;
+    double t_scan = 0.0;
+    for (int c = 0; c < r.columns(); ++c) {
+        double lo = NAN, hi = NAN;
+        for (uint32_t k = 0; k < r.chunks(); ++k) {
+            const col::ChunkStats& st = r.stats(k, c);
+            if (std::isnan(st.min)) continue;   // all-NaN chunk
+            lo = std::isnan(lo) ? st.min : std::min(lo, st.min);
+            hi = std::isnan(hi) ? st.max : std::max(hi, st.max);
+        }
+        t0 = std::chrono::steady_clock::now();
+        double s = column_sum(r, c);
+        double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        t_scan += dt;
+        bytes += r.desc(c).bytes;
+        std::cout << std::setw(14) << r.name(c) << std::setw(6) << col::type_name(r.type(c))
+                  << std::setw(14) << r.desc(c).offset
+                  << std::setprecision(4) << std::setw(16) << lo << std::setw(16) << hi
+                  << std::setw(22) << s << std::setw(10) << dt << "\n";
+    }
+    std::cout << "\nScanned " << std::setprecision(1) << bytes / 1e6 << " MB in " << std::setprecision(4) << t_scan
+              << "s (" << std::setprecision(2) << bytes / 1e9 / std::max(t_scan, 1e-12) << " GB/s)\n";
+    return 0;
+}
+
+// Write n synthetic ticks (t, price, size), then map the file and scan it.
+static int bench(const std::string& path, uint64_t n) {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> N(0.0, 1.0);
+
+    auto t0 = std::chrono::steady_clock::now();
+    col::Writer w;
+    if (!w.open(path, {{"t", col::Type::I64}, {"price", col::Type::F64}, {"size", col::Type::I32}}, n)) {
+        std::cerr << w.error() << "\n";
+        return 1;
+    }
+    double price = 100.0;
+    for (uint64_t i = 0; i < n; ++i) {
+        price *= std::exp(1e-4 * N(rng));
+        w.append((int64_t)i, price, (int32_t)(1 + (i * 2654435761u) % 100));
+    }
+    if (!w.close()) {
+        std::cerr << w.error() << "\n";
+        return 1;
+    }
+    double t_write = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Wrote " << n << " ticks in " << std::fixed << std::setprecision(3) << t_write << "s\n";
+    return inspect(path);
+}
+
+// --- Round-trip check
+
+static bool same(double a, double b) { return (std::isnan(a) && std::isnan(b)) || a == b; }
+
+// Values read back equal the ones appended, and every chunk's min/max equals
+// the range of its non-NaN values (NaN/NaN for an all-NaN chunk).
+template <class T>
+static bool check_column(const col::Reader& r, const std::string& name, const std::vector<T>& ref) {
+    col::View<T> v = r.column<T>(name);
+    if (!v || v.size != ref.size()) return false;
+    for (size_t i = 0; i < ref.size(); ++i)
+        if (!same((double)v[i], (double)ref[i])) return false;
+    const int c = r.find(name);
+    for (uint32_t k = 0; k < r.chunks(); ++k) {
+        double lo = NAN, hi = NAN;
+        for (uint64_t i = r.chunk_begin(k); i < r.chunk_end(k); ++i) {
+            double x = (double)ref[i];
+            if (std::isnan(x)) continue;
+            lo = std::isnan(lo) ? x : std::min(lo, x);
+            hi = std::isnan(hi) ? x : std::max(hi, x);
+        }
+        if (!same(r.stats(k, c).min, lo) || !same(r.stats(k, c).max, hi)) return false;
+    }
+    return true;
+}
+
+// One column of every type over three chunks (the last one partial). The f64
+// column starts its first two chunks with NaN and is all NaN in the third.
+static int run_check() {
+    int failures = 0;
+    auto report = [&](const std::string& what, bool ok) {
+        if (!ok) failures++;
+        std::cout << what << ": " << (ok ? "exact" : "MISMATCH") << "\n";
+    };
+
+    const uint32_t chunk = 1000;
+    const size_t n = 2500;
+    std::mt19937_64 rng(3);
+    std::normal_distribution<double> N(0.0, 1.0);
+    std::vector<double> f64(n);
+    std::vector<float> f32(n);
+    std::vector<int64_t> i64(n);
+    std::vector<int32_t> i32(n);
+    std::vector<int16_t> i16(n);
+    std::vector<int8_t> i8(n);
+    std::vector<uint8_t> u8(n);
+    for (size_t i = 0; i < n; ++i) {
+        f64[i] = (i == 0 || i == chunk || i >= 2 * chunk || i % 97 == 5) ? NAN : 100.0 + N(rng);
+        f32[i] = (i == chunk + 1) ? NAN : (float)N(rng);
+        i64[i] = (i == 7) ? INT64_MAX : (i == 8) ? INT64_MIN : (int64_t)rng();
+        i32[i] = (int32_t)rng();
+        i16[i] = (int16_t)rng();
+        i8[i] = (int8_t)rng();
+        u8[i] = (uint8_t)rng();
+    }
+
+    const std::string path = "col_inspect_check.col";
+    col::Writer w;
+    bool ok = w.open(path, {{"f64", col::Type::F64}, {"f32", col::Type::F32}, {"i64", col::Type::I64},
+                            {"i32", col::Type::I32}, {"i16", col::Type::I16}, {"i8", col::Type::I8},
+                            {"u8", col::Type::U8}}, n, chunk);
+    for (size_t i = 0; ok && i < n; ++i) ok = w.append(f64[i], f32[i], i64[i], i32[i], i16[i], i8[i], u8[i]);
+    ok = w.close() && ok;
+    report("write", ok);
+
+    col::Reader r;
+    ok = ok && r.open(path) && r.rows() == n && r.columns() == 7 && r.chunks() == 3;
+    report("reopen", ok);
+    if (ok) {
+        report("f64 values + chunk stats (NaN-leading and all-NaN chunks)", check_column(r, "f64", f64));
+        report("f32 values + chunk stats", check_column(r, "f32", f32));
+        // int64 values are compared through double above; check the bits too
+        col::View<int64_t> v = r.column<int64_t>("i64");
+        report("i64 values + chunk stats", check_column(r, "i64", i64) && std::equal(v.begin(), v.end(), i64.begin()));
+        report("i32 values + chunk stats", check_column(r, "i32", i32));
+        report("i16 values + chunk stats", check_column(r, "i16", i16));
+        report("i8 values + chunk stats", check_column(r, "i8", i8));
+        report("u8 values + chunk stats", check_column(r, "u8", u8));
+    }
+    r.close();
+    std::remove(path.c_str());
+
+    std::cout << "Columnar check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "check") return run_check();
+    if (mode == "bench")
+        return bench(util::arg_string(argc, argv, "path", "ticks.col"), util::arg_u64(argc, argv, "n", 10000000));
+    if (!mode.empty()) return inspect(mode);
+
+    std::cerr << "Usage: col_inspect FILE | col_inspect bench [n=10000000] [path=ticks.col] | col_inspect check\n";
+    return 1;
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+// Columnar binary market-data files (.col), shared by the generators (writers)
+// and the strategies (readers). Header-only, POSIX (open / pwrite / mmap).
+//
+// Layout (little-endian, offsets from the start of the file):
+//   [0, 64)                   FileHeader
+//   [64, 64 + 64 * n_cols)    ColumnDesc[n_cols]            (schema)
+//   index_offset              ChunkStats[n_chunks][n_cols]  (min / max per chunk and column)
+//   desc.offset               column data: n_rows fixed-width values, 4096-byte aligned
+//
+// Each column is one contiguous array, so a reader maps the file once and hands
+// out typed pointers straight into the mapping: loading costs page faults, not
+// parsing. Rows are grouped in chunks of chunk_rows; the chunk index lets readers
+// skip chunks whose value range cannot match.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace col {
+
+enum class Type : uint8_t { F64 = 1, F32, I64, I32, I16, I8, U8 };
+
+inline int width(Type t) {
+    switch (t) {
+        case Type::F64: case Type::I64: return 8;
+        case Type::F32: case Type::I32: return 4;
+        case Type::I16: return 2;
+        default: return 1;
+    }
+}
+
+inline const char* type_name(Type t) {
+    switch (t) {
+        case Type::F64: return "f64";
+        case Type::F32: return "f32";
+        case Type::I64: return "i64";
+        case Type::I32: return "i32";
+        case Type::I16: return "i16";
+        case Type::I8:  return "i8";
+        case Type::U8:  return "u8";
+    }
+    return "?";
+}
+
+template <class T> struct type_of;
+template <> struct type_of<double>  { static constexpr Type value = Type::F64; };
+template <> struct type_of<float>   { static constexpr Type value = Type::F32; };
+template <> struct type_of<int64_t> { static constexpr Type value = Type::I64; };
+template <> struct type_of<int32_t> { static constexpr Type value = Type::I32; };
+template <> struct type_of<int16_t> { static constexpr Type value = Type::I16; };
+template <> struct type_of<int8_t>  { static constexpr Type value = Type::I8; };
+template <> struct type_of<uint8_t> { static constexpr Type value = Type::U8; };
+
+constexpr char kMagic[8] = {'A', 'T', 'S', 'C', 'O', 'L', '1', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t n_cols;
+    uint64_t n_rows;
+    uint32_t chunk_rows;
+    uint32_t n_chunks;
+    uint64_t index_offset;
+    uint64_t file_bytes;
+    char     reserved[16];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader must be 64 bytes");
+
+struct ColumnDesc {
+    char     name[40];
+    uint8_t  type;
+    uint8_t  width;
+    uint8_t  reserved[6];
+    uint64_t offset;   // file offset of the first value
+    uint64_t bytes;    // n_rows * width
+};
+static_assert(sizeof(ColumnDesc) == 64, "ColumnDesc must be 64 bytes");
+
+// NaN values are left out; an all-NaN chunk has min = max = NaN.
+struct ChunkStats {
+    double min, max;
+};
+
+struct Field {
+    std::string name;
+    Type type;
+};
+
+inline uint64_t align_up(uint64_t x, uint64_t a) { return (x + a - 1) / a * a; }
+
+// --- Writer: the row count is declared up front (every generator knows T), so the
+// whole layout is fixed at open(). Rows are buffered one chunk at a time per
+// column and written at their final offsets; header and index are written by
+// close(). Writing fewer rows than declared is allowed (the header records the
+// actual count).
+class Writer {
+public:
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer() { close(); }
+
+    bool open(const std::string& path, const std::vector<Field>& schema, uint64_t n_rows,
+              uint32_t chunk_rows = 65536) {
+        close();
+        error_.clear();
+        if (schema.empty() || chunk_rows == 0) return fail("empty schema or chunk size");
+        for (const auto& f : schema)
+            if (f.name.empty() || f.name.size() >= sizeof(ColumnDesc::name)) return fail("bad column name: " + f.name);
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) return fail("cannot create " + path);
+
+        schema_ = schema;
+        cap_rows_ = n_rows;
+        chunk_rows_ = chunk_rows;
+        n_chunks_ = (uint32_t)((n_rows + chunk_rows - 1) / chunk_rows);
+        rows_ = 0;
+
+        const size_t nc = schema.size();
+        index_offset_ = align_up(sizeof(FileHeader) + nc * sizeof(ColumnDesc), 64);
+        uint64_t off = align_up(index_offset_ + (uint64_t)n_chunks_ * nc * sizeof(ChunkStats), 4096);
+        desc_.assign(nc, ColumnDesc{});
+        for (size_t c = 0; c < nc; ++c) {
+            ColumnDesc& d = desc_[c];
+            std::memcpy(d.name, schema[c].name.data(), schema[c].name.size());
+            d.type = (uint8_t)schema[c].type;
+            d.width = (uint8_t)width(schema[c].type);
+            d.offset = off;
+            d.bytes = n_rows * d.width;
+            off = align_up(off + d.bytes, 4096);
+        }
+        file_bytes_ = off;
+        if (::ftruncate(fd_, (off_t)file_bytes_) != 0) return fail("cannot size " + path);
+
+        buf_.assign(nc, std::vector<unsigned char>());
+        for (size_t c = 0; c < nc; ++c) buf_[c].resize((size_t)chunk_rows * desc_[c].width);
+        stats_.assign((size_t)n_chunks_ * nc, ChunkStats{0.0, 0.0});
+        in_chunk_ = 0;
+        return true;
+    }
+
+    bool ok() const { return fd_ >= 0 && error_.empty(); }
+    const std::string& error() const { return error_; }
+    uint64_t rows() const { return rows_; }
+
+    // Append one row, values in schema order (converted to the column types).
+    template <class... Ts>
+    bool append(const Ts&... v) {
+        if (fd_ < 0 || sizeof...(Ts) != schema_.size()) return fail("append: writer closed or arity mismatch");
+        if (rows_ >= cap_rows_) return fail("append: more rows than declared");
+        size_t c = 0;
+        (put(c++, v), ...);
+        ++rows_;
+        if (++in_chunk_ == chunk_rows_) flush_chunk();
+        return error_.empty();
+    }
+
+    bool close() {
+        if (fd_ < 0) return error_.empty();
+        if (in_chunk_ > 0) flush_chunk();
+
+        FileHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.n_cols = (uint32_t)desc_.size();
+        h.n_rows = rows_;
+        h.chunk_rows = chunk_rows_;
+        h.n_chunks = (uint32_t)((rows_ + chunk_rows_ - 1) / chunk_rows_);
+        h.index_offset = index_offset_;
+        h.file_bytes = file_bytes_;
+        for (auto& d : desc_) d.bytes = rows_ * d.width;
+
+        write_at(&h, sizeof(h), 0);
+        write_at(desc_.data(), desc_.size() * sizeof(ColumnDesc), sizeof(FileHeader));
+        write_at(stats_.data(), (size_t)h.n_chunks * desc_.size() * sizeof(ChunkStats), index_offset_);
+        ::close(fd_);
+        fd_ = -1;
+        return error_.empty();
+    }
+
+private:
+    template <class V>
+    void put(size_t c, const V& v) {
+        unsigned char* dst = buf_[c].data() + (size_t)in_chunk_ * desc_[c].width;
+        double as_double = 0.0;
+        switch ((Type)desc_[c].type) {
+            case Type::F64: { double  x = (double)v;  std::memcpy(dst, &x, 8); as_double = x; break; }
+            case Type::F32: { float   x = (float)v;   std::memcpy(dst, &x, 4); as_double = x; break; }
+            case Type::I64: { int64_t x = (int64_t)v; std::memcpy(dst, &x, 8); as_double = (double)x; break; }
+            case Type::I32: { int32_t x = (int32_t)v; std::memcpy(dst, &x, 4); as_double = x; break; }
+            case Type::I16: { int16_t x = (int16_t)v; std::memcpy(dst, &x, 2); as_double = x; break; }
+            case Type::I8:  { int8_t  x = (int8_t)v;  std::memcpy(dst, &x, 1); as_double = x; break; }
+            case Type::U8:  { uint8_t x = (uint8_t)v; std::memcpy(dst, &x, 1); as_double = x; break; }
+        }
+        ChunkStats& s = stats_[(size_t)(rows_ / chunk_rows_) * desc_.size() + c];
+        if (in_chunk_ == 0) s = {NAN, NAN};
+        if (std::isnan(as_double)) return;
+        if (std::isnan(s.min)) s = {as_double, as_double};
+        else { s.min = std::min(s.min, as_double); s.max = std::max(s.max, as_double); }
+    }
+
+    void flush_chunk() {
+        const uint64_t first = (rows_ - 1) / chunk_rows_ * chunk_rows_;
+        for (size_t c = 0; c < desc_.size(); ++c)
+            write_at(buf_[c].data(), (size_t)in_chunk_ * desc_[c].width, desc_[c].offset + first * desc_[c].width);
+        in_chunk_ = 0;
+    }
+
+    void write_at(const void* p, size_t n, uint64_t off) {
+        const char* src = static_cast<const char*>(p);
+        while (n > 0) {
+            ssize_t w = ::pwrite(fd_, src, n, (off_t)off);
+            if (w <= 0) { fail("write failed"); return; }
+            src += w; n -= (size_t)w; off += (uint64_t)w;
+        }
+    }
+
+    bool fail(const std::string& msg) {
+        if (error_.empty()) error_ = msg;
+        return false;
+    }
+
+    int fd_ = -1;
+    std::string error_;
+    std::vector<Field> schema_;
+    std::vector<ColumnDesc> desc_;
+    std::vector<std::vector<unsigned char>> buf_;   // one chunk per column
+    std::vector<ChunkStats> stats_;                 // [chunk][column]
+    uint64_t cap_rows_ = 0, rows_ = 0, index_offset_ = 0, file_bytes_ = 0;
+    uint32_t chunk_rows_ = 0, n_chunks_ = 0, in_chunk_ = 0;
+};
+
+// --- Reader: zero-copy typed views into a read-only mapping.
+
+template <class T>
+struct View {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T& operator[](size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    explicit operator bool() const { return data != nullptr; }
+};
+
+class Reader {
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+            ::close(fd);
+            return fail(path + ": not a columnar file (too small)");
+        }
+        size_ = (size_t)st.st_size;
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return fail("cannot map " + path);
+        base_ = static_cast<const unsigned char*>(p);
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+
+        hdr_ = reinterpret_cast<const FileHeader*>(base_);
+        if (std::memcmp(hdr_->magic, kMagic, sizeof(kMagic)) != 0 || hdr_->version != kVersion)
+            return fail(path + ": bad magic or version");
+        const uint64_t nc = hdr_->n_cols;
+        if (sizeof(FileHeader) + nc * sizeof(ColumnDesc) > size_ ||
+            hdr_->index_offset + (uint64_t)hdr_->n_chunks * nc * sizeof(ChunkStats) > size_)
+            return fail(path + ": truncated header or index");
+        desc_ = reinterpret_cast<const ColumnDesc*>(base_ + sizeof(FileHeader));
+        stats_ = reinterpret_cast<const ChunkStats*>(base_ + hdr_->index_offset);
+        for (uint64_t c = 0; c < nc; ++c) {
+            const ColumnDesc& d = desc_[c];
+            if (d.width != width((Type)d.type) || d.bytes != hdr_->n_rows * d.width ||
+                d.offset % d.width != 0 || d.offset + d.bytes > size_)
+                return fail(path + ": bad column descriptor");
+        }
+        return true;
+    }
+
+    // Unmaps and forgets any earlier error, so a Reader can be reopened.
+    void close() {
+        if (base_) ::munmap(const_cast<unsigned char*>(base_), size_);
+        error_.clear();
+        base_ = nullptr;
+        hdr_ = nullptr;
+        desc_ = nullptr;
+        stats_ = nullptr;
+        size_ = 0;
+    }
+
+    bool ok() const { return hdr_ != nullptr && error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    uint64_t rows() const { return hdr_->n_rows; }
+    int columns() const { return (int)hdr_->n_cols; }
+    uint32_t chunk_rows() const { return hdr_->chunk_rows; }
+    uint32_t chunks() const { return hdr_->n_chunks; }
+    const ColumnDesc& desc(int c) const { return desc_[c]; }
+    std::string name(int c) const { return std::string(desc_[c].name, strnlen(desc_[c].name, sizeof(desc_[c].name))); }
+    Type type(int c) const { return (Type)desc_[c].type; }
+
+    int find(const std::string& name_) const {
+        for (int c = 0; c < columns(); ++c)
+            if (name(c) == name_) return c;
+        return -1;
+    }
+
+    // Typed view of a whole column; empty if missing or stored with another type.
+    template <class T>
+    View<T> column(const std::string& name_) const {
+        int c = find(name_);
+        if (c < 0 || type(c) != type_of<T>::value) return {};
+        return {reinterpret_cast<const T*>(base_ + desc_[c].offset), (size_t)hdr_->n_rows};
+    }
+
+    const ChunkStats& stats(uint32_t chunk, int c) const { return stats_[(size_t)chunk * hdr_->n_cols + c]; }
+    uint64_t chunk_begin(uint32_t chunk) const { return (uint64_t)chunk * hdr_->chunk_rows; }
+    uint64_t chunk_end(uint32_t chunk) const { return std::min<uint64_t>(chunk_begin(chunk) + hdr_->chunk_rows, hdr_->n_rows); }
+
+private:
+    bool fail(const std::string& msg) {
+        close();
+        error_ = msg;
+        return false;
+    }
+
+    const unsigned char* base_ = nullptr;
+    size_t size_ = 0;
+    const FileHeader* hdr_ = nullptr;
+    const ColumnDesc* desc_ = nullptr;
+    const ChunkStats* stats_ = nullptr;
+    std::string error_;
+};
+
+} // namespace col
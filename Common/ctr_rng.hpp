@@ -0,0 +1,416 @@
+#pragma once
+// Counter-based random numbers for the synthetic generators.
+//
+// Philox4x32-10 (Salmon, Moraes, Dror, Shaw, "Parallel random numbers: as easy
+// as 1, 2, 3", SC 2011) maps a 128-bit counter and a 64-bit key to 128 random
+// bits with 10 rounds of 32 x 32 -> 64 bit multiplies. No state is carried from
+// one call to the next, so every draw is a function of its coordinates:
+//
+//     key     = seed
+//     counter = (i, block, path)    i = index of the 4-word group in the block
+//
+// Generators cut each path into blocks of kStepBlock steps and draw the steps of
+// block b, in order, from ctr::Stream(seed, path, b). Blocks do not depend on
+// each other, so any segment of any path can be produced on its own, and
+// for_blocks() fills them on any number of threads with the same result.
+//
+// Normals are Box-Muller pairs, one per 4-word group. Stream::normals() fills a
+// buffer four groups at a time: Philox on 4 counters, then log / sin / cos as
+// polynomials (fdlibm kernels), all on AVX2 registers when compiled with -mavx2
+// or -march=native. normal() runs the same kernel on one group, so a buffer holds
+// exactly the values of as many normal() calls. exp_batch() is the matching
+// polynomial exp. Builds without AVX2 use scalar versions of the same formulas,
+// which agree with the AVX2 ones to the last bit or two, not bit for bit.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ctr {
+
+constexpr size_t kStepBlock = 1024;   // steps per counter stream
+
+using Counter = std::array<uint32_t, 4>;
+using Key = std::array<uint32_t, 2>;
+
+constexpr uint32_t kPhiloxM0 = 0xD2511F53u, kPhiloxM1 = 0xCD9E8D57u;   // round multipliers
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9u, kPhiloxW1 = 0xBB67AE85u;   // key schedule (Weyl)
+
+inline Counter philox4x32_10(Counter c, Key k) {
+    for (int r = 0; r < 10; ++r) {
+        const uint64_t p0 = (uint64_t)kPhiloxM0 * c[0];
+        const uint64_t p1 = (uint64_t)kPhiloxM1 * c[2];
+        c = {uint32_t(p1 >> 32) ^ c[1] ^ k[0], uint32_t(p1),
+             uint32_t(p0 >> 32) ^ c[3] ^ k[1], uint32_t(p0)};
+        k[0] += kPhiloxW0;
+        k[1] += kPhiloxW1;
+    }
+    return c;
+}
+
+// --- Polynomial kernels (log, sin / cos of 2 pi u, exp)
+
+namespace detail {
+
+// fdlibm e_log.c / k_sin.c / k_cos.c coefficients
+constexpr double kLn2Hi = 6.93147180369123816490e-01, kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kInvLn2 = 1.44269504088896338700e+00;
+constexpr double kSqrt2 = 1.41421356237309504880;
+constexpr double kTwoPi = 6.28318530717958647692;
+constexpr double Lg1 = 6.666666666666735130e-01, Lg2 = 3.999999999940941908e-01,
+                 Lg3 = 2.857142874366239149e-01, Lg4 = 2.222219843214978396e-01,
+                 Lg5 = 1.818357216161805012e-01, Lg6 = 1.531383769920937332e-01,
+                 Lg7 = 1.479819860511658591e-01;
+constexpr double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                 S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                 S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+constexpr double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                 C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                 C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+// exp(r) on |r| <= ln2 / 2: Taylor series to r^13 (truncation < 1e-17 relative)
+constexpr double E[14] = {1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+                          1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800,
+                          1.0 / 479001600, 1.0 / 6227020800.0};
+constexpr double kExpMax = 708.0;   // |x| clamp, keeps 2^k a normal double
+
+inline double fmadd(double a, double b, double c) {
+#if defined(__FMA__)
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+#if defined(__AVX2__)
+
+inline __m256d fmadd(__m256d a, __m256d b, __m256d c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+inline __m256d set(double x) { return _mm256_set1_pd(x); }
+
+// Opaque copy: stops the compiler from fusing the product into the add that
+// follows it (-ffp-contract=fast), which it would do in some inlining contexts
+// and not others, so that every caller of a kernel rounds the same way.
+inline __m256d keep(__m256d v) {
+    __asm__("" : "+x"(v));
+    return v;
+}
+
+// Exact int64 -> double for |x| < 2^51 (no AVX2 conversion instruction).
+inline __m256d small_i64_to_pd(__m256i x) {
+    const __m256d magic = set(6755399441055744.0);   // 1.5 * 2^52
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, _mm256_castpd_si256(magic))), magic);
+}
+
+// log(x), x positive and normal.
+inline __m256d log4(__m256d x) {
+    const __m256i bits = _mm256_castpd_si256(x);
+    __m256i e = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(1023));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                                    _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    const __m256d big = _mm256_cmp_pd(m, set(kSqrt2), _CMP_GT_OQ);     // m in [sqrt2/2, sqrt2)
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, set(0.5)), big);
+    const __m256d k = _mm256_add_pd(small_i64_to_pd(e), _mm256_and_pd(big, set(1.0)));
+
+    const __m256d f = _mm256_sub_pd(m, set(1.0));
+    const __m256d s = _mm256_div_pd(f, _mm256_add_pd(set(2.0), f));
+    const __m256d z = _mm256_mul_pd(s, s);
+    const __m256d w = _mm256_mul_pd(z, z);
+    const __m256d t1 = keep(_mm256_mul_pd(w, fmadd(w, fmadd(w, set(Lg6), set(Lg4)), set(Lg2))));
+    const __m256d t2 = keep(_mm256_mul_pd(z, fmadd(w, fmadd(w, fmadd(w, set(Lg7), set(Lg5)), set(Lg3)), set(Lg1))));
+    const __m256d R = _mm256_add_pd(t2, t1);
+    const __m256d hfsq = keep(_mm256_mul_pd(_mm256_mul_pd(set(0.5), f), f));
+    const __m256d inner = fmadd(s, _mm256_add_pd(hfsq, R), _mm256_mul_pd(k, set(kLn2Lo)));
+    return _mm256_sub_pd(keep(_mm256_mul_pd(k, set(kLn2Hi))), _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+}
+
+// sin(2 pi u), cos(2 pi u), u in [0, 1): quadrant q = round(4u), r = u - q/4
+// (exact), kernels on 2 pi r in [-pi/4, pi/4], then rotated by q quarter turns.
+inline void sincos2pi4(__m256d u, __m256d& sin_out, __m256d& cos_out) {
+    const __m256d q = _mm256_round_pd(_mm256_mul_pd(u, set(4.0)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d x = _mm256_mul_pd(_mm256_sub_pd(u, keep(_mm256_mul_pd(q, set(0.25)))), set(kTwoPi));
+    const __m256d z = _mm256_mul_pd(x, x);
+
+    const __m256d ps = fmadd(z, fmadd(z, fmadd(z, fmadd(z, fmadd(z, set(S6), set(S5)), set(S4)), set(S3)), set(S2)), set(S1));
+    const __m256d sn = fmadd(_mm256_mul_pd(x, z), ps, x);
+
+    const __m256d pc = fmadd(z, fmadd(z, fmadd(z, fmadd(z, fmadd(z, set(C6), set(C5)), set(C4)), set(C3)), set(C2)), set(C1));
+    const __m256d hz = keep(_mm256_mul_pd(set(0.5), z));
+    const __m256d w = _mm256_sub_pd(set(1.0), hz);
+    const __m256d cs = _mm256_add_pd(w, fmadd(_mm256_mul_pd(z, z), pc, _mm256_sub_pd(_mm256_sub_pd(set(1.0), w), hz)));
+
+    const __m256d q1 = _mm256_cmp_pd(q, set(1.0), _CMP_EQ_OQ);
+    const __m256d q2 = _mm256_cmp_pd(q, set(2.0), _CMP_EQ_OQ);
+    const __m256d q3 = _mm256_cmp_pd(q, set(3.0), _CMP_EQ_OQ);
+    const __m256d swap = _mm256_or_pd(q1, q3);
+    const __m256d sign = set(-0.0);
+    sin_out = _mm256_xor_pd(_mm256_blendv_pd(sn, cs, swap), _mm256_and_pd(_mm256_or_pd(q2, q3), sign));
+    cos_out = _mm256_xor_pd(_mm256_blendv_pd(cs, sn, swap), _mm256_and_pd(_mm256_or_pd(q1, q2), sign));
+}
+
+// exp(x): k = round(x / ln2), r = x - k ln2 (two-part ln2), exp(r) * 2^k.
+inline __m256d exp4(__m256d x) {
+    x = _mm256_max_pd(_mm256_min_pd(x, set(kExpMax)), set(-kExpMax));
+    const __m256d k = _mm256_round_pd(_mm256_mul_pd(x, set(kInvLn2)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d r = fmadd(k, set(-kLn2Lo), fmadd(k, set(-kLn2Hi), x));
+    __m256d p = set(E[13]);
+    for (int i = 12; i >= 0; --i) p = fmadd(p, r, set(E[i]));
+    const __m256d magic = set(6755399441055744.0);
+    const __m256i ki = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(k, magic)), _mm256_castpd_si256(magic));
+    const __m256i two_k = _mm256_slli_epi64(_mm256_add_epi64(ki, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(two_k));
+}
+
+// 53-bit uniforms (w_hi << 32 | w_lo) >> 11, times 2^-53, from two 32-bit words
+// held in 64-bit lanes. Exact, so equal to the scalar Stream::uniform().
+inline __m256d uniform4(__m256i w_hi, __m256i w_lo) {
+    const __m256i m = _mm256_srli_epi64(_mm256_or_si256(_mm256_slli_epi64(w_hi, 32), w_lo), 11);
+    const __m256d magic = set(4503599627370496.0);   // 2^52
+    auto to_pd = [&](__m256i v) {   // v < 2^32
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(v, _mm256_castpd_si256(magic))), magic);
+    };
+    const __m256d hi = to_pd(_mm256_srli_epi64(m, 32));
+    const __m256d lo = to_pd(_mm256_and_si256(m, _mm256_set1_epi64x(0xFFFFFFFFLL)));
+    return _mm256_mul_pd(_mm256_add_pd(keep(_mm256_mul_pd(hi, set(4294967296.0))), lo), set(0x1.0p-53));
+}
+
+// Box-Muller: zc = r cos(2 pi u2), zs = r sin(2 pi u2), r = sqrt(-2 log u1).
+inline void box_muller4(__m256d u1, __m256d u2, __m256d& zc, __m256d& zs) {
+    const __m256d r = _mm256_sqrt_pd(_mm256_mul_pd(set(-2.0), log4(u1)));
+    __m256d s, c;
+    sincos2pi4(u2, s, c);
+    zc = _mm256_mul_pd(r, c);
+    zs = _mm256_mul_pd(r, s);
+}
+
+#endif // __AVX2__
+
+// Scalar versions of the kernels above (same formulas).
+
+inline double log1(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, 8);
+    int64_t e = (int64_t)(bits >> 52) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+    double m;
+    std::memcpy(&m, &bits, 8);
+    if (m > kSqrt2) {
+        m *= 0.5;
+        ++e;
+    }
+    const double k = (double)e;
+    const double f = m - 1.0;
+    const double s = f / (2.0 + f);
+    const double z = s * s, w = z * z;
+    const double t1 = w * fmadd(w, fmadd(w, Lg6, Lg4), Lg2);
+    const double t2 = z * fmadd(w, fmadd(w, fmadd(w, Lg7, Lg5), Lg3), Lg1);
+    const double R = t2 + t1;
+    const double hfsq = 0.5 * f * f;
+    const double inner = fmadd(s, hfsq + R, k * kLn2Lo);
+    return k * kLn2Hi - ((hfsq - inner) - f);
+}
+
+inline void sincos2pi1(double u, double& sin_out, double& cos_out) {
+    const double q = std::nearbyint(u * 4.0);
+    const double x = (u - q * 0.25) * kTwoPi;
+    const double z = x * x;
+    const double sn = fmadd(x * z, fmadd(z, fmadd(z, fmadd(z, fmadd(z, fmadd(z, S6, S5), S4), S3), S2), S1), x);
+    const double pc = fmadd(z, fmadd(z, fmadd(z, fmadd(z, fmadd(z, C6, C5), C4), C3), C2), C1);
+    const double hz = 0.5 * z, w = 1.0 - hz;
+    const double cs = w + fmadd(z * z, pc, (1.0 - w) - hz);
+    const int quadrant = (int)q & 3;
+    const double a = (quadrant & 1) ? cs : sn, b = (quadrant & 1) ? sn : cs;
+    sin_out = (quadrant >= 2) ? -a : a;
+    cos_out = (quadrant == 1 || quadrant == 2) ? -b : b;
+}
+
+inline double exp1(double x) {
+    x = std::max(std::min(x, kExpMax), -kExpMax);
+    const double k = std::nearbyint(x * kInvLn2);
+    const double r = fmadd(k, -kLn2Lo, fmadd(k, -kLn2Hi, x));
+    double p = E[13];
+    for (int i = 12; i >= 0; --i) p = fmadd(p, r, E[i]);
+    return std::ldexp(p, (int)k);
+}
+
+inline void box_muller1(double u1, double u2, double& zc, double& zs) {
+    const double r = std::sqrt(-2.0 * log1(u1));
+    double s, c;
+    sincos2pi1(u2, s, c);
+    zc = r * c;
+    zs = r * s;
+}
+
+} // namespace detail
+
+// exp of x[0..n) in place, |x| clamped to 708 (no overflow / denormal results).
+inline void exp_batch(double* x, size_t n) {
+#if defined(__AVX2__)
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(x + i, detail::exp4(_mm256_loadu_pd(x + i)));
+    if (i < n) {   // tail through the same kernel
+        double buf[4] = {0.0, 0.0, 0.0, 0.0};
+        std::copy(x + i, x + n, buf);
+        _mm256_storeu_pd(buf, detail::exp4(_mm256_loadu_pd(buf)));
+        std::copy(buf, buf + (n - i), x + i);
+    }
+#else
+    for (size_t i = 0; i < n; ++i) x[i] = detail::exp1(x[i]);
+#endif
+}
+
+// Sequential draws of one block of one path. Copies are independent cursors.
+class Stream {
+public:
+    Stream(uint64_t seed, uint64_t path, uint32_t block)
+        : key_{uint32_t(seed), uint32_t(seed >> 32)},
+          ctr_{0, block, uint32_t(path), uint32_t(path >> 32)} {}
+
+    uint32_t next_u32() {
+        if (pos_ == 4) {
+            out_ = philox4x32_10(ctr_, key_);
+            ++ctr_[0];
+            pos_ = 0;
+        }
+        return out_[pos_++];
+    }
+
+    uint64_t next_u64() {
+        const uint64_t hi = next_u32();
+        return (hi << 32) | next_u32();
+    }
+
+    // [0, 1) on 53 bits
+    double uniform() { return (next_u64() >> 11) * 0x1.0p-53; }
+
+    // N(0, 1) by Box-Muller: one 128-bit group gives two normals, the second
+    // one is returned by the next call.
+    double normal() {
+        if (has_spare_) {
+            has_spare_ = false;
+            return spare_;
+        }
+        const double u1 = 1.0 - uniform();   // (0, 1], log is finite
+        const double u2 = uniform();
+        double zc;
+#if defined(__AVX2__)
+        __m256d c, s;
+        detail::box_muller4(_mm256_set1_pd(u1), _mm256_set1_pd(u2), c, s);
+        zc = _mm256_cvtsd_f64(c);
+        spare_ = _mm256_cvtsd_f64(s);
+#else
+        detail::box_muller1(u1, u2, zc, spare_);
+#endif
+        has_spare_ = true;
+        return zc;
+    }
+
+    // n normals, the values of n calls to normal(), four groups per kernel call.
+    void normals(double* z, size_t n) {
+        size_t k = 0;
+        if (has_spare_ && n > 0) {
+            z[k++] = spare_;
+            has_spare_ = false;
+        }
+        if (pos_ != 4) {   // mid-group after integer / uniform draws: one by one
+            for (; k < n; ++k) z[k] = normal();
+            return;
+        }
+        for (; n - k >= 8; k += 8) groups4(z + k);
+        if (k < n) {
+            double buf[8];
+            groups4(buf);
+            const size_t need = n - k;
+            std::copy(buf, buf + need, z + k);
+            ctr_[0] -= (uint32_t)(4 - (need + 1) / 2);   // give back the unused groups
+            if (need & 1) {
+                spare_ = buf[need];
+                has_spare_ = true;
+            }
+        }
+    }
+
+private:
+    // Four groups from the current counter: out = zc0, zs0, zc1, zs1, ...
+    void groups4(double* out) {
+#if defined(__AVX2__)
+        const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+        __m256i c0 = _mm256_set_epi64x(uint32_t(ctr_[0] + 3), uint32_t(ctr_[0] + 2), uint32_t(ctr_[0] + 1), ctr_[0]);
+        __m256i c1 = _mm256_set1_epi64x(ctr_[1]), c2 = _mm256_set1_epi64x(ctr_[2]), c3 = _mm256_set1_epi64x(ctr_[3]);
+        const __m256i m0 = _mm256_set1_epi64x(kPhiloxM0), m1 = _mm256_set1_epi64x(kPhiloxM1);
+        uint32_t k0 = key_[0], k1 = key_[1];
+        for (int r = 0; r < 10; ++r) {
+            const __m256i p0 = _mm256_mul_epu32(m0, c0);
+            const __m256i p1 = _mm256_mul_epu32(m1, c2);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+            c1 = _mm256_and_si256(p1, lo32);
+            c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+            c3 = _mm256_and_si256(p0, lo32);
+            k0 += kPhiloxW0;
+            k1 += kPhiloxW1;
+        }
+        const __m256d u1 = _mm256_sub_pd(_mm256_set1_pd(1.0), detail::uniform4(c0, c1));
+        const __m256d u2 = detail::uniform4(c2, c3);
+        __m256d zc, zs;
+        detail::box_muller4(u1, u2, zc, zs);
+        const __m256d lo = _mm256_unpacklo_pd(zc, zs), hi = _mm256_unpackhi_pd(zc, zs);
+        _mm256_storeu_pd(out, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+        ctr_[0] += 4;
+#else
+        for (int j = 0; j < 4; ++j) {
+            const Counter w = philox4x32_10(ctr_, key_);
+            ++ctr_[0];
+            const double u1 = 1.0 - ((((uint64_t)w[0] << 32) | w[1]) >> 11) * 0x1.0p-53;
+            const double u2 = ((((uint64_t)w[2] << 32) | w[3]) >> 11) * 0x1.0p-53;
+            detail::box_muller1(u1, u2, out[2 * j], out[2 * j + 1]);
+        }
+#endif
+    }
+
+    Key key_;
+    Counter ctr_;
+    Counter out_{};
+    int pos_ = 4;
+    bool has_spare_ = false;
+    double spare_ = 0.0;
+};
+
+inline int thread_count(int n_threads) {
+    return n_threads > 0 ? n_threads : std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+// Calls fn(b, t0, t1) for every block b = [t0, t1) of [0, n) on up to n_threads
+// threads (0 = all hardware threads), the calling thread included. Blocks are
+// handed out dynamically, so fn must only write the steps of its own block.
+template <class Fn>
+void for_blocks(size_t n, int n_threads, Fn&& fn, size_t block = kStepBlock) {
+    const size_t n_blocks = (n + block - 1) / block;
+    const int n_thr = (int)std::min<size_t>(thread_count(n_threads), n_blocks);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t b; (b = next.fetch_add(1)) < n_blocks; )
+            fn((uint32_t)b, b * block, std::min(n, (b + 1) * block));
+    };
+    std::vector<std::thread> pool;
+    for (int k = 1; k < n_thr; ++k) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+} // namespace ctr
@@ -0,0 +1,250 @@
+#pragma once
+// Monte Carlo ensembles: one strategy run on many independent synthetic paths.
+//
+// ens::run() hands paths out in chunks to a pool of threads. Each thread builds
+// its own state once (price buffers, indicator scratch, trade list) with
+// make_state() and reuses it for every path it runs, so nothing is shared
+// between threads and the path-sized buffers are allocated once per thread.
+// A path reports its summary (ens::Path); per-path results are folded into
+// per-thread distributions as they come and merged at the end, so memory does
+// not grow with the number of paths or trades.
+//
+// Distributions keep count, mean, standard deviation, min, max and a quantile
+// sketch. The sketch is a log-bucketed histogram (DDSketch-like): a value falls
+// in the bucket of its sign, binary exponent and leading kSubBits mantissa bits,
+// so any quantile is returned within a relative error of 2^-(kSubBits+1) (0.4%)
+// of an exact order statistic, whatever the scale. Bucket counts add up, so
+// counts, quantiles, min and max do not depend on the thread count or on the
+// order in which paths finished; means and deviations agree to rounding.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "ctr_rng.hpp"
+#include "util.hpp"
+
+namespace ens {
+
+constexpr uint64_t kPathChunk = 16;   // paths per work item
+
+// Result of one path.
+struct Path {
+    double pnl = 0.0;
+    double max_dd = 0.0;
+    int trades = 0;
+    int wins = 0;
+};
+
+// Log-bucketed quantile sketch (see header comment).
+class Quantiles {
+public:
+    static constexpr int kSubBits = 7;                        // mantissa bits per bucket
+    static constexpr int kMinExp = -32, kMaxExp = 31;         // |x| < 2^kMinExp counts as 0
+    static constexpr int kSide = (kMaxExp - kMinExp + 1) << kSubBits;
+
+    Quantiles() : count_(2 * kSide + 1, 0) {}
+
+    void add(double x) { ++count_[index(x)]; ++n_; }
+
+    void merge(const Quantiles& o) {
+        for (size_t i = 0; i < count_.size(); ++i) count_[i] += o.count_[i];
+        n_ += o.n_;
+    }
+
+    uint64_t size() const { return n_; }
+
+    // Value of rank floor(q * (n - 1)) in sorted order, as its bucket midpoint.
+    double quantile(double q) const {
+        if (n_ == 0) return 0.0;
+        const uint64_t rank = (uint64_t)(std::min(std::max(q, 0.0), 1.0) * (double)(n_ - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < count_.size(); ++i) {
+            seen += count_[i];
+            if (seen > rank) return midpoint((int)i);
+        }
+        return midpoint((int)count_.size() - 1);
+    }
+
+private:
+    // Buckets in value order: negatives (largest magnitude first), zero, positives.
+    static int index(double x) {
+        const double a = std::fabs(x);
+        if (!(a >= std::ldexp(1.0, kMinExp))) return kSide;   // zero bucket (and NaN)
+        int e;
+        const double m = std::frexp(a, &e);                    // a = m 2^e, m in [0.5, 1)
+        int key;
+        if (e - 1 > kMaxExp) key = kSide - 1;
+        else key = ((e - 1 - kMinExp) << kSubBits) | (int)((2.0 * m - 1.0) * (1 << kSubBits));
+        return x < 0 ? kSide - 1 - key : kSide + 1 + key;
+    }
+
+    static double midpoint(int i) {
+        if (i == kSide) return 0.0;
+        const int key = i > kSide ? i - kSide - 1 : kSide - 1 - i;
+        const int e = (key >> kSubBits) + kMinExp;
+        const int sub = key & ((1 << kSubBits) - 1);
+        const double v = std::ldexp(1.0 + (sub + 0.5) / (1 << kSubBits), e);
+        return i > kSide ? v : -v;
+    }
+
+    std::vector<uint64_t> count_;
+    uint64_t n_ = 0;
+};
+
+// Moments, range and quantiles of one per-path quantity. The mean comes from a
+// compensated sum; the deviation from Welford's running M2, merged across
+// threads with Chan's pairwise update.
+struct Metric {
+    uint64_t n = 0;
+    util::CompensatedSum sum;
+    double w_mean = 0.0, m2 = 0.0;                   // Welford mean / sum of squared deviations
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+    Quantiles q;
+
+    void add(double x) {
+        ++n;
+        sum.add(x);
+        const double d = x - w_mean;
+        w_mean += d / (double)n;
+        m2 += d * (x - w_mean);
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+        q.add(x);
+    }
+
+    void merge(const Metric& o) {
+        if (o.n == 0) return;
+        const double d = o.w_mean - w_mean;
+        const double na = (double)n, nb = (double)o.n, nt = na + nb;
+        w_mean += d * nb / nt;
+        m2 += o.m2 + d * d * na * nb / nt;
+        n += o.n;
+        sum.add(o.sum.sum);
+        sum.comp += o.sum.comp;
+        lo = std::min(lo, o.lo);
+        hi = std::max(hi, o.hi);
+        q.merge(o.q);
+    }
+
+    double mean() const { return n ? sum.value() / (double)n : 0.0; }
+    double sd() const { return n < 2 ? 0.0 : std::sqrt(m2 / (double)(n - 1)); }
+    // Sketch quantile, clamped to the exact observed range.
+    double quantile(double p) const {
+        if (n == 0) return 0.0;
+        if (p <= 0.0) return lo;
+        if (p >= 1.0) return hi;
+        return std::min(hi, std::max(lo, q.quantile(p)));
+    }
+};
+
+// Distributions over the paths of an ensemble.
+struct Distribution {
+    uint64_t paths = 0;
+    uint64_t profitable = 0;     // total PnL > 0
+    uint64_t no_trades = 0;      // excluded from the win-rate distribution
+    Metric pnl, win_rate, max_dd, trades;
+
+    void add(const Path& p) {
+        ++paths;
+        if (p.pnl > 0.0) ++profitable;
+        pnl.add(p.pnl);
+        max_dd.add(p.max_dd);
+        trades.add((double)p.trades);
+        if (p.trades > 0) win_rate.add(100.0 * p.wins / (double)p.trades);
+        else ++no_trades;
+    }
+
+    void merge(const Distribution& o) {
+        paths += o.paths;
+        profitable += o.profitable;
+        no_trades += o.no_trades;
+        pnl.merge(o.pnl);
+        win_rate.merge(o.win_rate);
+        max_dd.merge(o.max_dd);
+        trades.merge(o.trades);
+    }
+};
+
+// Same paths, possibly merged in another order: counts, ranges and quantiles
+// must match exactly, means and deviations to rounding.
+inline bool same_distribution(const Distribution& a, const Distribution& b) {
+    if (a.paths != b.paths || a.profitable != b.profitable || a.no_trades != b.no_trades) return false;
+    auto same = [](const Metric& x, const Metric& y) {
+        if (x.n != y.n || x.lo != y.lo || x.hi != y.hi) return false;
+        for (double q : {0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99})
+            if (x.quantile(q) != y.quantile(q)) return false;
+        const double tol = 1e-12 * (1.0 + std::fabs(x.mean()) + x.sd());
+        return std::fabs(x.mean() - y.mean()) <= tol && std::fabs(x.sd() - y.sd()) <= tol;
+    };
+    return same(a.pnl, b.pnl) && same(a.win_rate, b.win_rate) && same(a.max_dd, b.max_dd) &&
+           same(a.trades, b.trades);
+}
+
+// Runs path_fn(state, k) for k in [0, n_paths) on up to n_threads threads
+// (0 = all hardware threads), the calling thread included. Each thread owns one
+// state from make_state(); path_fn returns the ens::Path of path k.
+template <class MakeState, class PathFn>
+Distribution run(uint64_t n_paths, int n_threads, MakeState&& make_state, PathFn&& path_fn) {
+    const uint64_t n_chunks = (n_paths + kPathChunk - 1) / kPathChunk;
+    const int n_thr = (int)std::max<uint64_t>(1, std::min<uint64_t>(ctr::thread_count(n_threads), n_chunks));
+    std::vector<Distribution> part(n_thr);
+    std::atomic<uint64_t> next{0};
+
+    auto worker = [&](int w) {
+        auto state = make_state();
+        Distribution& d = part[w];
+        for (uint64_t c; (c = next.fetch_add(1)) < n_chunks; )
+            for (uint64_t k = c * kPathChunk, e = std::min(n_paths, k + kPathChunk); k < e; ++k)
+                d.add(path_fn(state, k));
+    };
+    std::vector<std::thread> pool;
+    for (int w = 1; w < n_thr; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    for (int w = 1; w < n_thr; ++w) part[0].merge(part[w]);
+    return std::move(part[0]);
+}
+
+// Distribution table: mean, sd and quantiles of each per-path metric (sketch
+// quantiles, so within 0.4%; trade-count quantiles are rounded to integers).
+inline void print(std::ostream& os, const Distribution& d) {
+    const double qs[] = {0.01, 0.05, 0.25, 0.50, 0.75, 0.95, 0.99};
+    const char* names[] = {"p1", "p5", "p25", "p50", "p75", "p95", "p99"};
+
+    const auto flags = os.flags();
+    const auto prec = os.precision();
+    os << std::fixed << std::setprecision(2);
+    os << "Profitable paths: " << (d.paths ? 100.0 * d.profitable / (double)d.paths : 0.0) << "%"
+       << " | paths without trades: " << d.no_trades << "\n";
+    os << std::setprecision(4);
+    os << std::setw(10) << "" << std::setw(11) << "mean" << std::setw(11) << "sd"
+       << std::setw(11) << "min";
+    for (const char* n : names) os << std::setw(11) << n;
+    os << std::setw(11) << "max" << "\n";
+
+    auto row = [&](const char* label, const Metric& m, bool integer) {
+        auto quantile = [&](double q) { return integer ? std::round(m.quantile(q)) : m.quantile(q); };
+        os << std::left << std::setw(10) << label << std::right
+           << std::setw(11) << m.mean() << std::setw(11) << m.sd() << std::setw(11) << quantile(0.0);
+        for (double q : qs) os << std::setw(11) << quantile(q);
+        os << std::setw(11) << quantile(1.0) << "\n";
+    };
+    row("PnL", d.pnl, false);
+    row("win %", d.win_rate, false);
+    row("max DD", d.max_dd, false);
+    row("trades", d.trades, true);
+
+    os.flags(flags);
+    os.precision(prec);
+}
+
+} // namespace ens
@@ -0,0 +1,80 @@
+#pragma once
+
+// News event calendar shared by event_study and macro_news_breakout.
+// Header-only.
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace news {
+
+enum class EventType { NONE, MACRO, CENTRAL_BANK };
+
+// --- Event calendar
+// Events are kept sorted by (t, priority desc). A Cursor walks the calendar
+// forward with the clock, so per-tick lookups are O(1) amortized whatever the
+// calendar size (the old per-tick scan of every event was O(T*E)).
+struct CalendarEvent {
+    int t = 0;
+    EventType type = EventType::NONE;
+    int priority = 0;      // highest priority wins when several events share a timestamp
+    int country = 0;       // metadata: free-form country / currency code
+    std::string name;      // metadata: release name
+};
+
+class EventCalendar {
+public:
+    void add(CalendarEvent e) { events_.push_back(std::move(e)); }
+
+    // Must be called after the last add(); equal (t, priority) keep insertion order.
+    void sort() {
+        std::stable_sort(events_.begin(), events_.end(), [](const CalendarEvent& a, const CalendarEvent& b) {
+            return a.t != b.t ? a.t < b.t : a.priority > b.priority;
+        });
+    }
+
+    size_t size() const { return events_.size(); }
+    const std::vector<CalendarEvent>& events() const { return events_; }
+
+    class Cursor {
+    public:
+        explicit Cursor(const EventCalendar& cal) : ev_(cal.events_.data()), n_(cal.events_.size()) {}
+
+        // All events at time t, highest priority first, as [first, last).
+        // t must be non-decreasing across calls.
+        std::pair<const CalendarEvent*, const CalendarEvent*> at(int t) {
+            while (i_ < n_ && ev_[i_].t < t) ++i_;
+            size_t j = i_;
+            while (j < n_ && ev_[j].t == t) ++j;
+            return {ev_ + i_, ev_ + j};
+        }
+
+        // Highest-priority event at time t, or nullptr.
+        const CalendarEvent* top(int t) {
+            auto r = at(t);
+            return r.first != r.second ? r.first : nullptr;
+        }
+
+    private:
+        const CalendarEvent* ev_;
+        size_t n_;
+        size_t i_ = 0;
+    };
+
+private:
+    std::vector<CalendarEvent> events_;
+};
+
+// Default toy calendar: macro releases every 400 steps, central bank meetings
+// every 800 steps (central bank takes precedence on shared timestamps).
+inline EventCalendar default_calendar(int T, int macro_every = 400, int cb_every = 800) {
+    EventCalendar cal;
+    for(int t = macro_every; t < T; t += macro_every) cal.add({t, EventType::MACRO, 1, 0, "MACRO"});
+    for(int t = cb_every; t < T; t += cb_every) cal.add({t, EventType::CENTRAL_BANK, 2, 0, "CB"});
+    cal.sort();
+    return cal;
+}
+
+} // namespace news
@@ -0,0 +1,237 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "calendar_queue.hpp"
+#include "ctr_rng.hpp"
+#include "hawkes_lob.hpp"
+#include "util.hpp"
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// --- Reference scheduler: binary heap on (time, insertion sequence), same order
+// as the calendar queue.
+template <class T>
+class HeapQueue {
+public:
+    bool empty() const { return q_.empty(); }
+    size_t size() const { return q_.size(); }
+    void push(double t, const T& item) { q_.push(Node{t, seq_++, item}); }
+    bool pop(double& t, T& item) {
+        if (q_.empty()) return false;
+        t = q_.top().t;
+        item = q_.top().item;
+        q_.pop();
+        return true;
+    }
+
+private:
+    struct Node {
+        double t;
+        uint64_t seq;
+        T item;
+        bool operator>(const Node& o) const { return t > o.t || (t == o.t && seq > o.seq); }
+    };
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> q_;
+    uint64_t seq_ = 0;
+};
+
+// Classic "hold" model: n pending events, each pop schedules a new event an
+// Exp(1) delay after the popped time. Returns a checksum of the popped items.
+template <class Q>
+static uint64_t hold(Q& q, size_t n, size_t ops, uint64_t seed) {
+    ctr::Stream rng(seed, 0, 0);
+    for (size_t i = 0; i < n; ++i) q.push(-std::log(1.0 - rng.uniform()), (uint32_t)i);
+    uint64_t sum = 0;
+    double t = 0.0;
+    uint32_t item = 0;
+    for (size_t k = 0; k < ops; ++k) {
+        q.pop(t, item);
+        sum = sum * 31 + item;
+        q.push(t - std::log(1.0 - rng.uniform()), (uint32_t)(n + k));
+    }
+    return sum;
+}
+
+static uint64_t record_hash(uint64_t h, const hawkes::Record& r) {
+    uint64_t bits;
+    std::memcpy(&bits, &r.t, 8);
+    for (uint64_t v : {bits, (uint64_t)r.kind, (uint64_t)r.price, (uint64_t)r.qty, (uint64_t)r.filled})
+        h = (h ^ v) * 0x100000001B3ull;
+    return h;
+}
+
+// --- Modes
+
+static int bench(uint64_t n_events, uint64_t seed) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Hold model, 4M pops + pushes:\n";
+    for (size_t n : {1000, 100000, 1000000}) {
+        const size_t ops = 4000000;
+        cq::CalendarQueue<uint32_t> cal(2 * n);
+        auto t0 = std::chrono::steady_clock::now();
+        const uint64_t a = hold(cal, n, ops, seed);
+        const double cal_secs = seconds_since(t0);
+        HeapQueue<uint32_t> heap;
+        t0 = std::chrono::steady_clock::now();
+        const uint64_t b = hold(heap, n, ops, seed);
+        const double heap_secs = seconds_since(t0);
+        std::cout << "  " << std::setw(8) << n << " pending: calendar queue " << ops / cal_secs / 1e6
+                  << " M ops/s, binary heap " << ops / heap_secs / 1e6 << " M ops/s (x" << std::setprecision(2)
+                  << heap_secs / cal_secs << ")" << std::setprecision(1) << (a == b ? "" : " ORDER DIFFERS") << "\n";
+    }
+
+    const hawkes::Params p = hawkes::Params::standard();
+    hawkes::Queue q(1 << 16);
+    hawkes::BookSim sim(p, seed, 0);
+    sim.start(q);
+    uint64_t n = 0, h = 0;
+    double t = 0.0;
+    hawkes::Event e;
+    auto t0 = std::chrono::steady_clock::now();
+    while (n < n_events && q.pop(t, e)) {
+        h = record_hash(h, sim.apply(e, t, q));
+        ++n;
+    }
+    const double secs = seconds_since(t0);
+    std::cout << "Hawkes order flow on one book: " << n << " events (" << std::setprecision(0) << t
+              << " s simulated) in " << std::setprecision(2) << secs << " s: " << std::setprecision(1)
+              << n / secs / 1e6 << " M events/s, " << sim.book().order_count() << " resting orders, "
+              << q.size() << " pending events\n";
+    std::cout << "Record hash: " << std::hex << h << std::dec << "\n";
+    return 0;
+}
+
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAILED: " << what << "\n";
+            ++failures;
+        }
+    };
+
+    // calendar queue vs binary heap: same pops, ties in insertion order, growth
+    // and shrinkage, events earlier than the current day
+    {
+        cq::CalendarQueue<uint32_t> cal;
+        HeapQueue<uint32_t> heap;
+        ctr::Stream rng(7, 0, 0);
+        bool same = true;
+        double now = 0.0;
+        uint32_t next = 0;
+        uint64_t ops = 0;
+        for (int phase = 0; phase < 6 && same; ++phase) {
+            const size_t target = (phase % 2 == 0) ? 50000 : 10;
+            while (same && (phase % 2 == 0 ? cal.size() < target : cal.size() > target)) {
+                const uint32_t r = rng.next_u32();
+                const bool grow = phase % 2 == 0;
+                if ((r % 4 != 0) == grow || cal.empty()) {
+                    double t;
+                    switch (r % 5) {
+                        case 0: t = now; break;                                    // tie with the current time
+                        case 1: t = std::floor(now) + (r >> 8) % 4; break;         // ties between pushes
+                        case 2: t = now + 1000.0 * rng.uniform(); break;           // far ahead
+                        default: t = now - std::log(1.0 - rng.uniform()); break;
+                    }
+                    if (r % 97 == 0) t = now * rng.uniform();                      // earlier than current
+                    cal.push(t, next);
+                    heap.push(t, next);
+                    ++next;
+                } else {
+                    double ta = 0.0, tb = 0.0;
+                    uint32_t a = 0, b = 0;
+                    cal.pop(ta, a);
+                    heap.pop(tb, b);
+                    same = ta == tb && a == b;
+                    now = ta;
+                }
+                ++ops;
+            }
+        }
+        while (same && !cal.empty()) {
+            double ta = 0.0, tb = 0.0;
+            uint32_t a = 0, b = 0;
+            cal.pop(ta, a);
+            heap.pop(tb, b);
+            same = ta == tb && a == b;
+        }
+        same = same && heap.empty();
+        expect(same, "calendar queue vs binary heap order");
+        std::cout << "Calendar queue vs binary heap: " << ops << " random ops with ties, resizes and late pushes: "
+                  << (same ? "identical order" : "DIFFERENT") << "\n";
+    }
+
+    // Hawkes flow: rates, clustering, book consistency, determinism
+    {
+        const hawkes::Params p = hawkes::Params::standard();
+        double rate[hawkes::kKinds];
+        hawkes::stationary_rates(p, rate);
+
+        const double horizon = 200000.0, window = 10.0;
+        hawkes::Queue q;
+        hawkes::BookSim sim(p, 42, 3);
+        sim.start(q);
+        bool sane = true;
+        uint64_t h = 0;
+        std::vector<double> counts((size_t)(horizon / window), 0.0);
+        hawkes::run(sim, q, horizon, [&](const hawkes::Record& r) {
+            h = record_hash(h, r);
+            const int64_t bid = sim.book().best_bid(), ask = sim.book().best_ask();
+            if (bid != lob::kNoBid && ask != lob::kNoAsk && bid >= ask) sane = false;
+            if (r.kind == hawkes::MarketBuy) counts[(size_t)(r.t / window)] += 1.0;
+        });
+        expect(sane, "book never crossed");
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (int i = 0; i < hawkes::kKinds; ++i) {
+            const double got = sim.count(i) / horizon;
+            const bool ok = std::fabs(got / rate[i] - 1.0) < 0.02;
+            std::cout << "  " << std::left << std::setw(12) << hawkes::kind_name(i) << std::right
+                      << " rate " << got << " / s, stationary " << rate[i] << (ok ? "" : "  <-- off") << "\n";
+            expect(ok, std::string("stationary rate of ") + hawkes::kind_name(i));
+        }
+
+        // Counts in windows much longer than 1/beta: variance / mean is about
+        // 1 / (1 - branching)^2 for a self-exciting process, 1 for Poisson.
+        double m = 0.0, v = 0.0;
+        for (double c : counts) m += c;
+        m /= counts.size();
+        for (double c : counts) v += (c - m) * (c - m);
+        v /= counts.size() - 1;
+        std::cout << "  Market buy counts per " << window << " s: dispersion " << v / m << " (Poisson: 1)\n";
+        expect(v / m > 1.5, "clustered arrivals");
+
+        hawkes::Queue q2;
+        hawkes::BookSim again(p, 42, 3);
+        again.start(q2);
+        uint64_t h2 = 0;
+        hawkes::run(again, q2, horizon, [&](const hawkes::Record& r) { h2 = record_hash(h2, r); });
+        expect(h == h2, "same seed, same events");
+        expect(sim.block() == sim.events() / hawkes::kEventsPerBlock,
+               "stream block advanced every kEventsPerBlock events");
+        std::cout << "  " << sim.events() << " events, " << sim.volume() << " traded, rerun "
+                  << (h == h2 ? "identical" : "DIFFERENT") << ", " << sim.block() + 1 << " stream block(s)\n";
+    }
+
+    std::cout << (failures == 0 ? "Hawkes check: OK" : "Hawkes check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "bench") return bench(util::arg_u64(argc, argv, "events", 20000000), util::arg_u64(argc, argv, "seed", 42));
+    if (mode == "check") return run_check();
+    std::cerr << "usage: hawkes_bench bench [events=20000000] [seed=42] | hawkes_bench check\n";
+    return 1;
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+// Event-driven order flow: market, limit and cancel events on each side of a
+// full-depth book (order_book.hpp), arriving as a 6-dimensional Hawkes process
+// with exponential kernels, in continuous time. Header-only.
+//
+// Component i has intensity
+//     lambda_i(t) = mu_i + sum_j sum_{t_k of type j, t_k < t} n[j][i] beta exp(-beta (t - t_k))
+// i.e. every event of type j raises the rate of type i by n[j][i] expected events,
+// spread over the following 1/beta seconds. The process is simulated exactly in
+// its cluster (branching) form: immigrants of type i arrive as a Poisson process
+// of rate mu_i, and every event, immigrant or not, has Poisson(n[i][j]) children
+// of type j, each after an Exp(beta) delay. All of them are scheduled into a
+// calendar queue (calendar_queue.hpp), together with the expiry of every
+// resting limit order, so an event costs one queue pop, a few pushes and one
+// book operation, with no thinning and no per-step loop. The flow is stationary
+// when the spectral radius of n is below 1; the mean rates then solve
+// Lambda = mu + n^T Lambda (stationary_rates()).
+//
+// What the events do to the book:
+// - market: takes 1..max_market_qty from the other side, walking levels if needed;
+// - limit: rests 1..max_limit_qty, one tick inside the spread with probability
+//   p_improve when the spread is wider than a tick, otherwise Geometric(mean_offset)
+//   ticks behind its own touch; it expires after Exp(lifetime) seconds;
+// - cancel: removes the newest order at its side's touch (cancellations cluster
+//   at the touch, and the newest order has the least queue value to lose).
+//
+// Each book draws from its own counter-based stream (ctr_rng.hpp, path = book
+// id), so its event sequence depends only on (seed, id), whether it has the
+// queue to itself or shares one with other books. A stream block holds 2^32
+// Philox groups before its counter wraps; the book moves to the next block
+// every kEventsPerBlock events, long before that (see below).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "calendar_queue.hpp"
+#include "ctr_rng.hpp"
+#include "order_book.hpp"
+
+namespace hawkes {
+
+enum Kind : uint8_t { MarketBuy, MarketSell, LimitBuy, LimitSell, CancelBuy, CancelSell, Expire };
+constexpr int kKinds = 6;   // Hawkes components (Expire is scheduled, not excited)
+
+// Events drawn from one block of a book's stream. An event takes at most ~300
+// 32-bit draws (64 children of two uniforms each, plus its own), so 2^22 events
+// stay below 2^29 of the 2^32 groups of a block; 2^32 blocks cover 2^54 events.
+constexpr uint64_t kEventsPerBlock = uint64_t(1) << 22;
+
+inline const char* kind_name(int k) {
+    static const char* names[] = {"market buy", "market sell", "limit buy", "limit sell",
+                                  "cancel buy", "cancel sell", "expire"};
+    return names[k];
+}
+
+// Side of the book an event acts for (market buy: the taker buys).
+inline lob::Side side_of(int k) { return (k & 1) ? lob::Side::Sell : lob::Side::Buy; }
+
+struct Params {
+    double mu[kKinds] = {};            // immigrant rates, events / s
+    double n[kKinds][kKinds] = {};     // n[i][j]: expected type-j children of a type-i event
+    double beta = 20.0;                // kernel decay, 1/s
+    double lifetime = 30.0;            // mean life of a resting limit order, s
+    double p_improve = 0.3;
+    double mean_offset = 2.0;          // ticks behind the touch
+    int64_t max_offset = 50;
+    int64_t max_limit_qty = 10, max_market_qty = 5;
+    int64_t mid = 10000;               // starting mid, ticks
+    int init_levels = 10, init_orders = 3;   // book at start: levels x orders per side
+
+    // Symmetric flow: markets excite markets on the same side and refills on the
+    // side they hit, limits excite limits and cancels, cancels excite cancels
+    // and refills. Row sums 0.45, so the spectral radius is below 0.45.
+    static Params standard() {
+        Params p;
+        for (int s = 0; s < 2; ++s) {
+            const int o = 1 - s;
+            p.mu[MarketBuy + s] = 0.4;
+            p.mu[LimitBuy + s] = 4.0;
+            p.mu[CancelBuy + s] = 2.0;
+            p.n[MarketBuy + s][MarketBuy + s] = 0.30;
+            p.n[MarketBuy + s][LimitBuy + o] = 0.10;
+            p.n[MarketBuy + s][LimitBuy + s] = 0.05;
+            p.n[LimitBuy + s][LimitBuy + s] = 0.25;
+            p.n[LimitBuy + s][CancelBuy + s] = 0.10;
+            p.n[CancelBuy + s][CancelBuy + s] = 0.25;
+            p.n[CancelBuy + s][LimitBuy + s] = 0.10;
+        }
+        return p;
+    }
+};
+
+// Mean event rates of the stationary flow: Lambda = mu + n^T Lambda, by fixed-point
+// iteration (converges when the spectral radius of n is below 1).
+inline void stationary_rates(const Params& p, double out[kKinds]) {
+    double x[kKinds];
+    for (int i = 0; i < kKinds; ++i) x[i] = p.mu[i];
+    for (int it = 0; it < 1000; ++it) {
+        double y[kKinds];
+        for (int j = 0; j < kKinds; ++j) {
+            y[j] = p.mu[j];
+            for (int i = 0; i < kKinds; ++i) y[j] += p.n[i][j] * x[i];
+        }
+        for (int j = 0; j < kKinds; ++j) x[j] = y[j];
+    }
+    for (int i = 0; i < kKinds; ++i) out[i] = x[i];
+}
+
+// Scheduled event of one book. `order` is the order to expire.
+struct Event {
+    uint32_t book = 0;
+    uint8_t kind = 0;
+    uint8_t immigrant = 0;
+    lob::OrderId order = lob::kNoOrder;
+};
+
+using Queue = cq::CalendarQueue<Event>;
+
+// What an event did, for the caller's record. price is the limit / cancelled
+// order's price, or the last execution price of a market order (0 if nothing
+// happened, e.g. a market order on an empty side or an expiry of a dead order).
+struct Record {
+    double t = 0.0;
+    uint8_t kind = 0;
+    int64_t price = 0;
+    int64_t qty = 0;                   // submitted / cancelled quantity
+    int64_t filled = 0;                // executed (market orders)
+};
+
+class BookSim {
+public:
+    BookSim(const Params& p, uint64_t seed, uint32_t id)
+        : p_(p), id_(id), seed_(seed), rng_(seed, id, 0), mid_(p.mid) {
+        for (int i = 0; i < kKinds; ++i) {
+            double total = 0.0;
+            for (int j = 0; j < kKinds; ++j) total += p.n[i][j];
+            double acc = 0.0;
+            for (int j = 0; j < kKinds; ++j) {
+                acc += p.n[i][j];
+                child_cdf_[i][j] = total > 0.0 ? acc / total : 1.0;
+            }
+            children_[i] = total;
+            no_child_[i] = std::exp(-total);
+        }
+        book_.reserve_prices(p.mid - 2048, p.mid + 2048);
+    }
+
+    const lob::Book& book() const { return book_; }
+    uint32_t id() const { return id_; }
+    uint64_t count(int kind) const { return count_[kind]; }
+    uint64_t events() const {
+        uint64_t s = 0;
+        for (uint64_t c : count_) s += c;
+        return s;
+    }
+    int64_t volume() const { return volume_; }
+    uint32_t block() const { return block_; }   // current block of the book's stream
+
+    // Posts the starting book around the mid and schedules the first immigrant
+    // of every component after t0.
+    void start(Queue& q, double t0 = 0.0) {
+        for (int l = 0; l < p_.init_levels; ++l)
+            for (int k = 0; k < p_.init_orders; ++k) {
+                rest(q, t0, lob::Side::Buy, p_.mid - 1 - l, 1 + (int64_t)(rng_.next_u32() % (uint32_t)p_.max_limit_qty));
+                rest(q, t0, lob::Side::Sell, p_.mid + l, 1 + (int64_t)(rng_.next_u32() % (uint32_t)p_.max_limit_qty));
+            }
+        for (int i = 0; i < kKinds; ++i)
+            if (p_.mu[i] > 0.0) q.push(t0 + exponential(p_.mu[i]), Event{id_, (uint8_t)i, 1, lob::kNoOrder});
+    }
+
+    // Applies event e, popped at time t, and schedules what it triggers.
+    Record apply(const Event& e, double t, Queue& q) {
+        if (++in_block_ == kEventsPerBlock) {
+            rng_ = ctr::Stream(seed_, id_, ++block_);
+            in_block_ = 0;
+        }
+        Record r;
+        r.t = t;
+        r.kind = e.kind;
+        ++count_[e.kind];
+        const lob::Side s = side_of(e.kind);
+        switch (e.kind) {
+        case MarketBuy:
+        case MarketSell: {
+            r.qty = 1 + (int64_t)(rng_.next_u32() % (uint32_t)p_.max_market_qty);
+            int64_t last = 0;
+            const lob::Exec ex = book_.market(s, r.qty, [&](lob::OrderId, int64_t px, int64_t) { last = px; });
+            r.price = last;
+            r.filled = ex.filled;
+            volume_ += ex.filled;
+            break;
+        }
+        case LimitBuy:
+        case LimitSell:
+            r.price = limit_price(s);
+            r.qty = 1 + (int64_t)(rng_.next_u32() % (uint32_t)p_.max_limit_qty);
+            rest(q, t, s, r.price, r.qty);
+            break;
+        case CancelBuy:
+        case CancelSell: {
+            const int64_t px = s == lob::Side::Buy ? book_.best_bid() : book_.best_ask();
+            if (px == lob::kNoBid || px == lob::kNoAsk) break;
+            const lob::OrderId id = book_.newest(s, px);
+            r.price = px;
+            r.qty = book_.find(id)->qty;
+            book_.cancel(id);
+            break;
+        }
+        case Expire:
+            if (const lob::Order* o = book_.find(e.order)) {
+                r.price = o->price;
+                r.qty = o->qty;
+                book_.cancel(e.order);
+            }
+            return r;
+        }
+
+        const int i = e.kind;
+        if (e.immigrant) q.push(t + exponential(p_.mu[i]), Event{id_, (uint8_t)i, 1, lob::kNoOrder});
+        for (int c = children(i); c > 0; --c) {
+            const double u = rng_.uniform();
+            int j = 0;
+            while (j < kKinds - 1 && u >= child_cdf_[i][j]) ++j;
+            q.push(t + exponential(p_.beta), Event{id_, (uint8_t)j, 0, lob::kNoOrder});
+        }
+        return r;
+    }
+
+private:
+    double exponential(double rate) { return -std::log(1.0 - rng_.uniform()) / rate; }
+
+    // Poisson(children_[i]) by inversion; the mean is well below 1.
+    int children(int i) {
+        const double u = rng_.uniform();
+        double p = no_child_[i], cdf = p;
+        int k = 0;
+        while (u >= cdf && k < 64) {
+            ++k;
+            p *= children_[i] / k;
+            cdf += p;
+        }
+        return k;
+    }
+
+    int64_t limit_price(lob::Side s) {
+        const int64_t bid = book_.best_bid(), ask = book_.best_ask();
+        const bool has_bid = bid != lob::kNoBid, has_ask = ask != lob::kNoAsk;
+        if (has_bid && has_ask) mid_ = (bid + ask) / 2;
+        const double u = rng_.uniform();
+        if (has_bid && has_ask && ask - bid > 1 && u < p_.p_improve)
+            return s == lob::Side::Buy ? bid + 1 : ask - 1;
+        const int64_t off = std::min(p_.max_offset, (int64_t)(p_.mean_offset * -std::log(1.0 - rng_.uniform())));
+        if (s == lob::Side::Buy) return (has_bid ? bid : has_ask ? ask - 1 : mid_) - off;
+        return (has_ask ? ask : has_bid ? bid + 1 : mid_ + 1) + off;
+    }
+
+    void rest(Queue& q, double t, lob::Side s, int64_t px, int64_t qty) {
+        const lob::OrderId id = book_.add(s, px, qty);
+        if (id != lob::kNoOrder) q.push(t + exponential(1.0 / p_.lifetime), Event{id_, Expire, 0, id});
+    }
+
+    Params p_;
+    uint32_t id_;
+    uint64_t seed_;
+    ctr::Stream rng_;
+    uint32_t block_ = 0;
+    uint64_t in_block_ = 0;   // events applied on the current block
+    lob::Book book_;
+    int64_t mid_;
+    double child_cdf_[kKinds][kKinds];
+    double children_[kKinds], no_child_[kKinds];
+    uint64_t count_[kKinds + 1] = {};
+    int64_t volume_ = 0;
+};
+
+// Runs one book on its own queue until time t_end: on(record) after every event.
+// Returns the number of events applied.
+template <class OnEvent>
+uint64_t run(BookSim& sim, Queue& q, double t_end, OnEvent&& on) {
+    uint64_t n = 0;
+    double t;
+    Event e;
+    while (q.top(t) && t < t_end) {
+        q.pop(t, e);
+        on(sim.apply(e, t, q));
+        ++n;
+    }
+    return n;
+}
+
+} // namespace hawkes
@@ -0,0 +1,169 @@
+#pragma once
+
+// Market-wide sessions: many independent books with Hawkes order flow
+// (hawkes_lob.hpp), sharded over threads. Header-only.
+//
+// The books are split into contiguous shards, one per thread. A worker
+// builds its own books and event queues (so their memory is first touched by
+// the thread that uses it) and is the only one to touch them afterwards: the
+// book path has no locks and no shared writes. The session runs in intervals
+// of dt seconds. In each interval a worker advances every book of its shard to
+// the interval end and fills its own Stats: the flow of the interval (events,
+// market orders, traded volume) and the state of every book at the end of it
+// (spread and top-of-book imbalance histograms). Workers then meet at a
+// barrier, and the calling thread merges the per-worker Stats in shard order
+// and reports them, while the workers go on with the next interval into a
+// second Stats buffer.
+//
+// Every book draws from its own stream (path = book index) and has its own
+// queue, and the statistics are integer counts, so a session gives the same
+// numbers, bit for bit, for a given seed whatever the number of threads.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ctr_rng.hpp"
+#include "hawkes_lob.hpp"
+
+namespace shard {
+
+constexpr int kSpreadBins = 16;      // 1 .. 15 ticks, then 16 or more
+constexpr int kImbalanceBins = 20;   // top-of-book imbalance over [-1, 1]
+
+// Cross-symbol aggregates of one interval.
+struct Stats {
+    uint64_t events = 0, market_orders = 0, volume = 0;   // flow during the interval
+    uint64_t books = 0, one_sided = 0;                    // books at the end, of which without bid or ask
+    uint64_t spread_ticks = 0;                            // sum over two-sided books
+    uint64_t spread[kSpreadBins] = {};
+    uint64_t imbalance[kImbalanceBins] = {};
+
+    void add_book(const lob::Book& b) {
+        ++books;
+        const int64_t bid = b.best_bid(), ask = b.best_ask();
+        if (bid == lob::kNoBid || ask == lob::kNoAsk) {
+            ++one_sided;
+            return;
+        }
+        const int64_t s = ask - bid;
+        spread_ticks += (uint64_t)s;
+        ++spread[std::min<int64_t>(s, kSpreadBins) - 1];
+        const double qb = (double)b.depth(lob::Side::Buy, bid), qa = (double)b.depth(lob::Side::Sell, ask);
+        const int k = (int)((qb - qa) / (qb + qa) * 0.5 * kImbalanceBins + 0.5 * kImbalanceBins);
+        ++imbalance[std::min(std::max(k, 0), kImbalanceBins - 1)];
+    }
+
+    void add_event(const hawkes::Record& r) {
+        ++events;
+        if (r.kind == hawkes::MarketBuy || r.kind == hawkes::MarketSell) {
+            ++market_orders;
+            volume += (uint64_t)r.filled;
+        }
+    }
+
+    void merge(const Stats& o) {
+        events += o.events;
+        market_orders += o.market_orders;
+        volume += o.volume;
+        books += o.books;
+        one_sided += o.one_sided;
+        spread_ticks += o.spread_ticks;
+        for (int k = 0; k < kSpreadBins; ++k) spread[k] += o.spread[k];
+        for (int k = 0; k < kImbalanceBins; ++k) imbalance[k] += o.imbalance[k];
+    }
+
+    double mean_spread() const {
+        const uint64_t two_sided = books - one_sided;
+        return two_sided ? (double)spread_ticks / (double)two_sided : 0.0;
+    }
+
+    // FNV-1a over every count, to compare sessions.
+    uint64_t hash(uint64_t h = 0xCBF29CE484222325ull) const {
+        auto mix = [&](uint64_t v) { h = (h ^ v) * 0x100000001B3ull; };
+        mix(events); mix(market_orders); mix(volume); mix(books); mix(one_sided); mix(spread_ticks);
+        for (uint64_t c : spread) mix(c);
+        for (uint64_t c : imbalance) mix(c);
+        return h;
+    }
+};
+
+inline bool operator==(const Stats& a, const Stats& b) {
+    return a.events == b.events && a.market_orders == b.market_orders && a.volume == b.volume &&
+           a.books == b.books && a.one_sided == b.one_sided && a.spread_ticks == b.spread_ticks &&
+           std::equal(a.spread, a.spread + kSpreadBins, b.spread) &&
+           std::equal(a.imbalance, a.imbalance + kImbalanceBins, b.imbalance);
+}
+
+// Spinning barrier for a fixed set of threads: the last one to arrive bumps
+// the phase the others wait on. Spins yield, so oversubscribed runs progress.
+class Barrier {
+public:
+    explicit Barrier(int n) : n_(n) {}
+    void wait() {
+        const uint64_t phase = phase_.load(std::memory_order_acquire);
+        if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == n_) {
+            waiting_.store(0, std::memory_order_relaxed);
+            phase_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (phase_.load(std::memory_order_acquire) == phase) std::this_thread::yield();
+    }
+
+private:
+    const int n_;
+    std::atomic<int> waiting_{0};
+    std::atomic<uint64_t> phase_{0};
+};
+
+// Runs n_books books for n_intervals intervals of dt seconds on up to n_threads
+// threads (0 = all hardware threads), the calling thread included. After every
+// interval, report(k, t_end, stats) is called on the calling thread with the
+// merged Stats of interval k. Returns the number of threads used.
+template <class Report>
+int run_session(size_t n_books, const hawkes::Params& p, uint64_t seed, int n_threads,
+                int n_intervals, double dt, Report&& report) {
+    const int n_thr = (int)std::max<size_t>(1, std::min<size_t>(ctr::thread_count(n_threads), n_books));
+    std::vector<Stats> part[2] = {std::vector<Stats>(n_thr), std::vector<Stats>(n_thr)};
+    Barrier barrier(n_thr);
+
+    auto worker = [&](int w) {
+        const size_t lo = n_books * w / n_thr, hi = n_books * (w + 1) / n_thr;
+        std::vector<hawkes::Queue> queues(hi - lo, hawkes::Queue(512));
+        std::vector<hawkes::BookSim> books;
+        books.reserve(hi - lo);
+        for (size_t i = lo; i < hi; ++i) {
+            books.emplace_back(p, seed, (uint32_t)i);
+            books.back().start(queues[i - lo]);
+        }
+
+        for (int k = 0; k < n_intervals; ++k) {
+            const double t_end = (k + 1) * dt;
+            Stats st;   // local: no false sharing with the neighbouring shards
+            for (size_t j = 0; j < books.size(); ++j) {
+                hawkes::run(books[j], queues[j], t_end, [&](const hawkes::Record& r) { st.add_event(r); });
+                st.add_book(books[j].book());
+            }
+            part[k & 1][w] = st;
+            // Buffer k & 1 is next written in interval k + 2, which no worker
+            // starts before the calling thread has merged it and reached the
+            // barrier of interval k + 1.
+            barrier.wait();
+            if (w == 0) {
+                Stats all;
+                for (const Stats& s : part[k & 1]) all.merge(s);
+                report(k, t_end, all);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 1; w < n_thr; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& th : pool) th.join();
+    return n_thr;
+}
+
+} // namespace shard
@@ -0,0 +1,652 @@
+#pragma once
+
+// Loader for history exported from MetaTrader 5 (Symbols > Bars / Ticks > Export),
+// so the C++ ports can replay the same data as their .mq5 counterparts.
+// Header-only, POSIX (open / mmap).
+//
+// Accepted input (the two MT5 export layouts):
+//   <DATE>  <TIME>      <OPEN>  <HIGH>  <LOW>   <CLOSE> <TICKVOL> <VOL> <SPREAD>
+//   2024.01.02  00:05:00    1.10452 1.10470 1.10441 1.10463 312 0 2
+//   <DATE>  <TIME>          <BID>   <ASK>   <LAST>  <VOLUME> <FLAGS>
+//   2024.01.02  00:00:00.123    1.10452 1.10460             6
+// The separator (tab, comma or semicolon) is taken from the first line. Columns are
+// matched by header name, so extra or reordered columns are fine; without a header
+// the order above is assumed. Date and time may share one field ("2024.01.02 00:05"),
+// the date separator may be '.', '-' or '/'. LF or CRLF, optional UTF-8 BOM; UTF-16LE
+// files (the terminal's default encoding for FileOpen CSVs) are narrowed to ASCII first.
+// Tick exports leave unchanged prices empty: they are carried forward from the
+// previous row. Times are the terminal's server time, as exported.
+//
+// Parsing: the file is mapped once, an AVX2 pass counts the line ends so every output
+// array is sized up front, then each 64-byte window is turned into one bitmask of
+// separators / line ends and fields are visited by bit scans, without a per-character
+// delimiter test. Prices are read as an integer mantissa plus a fraction digit count
+// and converted with one division by an exact power of ten, which is correctly rounded
+// (bit-identical to strtod) up to 15 significant digits; longer or exponent forms
+// fall back to strtod. Timestamps are fixed-position digit arithmetic plus a
+// days-from-civil conversion. Bad characters are OR-ed into a per-line flag and
+// checked once per line. Large files are split into line-aligned chunks parsed on
+// several threads, each writing its own rows.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace mt5 {
+
+// OHLCV bars, one array per field (index = bar).
+struct Bars {
+    std::vector<int64_t> time;          // seconds since 1970-01-01 (server time)
+    std::vector<double>  open, high, low, close;
+    std::vector<int64_t> tick_volume, volume;
+    std::vector<int32_t> spread;        // points
+
+    size_t size() const { return time.size(); }
+    void resize(size_t n) {
+        time.resize(n); open.resize(n); high.resize(n); low.resize(n); close.resize(n);
+        tick_volume.resize(n); volume.resize(n); spread.resize(n);
+    }
+};
+
+// Ticks, one array per field (index = tick).
+struct Ticks {
+    std::vector<int64_t> time_ms;       // milliseconds since 1970-01-01 (server time)
+    std::vector<double>  bid, ask, last, volume;
+    std::vector<int32_t> flags;
+
+    size_t size() const { return time_ms.size(); }
+    void resize(size_t n) {
+        time_ms.resize(n); bid.resize(n); ask.resize(n); last.resize(n); volume.resize(n); flags.resize(n);
+    }
+};
+
+enum class Kind { Unknown, Bars, Ticks };
+
+// --- Scalar field parsers ([p, e) ranges, no terminator needed)
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil).
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+inline unsigned digit(char c) { return (unsigned)(unsigned char)c - '0'; }
+
+inline bool parse_time_of_day(const char* p, const char* e, int64_t& ms);
+
+// "YYYY.MM.DD" (or '-' / '/'), optionally followed by ' ' and a time. Returns ms since
+// epoch in `ms`; false on malformed input.
+inline bool parse_datetime(const char* p, const char* e, int64_t& ms) {
+    if (e - p < 10) return false;
+    const unsigned y0 = digit(p[0]), y1 = digit(p[1]), y2 = digit(p[2]), y3 = digit(p[3]);
+    const unsigned m0 = digit(p[5]), m1 = digit(p[6]), d0 = digit(p[8]), d1 = digit(p[9]);
+    const bool bad = (y0 > 9) | (y1 > 9) | (y2 > 9) | (y3 > 9) | (m0 > 9) | (m1 > 9) | (d0 > 9) | (d1 > 9);
+    const char s1 = p[4], s2 = p[7];
+    const bool sep_ok = (s1 == '.' || s1 == '-' || s1 == '/') && s2 == s1;
+    const unsigned mon = m0 * 10 + m1, day = d0 * 10 + d1;
+    if (bad || !sep_ok || mon - 1 > 11 || day - 1 > 30) return false;
+    ms = days_from_civil(y0 * 1000 + y1 * 100 + y2 * 10 + y3, mon, day) * 86400000;
+    if (e - p == 10) return true;
+    if (p[10] != ' ' && p[10] != 'T') return false;
+    int64_t tod = 0;
+    if (!parse_time_of_day(p + 11, e, tod)) return false;
+    ms += tod;
+    return true;
+}
+
+// "HH:MM", "HH:MM:SS" or "HH:MM:SS.fff" (extra fraction digits are truncated to ms).
+inline bool parse_time_of_day(const char* p, const char* e, int64_t& ms) {
+    const ptrdiff_t n = e - p;
+    if (n < 5 || p[2] != ':') return false;
+    bool bad = (digit(p[0]) > 9) | (digit(p[1]) > 9) | (digit(p[3]) > 9) | (digit(p[4]) > 9);
+    int64_t s = (int64_t)(digit(p[0]) * 10 + digit(p[1])) * 3600 + (digit(p[3]) * 10 + digit(p[4])) * 60;
+    int64_t frac = 0;
+    if (n > 5) {
+        if (n < 8 || p[5] != ':') return false;
+        bad |= (digit(p[6]) > 9) | (digit(p[7]) > 9);
+        s += digit(p[6]) * 10 + digit(p[7]);
+        if (n > 8) {
+            if (p[8] != '.' || n == 9) return false;
+            int scale = 100;
+            for (const char* q = p + 9; q < e; ++q) {
+                bad |= digit(*q) > 9;
+                frac += scale * (int64_t)(digit(*q) % 10);
+                scale /= 10;
+            }
+        }
+    }
+    ms = s * 1000 + frac;
+    return !bad;
+}
+
+// Exact powers of ten: (double)m / kPow10[k] is a single correctly rounded operation.
+constexpr double kPow10[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Long mantissas, exponents, garbage: let strtod decide. Kept out of line so the fast
+// paths do not pay for its stack buffer.
+#if defined(__GNUC__)
+__attribute__((noinline, cold))
+#endif
+inline bool parse_decimal_strtod(const char* s, const char* e, double& out) {
+    char buf[64];
+    const size_t n = (size_t)(e - s);
+    if (n == 0 || n >= sizeof(buf)) return false;
+    std::memcpy(buf, s, n);
+    buf[n] = '\0';
+    char* end = nullptr;
+    out = std::strtod(buf, &end);
+    return end == buf + n;
+}
+
+// Decimal number ("-12.345", "7", ".5"). An empty field is not a number.
+inline bool parse_decimal(const char* p, const char* e, double& out) {
+    const char* s = p;
+    const bool neg = p < e && *p == '-';
+    p += (p < e && (*p == '-' || *p == '+'));
+    uint64_t m = 0;
+    int digits = 0, frac = 0, dots = 0;
+    for (; p < e; ++p) {
+        const unsigned d = digit(*p);
+        if (d < 10) {
+            m = m * 10 + d;
+            ++digits;
+            frac += dots;
+        } else if (*p == '.') {
+            ++dots;
+        } else {
+            break;
+        }
+    }
+    if (p == e && digits > 0 && digits <= 15 && dots <= 1) {
+        const double v = (double)m / kPow10[frac];
+        out = neg ? -v : v;
+        return true;
+    }
+    return parse_decimal_strtod(s, e, out);
+}
+
+// --- Structural scan
+
+// Number of '\n' in [p, p + n).
+inline size_t count_lines(const char* p, size_t n) {
+    size_t i = 0, c = 0;
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        c += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+    }
+#endif
+    for (; i < n; ++i) c += p[i] == '\n';
+    return c;
+}
+
+// Yields, in order, the positions of every separator and line end of a buffer.
+// One 64-bit mask per 64-byte window; each call pops its lowest set bit.
+class Splitter {
+public:
+    Splitter(const char* p, size_t n, char sep, size_t start) : p_(p), n_(n), sep_(sep) {
+        win_ = start & ~(size_t)63;
+        mask_ = classify(win_) & (~0ull << (start - win_));
+    }
+
+    // Next delimiter position, or n when the buffer is exhausted.
+    size_t next() {
+        while (mask_ == 0) {
+            win_ += 64;
+            if (win_ >= n_) return n_;
+            mask_ = classify(win_);
+        }
+        const size_t pos = win_ + (size_t)__builtin_ctzll(mask_);
+        mask_ &= mask_ - 1;
+        return pos;
+    }
+
+private:
+    uint64_t classify(size_t w) const {
+        if (w + 64 <= n_) {
+#if defined(__AVX2__)
+            const __m256i s = _mm256_set1_epi8(sep_), nl = _mm256_set1_epi8('\n');
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_ + w));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_ + w + 32));
+            uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(a, s), _mm256_cmpeq_epi8(a, nl)));
+            uint32_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(b, s), _mm256_cmpeq_epi8(b, nl)));
+            return (uint64_t)lo | ((uint64_t)hi << 32);
+#endif
+        }
+        uint64_t m = 0;
+        const size_t end = std::min(w + 64, n_);
+        for (size_t i = w; i < end; ++i)
+            m |= (uint64_t)(p_[i] == sep_ || p_[i] == '\n') << (i - w);
+        return m;
+    }
+
+    const char* p_;
+    size_t n_;
+    char sep_;
+    size_t win_ = 0;
+    uint64_t mask_ = 0;
+};
+
+// --- Loader
+
+// Loads whole files. Inputs above a few MB are cut into line-aligned chunks that are
+// parsed in parallel, each straight into its final rows; results do not depend on
+// the thread count.
+class Loader {
+public:
+    // threads = 0: one per hardware thread. Chunks are at least min_chunk bytes.
+    explicit Loader(int threads = 0, size_t min_chunk = 4 << 20)
+        : threads_(threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency())),
+          min_chunk_(std::max<size_t>(min_chunk, 1)) {}
+
+    bool load(const std::string& path, Bars& out) { return load_file(path, out); }
+    bool load(const std::string& path, Ticks& out) { return load_file(path, out); }
+
+    // Same, from a buffer already in memory.
+    bool parse(const char* p, size_t n, Bars& out) { return parse_any(p, n, out); }
+    bool parse(const char* p, size_t n, Ticks& out) { return parse_any(p, n, out); }
+
+    // Bars or ticks, from the header line (Unknown if there is none).
+    Kind detect(const std::string& path) {
+        Mapped f;
+        if (!map(path, f)) return Kind::Unknown;
+        const char* p = f.p;
+        size_t n = f.n;
+        std::string wide;
+        narrow_if_utf16(p, n, wide);
+        skip_bom(p, n);
+        char sep = '\t';
+        bool header = false;
+        std::vector<int> roles;
+        read_header(p, n, sep, roles, header);
+        if (!header) return Kind::Unknown;
+        if (std::find(roles.begin(), roles.end(), BID) != roles.end()) return Kind::Ticks;
+        if (std::find(roles.begin(), roles.end(), OPEN) != roles.end()) return Kind::Bars;
+        return Kind::Unknown;
+    }
+
+    const std::string& error() const { return error_; }
+    uint64_t bytes() const { return bytes_; }       // size of the last parsed input
+    int threads() const { return threads_; }
+
+private:
+    enum Role : int { SKIP, DATE, TIME, OPEN, HIGH, LOW, CLOSE, TICKVOL, VOL, SPREAD, BID, ASK, LAST, FLAGS, N_ROLES };
+
+    struct Mapped {
+        const char* p = nullptr;
+        size_t n = 0;
+        ~Mapped() { if (p && n) ::munmap(const_cast<char*>(p), n); }
+    };
+
+    // A line-aligned byte range [begin, end) and where its rows go.
+    struct Chunk {
+        size_t begin = 0, end = 0;
+        size_t row_begin = 0, rows = 0;     // first output row, rows written
+        size_t line_begin = 0;              // file line number of the first line
+        size_t bad_line = 0;                // first malformed line, 0 if none
+    };
+
+    bool fail(const std::string& msg) {
+        error_ = msg;
+        return false;
+    }
+
+    bool map(const std::string& path, Mapped& f) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return fail("cannot stat " + path);
+        }
+        f.n = (size_t)st.st_size;
+        if (f.n == 0) {
+            ::close(fd);
+            return fail(path + ": empty file");
+        }
+        void* m = ::mmap(nullptr, f.n, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED) return fail("cannot map " + path);
+        ::madvise(m, f.n, MADV_SEQUENTIAL);
+        f.p = static_cast<const char*>(m);
+        return true;
+    }
+
+    template <class Out>
+    bool load_file(const std::string& path, Out& out) {
+        Mapped f;
+        if (!map(path, f)) return false;
+        if (parse_any(f.p, f.n, out)) return true;
+        error_ = path + ": " + error_;
+        return false;
+    }
+
+    // UTF-16LE (BOM FF FE) to one byte per character; non-ASCII becomes '?'.
+    static void narrow_if_utf16(const char*& p, size_t& n, std::string& buf) {
+        if (n < 2 || (unsigned char)p[0] != 0xFF || (unsigned char)p[1] != 0xFE) return;
+        buf.resize((n - 2) / 2);
+        for (size_t i = 0; i < buf.size(); ++i) {
+            unsigned c = (unsigned char)p[2 + 2 * i] | ((unsigned)(unsigned char)p[3 + 2 * i] << 8);
+            buf[i] = c < 128 ? (char)c : '?';
+        }
+        p = buf.data();
+        n = buf.size();
+    }
+
+    static void skip_bom(const char*& p, size_t& n) {
+        if (n >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+            p += 3;
+            n -= 3;
+        }
+    }
+
+    static Role role_of(std::string name) {
+        name.erase(std::remove_if(name.begin(), name.end(), [](char c) {
+            return c == '<' || c == '>' || c == ' ' || c == '"' || c == '\r';
+        }), name.end());
+        for (char& c : name) c = (char)std::toupper((unsigned char)c);
+        if (name == "DATE" || name == "DATETIME" || name == "TIMESTAMP") return DATE;
+        if (name == "TIME") return TIME;
+        if (name == "OPEN") return OPEN;
+        if (name == "HIGH") return HIGH;
+        if (name == "LOW") return LOW;
+        if (name == "CLOSE") return CLOSE;
+        if (name == "TICKVOL" || name == "TICK_VOLUME") return TICKVOL;
+        if (name == "VOL" || name == "VOLUME" || name == "REAL_VOLUME") return VOL;
+        if (name == "SPREAD") return SPREAD;
+        if (name == "BID") return BID;
+        if (name == "ASK") return ASK;
+        if (name == "LAST") return LAST;
+        if (name == "FLAGS") return FLAGS;
+        return SKIP;
+    }
+
+    // Separator from the first line, column roles from the header if there is one.
+    // Returns the offset of the first data line.
+    static size_t read_header(const char* p, size_t n, char& sep, std::vector<int>& roles, bool& header) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', n));
+        const size_t len = nl ? (size_t)(nl - p) : n;
+        sep = '\t';
+        for (size_t i = 0; i < len; ++i)
+            if (p[i] == '\t' || p[i] == ',' || p[i] == ';') {
+                sep = p[i];
+                break;
+            }
+        header = len > 0 && (p[0] == '<' || std::isalpha((unsigned char)p[0]));
+        roles.clear();
+        if (!header) return 0;
+        size_t b = 0;
+        for (size_t i = 0; i <= len; ++i)
+            if (i == len || p[i] == sep) {
+                roles.push_back(role_of(std::string(p + b, i - b)));
+                b = i + 1;
+            }
+        return nl ? len + 1 : n;
+    }
+
+    // --- Row sinks: field values of one row into the output columns
+
+    static void store(Bars& b, size_t row, int64_t t_ms, const double* v) {
+        b.time[row] = t_ms / 1000;
+        b.open[row] = v[OPEN];
+        b.high[row] = v[HIGH];
+        b.low[row] = v[LOW];
+        b.close[row] = v[CLOSE];
+        b.tick_volume[row] = (int64_t)v[TICKVOL];
+        b.volume[row] = (int64_t)v[VOL];
+        b.spread[row] = (int32_t)v[SPREAD];
+    }
+
+    static void store(Ticks& k, size_t row, int64_t t_ms, const double* v) {
+        k.time_ms[row] = t_ms;
+        k.bid[row] = v[BID];
+        k.ask[row] = v[ASK];
+        k.last[row] = v[LAST];
+        k.volume[row] = v[VOL];
+        k.flags[row] = (int32_t)v[FLAGS];
+    }
+
+    template <class V>
+    static void move_rows(V& v, size_t dst, size_t src, size_t n) {
+        std::copy(v.begin() + src, v.begin() + src + n, v.begin() + dst);
+    }
+
+    static void move_rows(Bars& b, size_t dst, size_t src, size_t n) {
+        move_rows(b.time, dst, src, n);
+        move_rows(b.open, dst, src, n);
+        move_rows(b.high, dst, src, n);
+        move_rows(b.low, dst, src, n);
+        move_rows(b.close, dst, src, n);
+        move_rows(b.tick_volume, dst, src, n);
+        move_rows(b.volume, dst, src, n);
+        move_rows(b.spread, dst, src, n);
+    }
+
+    static void move_rows(Ticks& k, size_t dst, size_t src, size_t n) {
+        move_rows(k.time_ms, dst, src, n);
+        move_rows(k.bid, dst, src, n);
+        move_rows(k.ask, dst, src, n);
+        move_rows(k.last, dst, src, n);
+        move_rows(k.volume, dst, src, n);
+        move_rows(k.flags, dst, src, n);
+    }
+
+    // Parse the lines of one chunk into rows c.row_begin, c.row_begin + 1, ...
+    // Empty tick prices carry the previous row's value; at the start of a chunk other
+    // than the first that value is not known yet, so they are left NaN and patched
+    // once every chunk is done.
+    template <class Out>
+    static void parse_chunk(const char* p, char sep, const std::vector<int>& roles, bool first, Chunk& c, Out& out) {
+        constexpr bool ticks = std::is_same<Out, Ticks>::value;
+        double v[N_ROLES] = {};
+        if (ticks && !first) v[BID] = v[ASK] = v[LAST] = std::numeric_limits<double>::quiet_NaN();
+        int64_t date_ms = 0, time_ms = 0;
+        const int n_roles = (int)roles.size();
+
+        Splitter split(p, c.end, sep, c.begin);
+        size_t pos = c.begin, row = c.row_begin, line = c.line_begin;
+        while (pos < c.end) {
+            int f = 0;
+            bool bad = false, blank = false;
+            time_ms = 0;
+            v[VOL] = 0.0;
+            v[FLAGS] = 0.0;
+            for (;;) {
+                const size_t d = split.next();
+                size_t e = d;
+                e -= (e > pos && p[e - 1] == '\r');
+                const int role = f < n_roles ? roles[f] : SKIP;
+                if (role == DATE) {
+                    bad |= !parse_datetime(p + pos, p + e, date_ms);
+                } else if (role == TIME) {
+                    bad |= !parse_time_of_day(p + pos, p + e, time_ms);
+                } else if (role != SKIP) {
+                    if (e > pos) bad |= !parse_decimal(p + pos, p + e, v[role]);
+                    else         bad |= !ticks;
+                }
+                blank = (f == 0 && e == pos);
+                ++f;
+                pos = d + 1;
+                if (d >= c.end || p[d] == '\n') break;
+            }
+            if (f == 1 && blank) {
+                ++line;
+                continue;
+            }
+            if (bad || f < n_roles) {
+                c.bad_line = line;
+                break;
+            }
+            store(out, row++, date_ms + time_ms, v);
+            ++line;
+        }
+        c.rows = row - c.row_begin;
+    }
+
+    static void carry_forward(std::vector<double>& x, size_t begin, size_t end) {
+        for (size_t r = begin; r < end && std::isnan(x[r]); ++r) x[r] = r > 0 ? x[r - 1] : 0.0;
+    }
+
+    template <class Out>
+    bool parse_any(const char* p, size_t n, Out& out) {
+        constexpr bool ticks = std::is_same<Out, Ticks>::value;
+        error_.clear();
+        bytes_ = n;
+        std::string wide;
+        narrow_if_utf16(p, n, wide);
+        skip_bom(p, n);
+
+        char sep = '\t';
+        bool header = false;
+        std::vector<int> roles;
+        const size_t start = read_header(p, n, sep, roles, header);
+        if (!header) {
+            if (ticks) roles = {DATE, TIME, BID, ASK, LAST, VOL, FLAGS};
+            else       roles = {DATE, TIME, OPEN, HIGH, LOW, CLOSE, TICKVOL, VOL, SPREAD};
+        }
+        auto has = [&](int r) { return std::find(roles.begin(), roles.end(), r) != roles.end(); };
+        if (!has(DATE)) return fail("no <DATE> column");
+        if (!ticks && !(has(OPEN) && has(HIGH) && has(LOW) && has(CLOSE)))
+            return fail("bar file needs <OPEN> <HIGH> <LOW> <CLOSE>");
+        if (ticks && !(has(BID) || has(LAST)))
+            return fail("tick file needs <BID> or <LAST>");
+
+        // Line-aligned chunks, about four per thread for balance.
+        std::vector<Chunk> chunks;
+        const size_t body = n - start;
+        const size_t n_chunks = threads_ == 1 ? 1 : std::max<size_t>(1, std::min<size_t>(body / min_chunk_, 4 * (size_t)threads_));
+        size_t b = start;
+        for (size_t k = 1; k <= n_chunks && b < n; ++k) {
+            size_t e = k == n_chunks ? n : std::max(b, start + body / n_chunks * k);
+            if (e < n) {
+                const char* nl = static_cast<const char*>(std::memchr(p + e, '\n', n - e));
+                e = nl ? (size_t)(nl - p) + 1 : n;
+            }
+            Chunk c;
+            c.begin = b;
+            c.end = e;
+            chunks.push_back(c);
+            b = e;
+        }
+
+        // Lines per chunk give each chunk its first row (an upper bound: blank lines
+        // are squeezed out afterwards) and its first line number.
+        std::vector<size_t> lines(chunks.size());
+        run_chunks(chunks.size(), [&](size_t k) { lines[k] = count_lines(p + chunks[k].begin, chunks[k].end - chunks[k].begin); });
+        size_t rows = 0, line = header ? 2 : 1;
+        for (size_t k = 0; k < chunks.size(); ++k) {
+            chunks[k].row_begin = rows;
+            chunks[k].line_begin = line;
+            const bool open_end = chunks[k].end == n && n > 0 && p[n - 1] != '\n';
+            rows += lines[k] + open_end;
+            line += lines[k];
+        }
+        out.resize(rows);
+
+        run_chunks(chunks.size(), [&](size_t k) { parse_chunk(p, sep, roles, k == 0, chunks[k], out); });
+
+        size_t row = 0;
+        for (Chunk& c : chunks) {
+            if (c.bad_line) {
+                out.resize(0);
+                return fail("malformed line " + std::to_string(c.bad_line));
+            }
+            if (row != c.row_begin) move_rows(out, row, c.row_begin, c.rows);
+            c.row_begin = row;
+            row += c.rows;
+        }
+        out.resize(row);
+        if constexpr (ticks) {
+            for (size_t k = 1; k < chunks.size(); ++k) {
+                const size_t e = chunks[k].row_begin + chunks[k].rows;
+                carry_forward(out.bid, chunks[k].row_begin, e);
+                carry_forward(out.ask, chunks[k].row_begin, e);
+                carry_forward(out.last, chunks[k].row_begin, e);
+            }
+        }
+        return true;
+    }
+
+    // fn(k) for every chunk, on up to threads_ threads (the caller works too).
+    template <class Fn>
+    void run_chunks(size_t n, Fn fn) {
+        const int extra = (int)std::min<size_t>(n, (size_t)threads_) - 1;
+        if (extra <= 0) {
+            for (size_t k = 0; k < n; ++k) fn(k);
+            return;
+        }
+        std::atomic<size_t> next{0};
+        auto work = [&]() {
+            for (size_t k; (k = next.fetch_add(1)) < n;) fn(k);
+        };
+        std::vector<std::thread> pool;
+        for (int t = 0; t < extra; ++t) pool.emplace_back(work);
+        work();
+        for (auto& th : pool) th.join();
+    }
+
+    int threads_;
+    size_t min_chunk_;
+    std::string error_;
+    uint64_t bytes_ = 0;
+};
+
+// --- One-call loading for the strategy programs (default Loader, all threads).
+// Each returns false with the loader's message in `error`.
+
+inline bool load_bars(const std::string& path, Bars& bars, std::string& error) {
+    Loader ld;
+    if (ld.load(path, bars)) return true;
+    error = ld.error();
+    return false;
+}
+
+// Closes only.
+inline bool load_close(const std::string& path, std::vector<double>& close, std::string& error) {
+    Bars bars;
+    if (!load_bars(path, bars, error)) return false;
+    close = std::move(bars.close);
+    return true;
+}
+
+// OHLC into a program's own bar store: Store(n) sizes it, and its open / high /
+// low / close members are indexable arrays.
+template <class Store>
+bool load_ohlc(const std::string& path, Store& out, std::string& error) {
+    Bars bars;
+    if (!load_bars(path, bars, error)) return false;
+    out = Store((int)bars.size());
+    std::copy(bars.open.begin(), bars.open.end(), out.open.begin());
+    std::copy(bars.high.begin(), bars.high.end(), out.high.begin());
+    std::copy(bars.low.begin(), bars.low.end(), out.low.begin());
+    std::copy(bars.close.begin(), bars.close.end(), out.close.begin());
+    return true;
+}
+
+}  // namespace mt5
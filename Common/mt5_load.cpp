@@ -0,0 +1,403 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mt5_csv.hpp"
+#include "util.hpp"
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// "YYYY.MM.DD HH:MM:SS[.mmm]" of ms since epoch (UTC, same convention as the loader).
+static std::string format_time(int64_t ms, bool with_ms) {
+    time_t s = (time_t)(ms / 1000);
+    struct tm tm;
+    gmtime_r(&s, &tm);
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%04d.%02d.%02d %02d:%02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+                  tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    std::string out = buf;
+    if (with_ms) {
+        std::snprintf(buf, sizeof(buf), ".%03d", (int)(ms % 1000));
+        out += buf;
+    }
+    return out;
+}
+
+// --- Synthetic MT5 exports (tab-separated, CRLF, as written by the terminal)
+
+// M5 EURUSD-like bars, weekends skipped, 5 decimals.
+static std::string make_bars(uint64_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> N(0.0, 1.0);
+    std::string out = "<DATE>\t<TIME>\t<OPEN>\t<HIGH>\t<LOW>\t<CLOSE>\t<TICKVOL>\t<VOL>\t<SPREAD>\r\n";
+    out.reserve(n * 64 + 128);
+    int64_t t = 1704067200;     // 2024.01.01 00:00:00
+    double px = 1.10000;
+    char line[160];
+    for (uint64_t i = 0; i < n; ++i) {
+        while (((t / 86400) + 4) % 7 >= 5) t += 86400;   // 1970-01-01 was a Thursday
+        double o = px, c = o * std::exp(4e-4 * N(rng));
+        double h = std::max(o, c) * (1.0 + 1e-4 * std::fabs(N(rng)));
+        double l = std::min(o, c) * (1.0 - 1e-4 * std::fabs(N(rng)));
+        std::string ts = format_time(t * 1000, false);
+        ts[10] = '\t';
+        int len = std::snprintf(line, sizeof(line), "%s\t%.5f\t%.5f\t%.5f\t%.5f\t%d\t0\t%d\r\n", ts.c_str(), o, h, l, c,
+                                50 + (int)(rng() % 400), (int)(rng() % 12));
+        out.append(line, (size_t)len);
+        px = c;
+        t += 300;
+    }
+    return out;
+}
+
+// Ticks with millisecond times; a side that did not change is left empty, like the terminal does.
+static std::string make_ticks(uint64_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::string out = "<DATE>\t<TIME>\t<BID>\t<ASK>\t<LAST>\t<VOLUME>\t<FLAGS>\r\n";
+    out.reserve(n * 48 + 128);
+    int64_t t = 1704067200000LL;
+    int64_t bid = 110000, spread = 8;
+    char line[160], b[24], a[24];
+    for (uint64_t i = 0; i < n; ++i) {
+        t += 1 + rng() % 900;
+        unsigned r = rng();
+        bool bid_moves = r & 1, ask_moves = (r & 2) || !bid_moves;
+        if (bid_moves) bid += (int64_t)(r >> 8) % 5 - 2;
+        if (ask_moves) spread = 6 + (r >> 16) % 6;
+        b[0] = a[0] = '\0';
+        if (bid_moves) std::snprintf(b, sizeof(b), "%.5f", bid * 1e-5);
+        if (ask_moves) std::snprintf(a, sizeof(a), "%.5f", (bid + spread) * 1e-5);
+        std::string ts = format_time(t, true);
+        ts[10] = '\t';
+        int len = std::snprintf(line, sizeof(line), "%s\t%s\t%s\t\t\t%d\r\n", ts.c_str(), b, a,
+                                (bid_moves ? 2 : 0) | (ask_moves ? 4 : 0));
+        out.append(line, (size_t)len);
+    }
+    return out;
+}
+
+static bool write_text(const std::string& path, const std::string& text) {
+    std::ofstream f(path, std::ios::binary);
+    f.write(text.data(), (std::streamsize)text.size());
+    return (bool)f;
+}
+
+// --- Reference loader: getline + stringstream + stod + timegm (what the ports would
+// otherwise do). Bars only, tab-separated MT5 layout.
+static bool reference_bars(const std::string& text, mt5::Bars& out) {
+    std::istringstream in(text);
+    std::string line;
+    out = mt5::Bars();
+    std::getline(in, line);     // header
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        std::istringstream ls(line);
+        std::string date, time, f[7];
+        std::getline(ls, date, '\t');
+        std::getline(ls, time, '\t');
+        for (auto& s : f) std::getline(ls, s, '\t');
+        struct tm tm = {};
+        std::istringstream ds(date + " " + time);
+        ds >> std::get_time(&tm, "%Y.%m.%d %H:%M:%S");
+        if (ds.fail()) return false;
+        out.time.push_back((int64_t)timegm(&tm));
+        out.open.push_back(std::stod(f[0]));
+        out.high.push_back(std::stod(f[1]));
+        out.low.push_back(std::stod(f[2]));
+        out.close.push_back(std::stod(f[3]));
+        out.tick_volume.push_back(std::stoll(f[4]));
+        out.volume.push_back(std::stoll(f[5]));
+        out.spread.push_back(std::stoi(f[6]));
+    }
+    return true;
+}
+
+static bool same_bars(const mt5::Bars& a, const mt5::Bars& b) {
+    return a.time == b.time && a.open == b.open && a.high == b.high && a.low == b.low && a.close == b.close &&
+           a.tick_volume == b.tick_volume && a.volume == b.volume && a.spread == b.spread;
+}
+
+static bool same_ticks(const mt5::Ticks& a, const mt5::Ticks& b) {
+    return a.time_ms == b.time_ms && a.bid == b.bid && a.ask == b.ask && a.last == b.last && a.volume == b.volume &&
+           a.flags == b.flags;
+}
+
+// --- Modes
+
+static int inspect(const std::string& path, int threads) {
+    mt5::Loader ld(threads);
+    const mt5::Kind kind = ld.detect(path);
+    auto t0 = std::chrono::steady_clock::now();
+    std::cout << std::fixed;
+    if (kind == mt5::Kind::Ticks) {
+        mt5::Ticks tk;
+        if (!ld.load(path, tk)) {
+            std::cerr << ld.error() << "\n";
+            return 1;
+        }
+        double dt = seconds_since(t0);
+        std::cout << path << ": " << tk.size() << " ticks";
+        if (tk.size())
+            std::cout << ", " << format_time(tk.time_ms.front(), true) << " -> " << format_time(tk.time_ms.back(), true)
+                      << std::setprecision(5) << ", last bid " << tk.bid.back() << " ask " << tk.ask.back();
+        std::cout << "\nParsed " << std::setprecision(1) << ld.bytes() / 1e6 << " MB in " << std::setprecision(4) << dt
+                  << "s (" << std::setprecision(2) << ld.bytes() / 1e9 / std::max(dt, 1e-12) << " GB/s, "
+                  << ld.threads() << " threads)\n";
+        return 0;
+    }
+    mt5::Bars bars;
+    if (!ld.load(path, bars)) {
+        std::cerr << ld.error() << "\n";
+        return 1;
+    }
+    double dt = seconds_since(t0);
+    std::cout << path << ": " << bars.size() << " bars";
+    if (bars.size()) {
+        auto lo = std::min_element(bars.low.begin(), bars.low.end());
+        auto hi = std::max_element(bars.high.begin(), bars.high.end());
+        std::cout << ", " << format_time(bars.time.front() * 1000, false) << " -> "
+                  << format_time(bars.time.back() * 1000, false) << std::setprecision(5) << ", low " << *lo
+                  << " high " << *hi << ", last close " << bars.close.back();
+    }
+    std::cout << "\nParsed " << std::setprecision(1) << ld.bytes() / 1e6 << " MB in " << std::setprecision(4) << dt
+              << "s (" << std::setprecision(2) << ld.bytes() / 1e9 / std::max(dt, 1e-12) << " GB/s, "
+              << ld.threads() << " threads)\n";
+    return 0;
+}
+
+static int gen(const std::string& path, uint64_t n, bool ticks) {
+    if (!write_text(path, ticks ? make_ticks(n, 7) : make_bars(n, 7))) {
+        std::cerr << "cannot write " << path << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << n << (ticks ? " ticks" : " bars") << " to " << path << "\n";
+    return 0;
+}
+
+// Loader vs. the iostream reference on the same bar file, then the tick file.
+static int bench(uint64_t n, const std::string& prefix, int threads) {
+    const std::string bar_path = prefix + "_bars.csv", tick_path = prefix + "_ticks.csv";
+    const std::string bar_text = make_bars(n, 7);
+    if (!write_text(bar_path, bar_text) || !write_text(tick_path, make_ticks(n, 7))) {
+        std::cerr << "cannot write " << prefix << "_*.csv\n";
+        return 1;
+    }
+
+    mt5::Loader ld(threads);
+    std::cout << "Loader threads: " << ld.threads() << "\n";
+    mt5::Bars bars, ref;
+    mt5::Ticks ticks;
+    double best_bars = 1e30, best_ticks = 1e30;
+    for (int rep = 0; rep < 3; ++rep) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!ld.load(bar_path, bars)) {
+            std::cerr << ld.error() << "\n";
+            return 1;
+        }
+        best_bars = std::min(best_bars, seconds_since(t0));
+        const uint64_t bar_bytes = ld.bytes();
+        t0 = std::chrono::steady_clock::now();
+        if (!ld.load(tick_path, ticks)) {
+            std::cerr << ld.error() << "\n";
+            return 1;
+        }
+        best_ticks = std::min(best_ticks, seconds_since(t0));
+        if (rep == 2) {
+            std::cout << std::fixed << std::setprecision(1);
+            std::cout << "bars : " << bars.size() << " rows, " << bar_bytes / 1e6 << " MB, best of 3 "
+                      << std::setprecision(4) << best_bars << "s (" << std::setprecision(2)
+                      << bar_bytes / 1e9 / best_bars << " GB/s)\n";
+            std::cout << "ticks: " << ticks.size() << " rows, " << std::setprecision(1) << ld.bytes() / 1e6
+                      << " MB, best of 3 " << std::setprecision(4) << best_ticks << "s (" << std::setprecision(2)
+                      << ld.bytes() / 1e9 / best_ticks << " GB/s)\n";
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (!reference_bars(bar_text, ref)) {
+        std::cerr << "reference parser failed\n";
+        return 1;
+    }
+    double dt_ref = seconds_since(t0);
+    std::cout << "bars via getline/stod/get_time: " << std::setprecision(4) << dt_ref << "s ("
+              << std::setprecision(3) << bar_text.size() / 1e9 / dt_ref << " GB/s), speedup x" << std::setprecision(1)
+              << dt_ref / best_bars << ", identical=" << (same_bars(bars, ref) ? "yes" : "NO") << "\n";
+    return same_bars(bars, ref) ? 0 : 1;
+}
+
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAIL " << what << "\n";
+            ++failures;
+        }
+    };
+
+    // Decimals: bit-identical to strtod on random mantissas of 1..15 digits (fast path)
+    // and 16..19 digits / exponent forms (fallback).
+    std::mt19937_64 rng(11);
+    int mismatches = 0;
+    for (int i = 0; i < 2000000; ++i) {
+        int digits = 1 + (int)(rng() % 19);
+        std::string s = (rng() & 1) ? "-" : "";
+        std::string m;
+        for (int k = 0; k < digits; ++k) m += (char)('0' + rng() % 10);
+        int dot = (int)(rng() % (digits + 1));
+        s += m.substr(0, dot) + "." + m.substr(dot);
+        if (i % 7 == 0) s.erase(s.find('.'), 1);
+        if (i % 11 == 0) s += "e-3";
+        double a = 0.0;
+        bool ok = mt5::parse_decimal(s.data(), s.data() + s.size(), a);
+        double b = std::strtod(s.c_str(), nullptr);
+        if (!ok || std::memcmp(&a, &b, sizeof(double)) != 0) {
+            if (mismatches++ < 5) std::cout << "  decimal mismatch on \"" << s << "\"\n";
+        }
+    }
+    expect(mismatches == 0, "decimals vs strtod (" + std::to_string(mismatches) + " mismatches)");
+    for (const char* bad : {"", "-", ".", "1.2.3", "12a", "abc", "1,5"}) {
+        double v = 0.0;
+        expect(!mt5::parse_decimal(bad, bad + std::strlen(bad), v), std::string("rejects \"") + bad + "\"");
+    }
+
+    // Timestamps vs gmtime round trip, 1970..2100, all three date separators.
+    mismatches = 0;
+    for (int i = 0; i < 200000; ++i) {
+        int64_t ms = (int64_t)(rng() % 4102444800000ULL);
+        std::string s = format_time(ms, true);
+        if (i % 3 == 1) { s[4] = s[7] = '-'; }
+        if (i % 3 == 2) { s[4] = s[7] = '/'; }
+        int64_t got = -1;
+        if (!mt5::parse_datetime(s.data(), s.data() + s.size(), got) || got != ms) {
+            if (mismatches++ < 5) std::cout << "  time mismatch on \"" << s << "\"\n";
+        }
+    }
+    expect(mismatches == 0, "timestamps (" + std::to_string(mismatches) + " mismatches)");
+    for (const char* bad : {"2024.13.01", "2024.01.32", "2024-01.01", "2024.01.0x", "2024.01.01 25", "2024.01.01 10:6"}) {
+        int64_t v = 0;
+        expect(!mt5::parse_datetime(bad, bad + std::strlen(bad), v), std::string("rejects \"") + bad + "\"");
+    }
+
+    // Whole files: a generated export against the iostream reference.
+    mt5::Loader ld;
+    {
+        std::string text = make_bars(20000, 3);
+        mt5::Bars a, b;
+        expect(ld.parse(text.data(), text.size(), a) && reference_bars(text, b) && same_bars(a, b),
+               "generated bars vs reference");
+    }
+
+    // Chunked parsing (4 threads, 4 KB chunks) against one pass: blank lines inside
+    // chunks, tick prices carried across chunk boundaries, error line numbers.
+    {
+        mt5::Loader one(1), many(4, 4096);
+        std::string bar_text = make_bars(20000, 5), tick_text = make_ticks(50000, 5);
+        for (size_t at : {100000, 400000, 900000}) bar_text.insert(bar_text.find('\n', at) + 1, "\r\n");
+        mt5::Bars a, b;
+        mt5::Ticks c, d;
+        expect(one.parse(bar_text.data(), bar_text.size(), a) && many.parse(bar_text.data(), bar_text.size(), b) &&
+               a.size() == 20000 && same_bars(a, b), "chunked bars");
+        expect(one.parse(tick_text.data(), tick_text.size(), c) && many.parse(tick_text.data(), tick_text.size(), d) &&
+               c.size() == 50000 && same_ticks(c, d), "chunked ticks");
+        bar_text[bar_text.find('\n', 700000) + 5] = 'x';
+        expect(!one.parse(bar_text.data(), bar_text.size(), a) && !many.parse(bar_text.data(), bar_text.size(), b) &&
+               one.error() == many.error(), "chunked error line (" + one.error() + " / " + many.error() + ")");
+    }
+
+    // Layout variants: all must give the same two bars.
+    const std::vector<std::pair<std::string, std::string>> variants = {
+        {"tab CRLF", "<DATE>\t<TIME>\t<OPEN>\t<HIGH>\t<LOW>\t<CLOSE>\t<TICKVOL>\t<VOL>\t<SPREAD>\r\n"
+                     "2024.03.01\t09:00:00\t1.08000\t1.08100\t1.07900\t1.08050\t120\t0\t3\r\n"
+                     "2024.03.01\t09:05:00\t1.08050\t1.08200\t1.08000\t1.08150\t90\t0\t2\r\n"},
+        {"comma LF, no final newline", "<DATE>,<TIME>,<OPEN>,<HIGH>,<LOW>,<CLOSE>,<TICKVOL>,<VOL>,<SPREAD>\n"
+                     "2024.03.01,09:00,1.08,1.081,1.079,1.0805,120,0,3\n"
+                     "2024.03.01,09:05,1.0805,1.082,1.08,1.0815,90,0,2"},
+        {"semicolon, one datetime field, reordered", "Date;Close;Open;High;Low;Extra\n"
+                     "2024-03-01 09:00:00;1.08050;1.08000;1.08100;1.07900;x\n"
+                     "2024-03-01 09:05:00;1.08150;1.08050;1.08200;1.08000;y\n\n\n"},
+        {"no header", "2024.03.01\t09:00:00\t1.08000\t1.08100\t1.07900\t1.08050\t120\t0\t3\n"
+                     "2024.03.01\t09:05:00\t1.08050\t1.08200\t1.08000\t1.08150\t90\t0\t2\n"},
+        {"UTF-8 BOM", "\xEF\xBB\xBF<DATE>\t<TIME>\t<OPEN>\t<HIGH>\t<LOW>\t<CLOSE>\n"
+                     "2024.03.01\t09:00:00\t1.08000\t1.08100\t1.07900\t1.08050\n"
+                     "2024.03.01\t09:05:00\t1.08050\t1.08200\t1.08000\t1.08150\n"},
+    };
+    std::vector<std::pair<std::string, std::string>> all = variants;
+    {
+        std::string wide = "\xFF\xFE";
+        for (char c : variants[0].second) { wide += c; wide += '\0'; }
+        all.push_back({"UTF-16LE", wide});
+    }
+    for (const auto& v : all) {
+        mt5::Bars b;
+        bool ok = ld.parse(v.second.data(), v.second.size(), b);
+        ok = ok && b.size() == 2 && b.time[0] == 1709283600 && b.time[1] == 1709283900 && b.open[0] == 1.08 &&
+             b.high[1] == 1.082 && b.low[0] == 1.079 && b.close[1] == 1.0815;
+        expect(ok, "layout: " + v.first + (ok ? "" : " (" + ld.error() + ")"));
+    }
+
+    // Ticks: empty prices carry forward, empty volume / flags read as 0.
+    {
+        const std::string text = "<DATE>\t<TIME>\t<BID>\t<ASK>\t<LAST>\t<VOLUME>\t<FLAGS>\r\n"
+                                 "2024.03.01\t09:00:00.125\t1.08000\t1.08010\t\t\t6\r\n"
+                                 "2024.03.01\t09:00:00.300\t1.08002\t\t\t\t2\r\n"
+                                 "2024.03.01\t09:00:01\t\t1.08015\t\t\t\r\n";
+        mt5::Ticks t;
+        bool ok = ld.parse(text.data(), text.size(), t) && t.size() == 3;
+        ok = ok && t.time_ms[0] == 1709283600125LL && t.time_ms[2] == 1709283601000LL && t.bid[2] == 1.08002 &&
+             t.ask[1] == 1.0801 && t.ask[2] == 1.08015 && t.flags[1] == 2 && t.flags[2] == 0 && t.last[0] == 0.0;
+        expect(ok, "ticks carry-forward");
+        mt5::Bars b;
+        expect(ld.detect("/nonexistent") == mt5::Kind::Unknown && !ld.parse(text.data(), text.size(), b),
+               "tick file rejected as bars");
+    }
+
+    // Errors carry the line number.
+    {
+        const std::string text = "<DATE>\t<TIME>\t<OPEN>\t<HIGH>\t<LOW>\t<CLOSE>\n"
+                                 "2024.03.01\t09:00:00\t1.08\t1.081\t1.079\t1.0805\n"
+                                 "2024.03.01\t09:05:00\t1.08\t1.081\t\t1.0805\n";
+        mt5::Bars b;
+        expect(!ld.parse(text.data(), text.size(), b) && ld.error() == "malformed line 3", "error line number");
+    }
+
+    std::cout << (failures == 0 ? "All checks passed\n" : "Checks FAILED\n");
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "check") return run_check();
+    uint64_t threads;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    if (mode == "bench")
+        return bench(util::arg_u64(argc, argv, "n", 5000000),
+                     util::arg_string(argc, argv, "path", "mt5_bench"), (int)threads);
+    if (mode == "gen" && argc > 2) {
+        bool ticks = false;
+        for (int a = 3; a < argc; ++a) ticks |= std::string(argv[a]) == "ticks";
+        return gen(argv[2], util::arg_u64(argc, argv, "n", 1000000), ticks);
+    }
+    if (!mode.empty() && mode != "gen") return inspect(mode, (int)threads);
+
+    std::cerr << "Usage: mt5_load FILE [threads=N] | mt5_load gen FILE [n=1000000] [ticks] | "
+                 "mt5_load bench [n=5000000] [path=mt5_bench] [threads=N] | mt5_load check\n";
+    return 1;
+}
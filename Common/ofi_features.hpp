@@ -0,0 +1,201 @@
+#pragma once
+
+// Incremental order-flow features for a universe of books. Header-only.
+//
+// Per symbol:
+// - imbalance: top-of-book queue imbalance (B0 - A0) / (B0 + A0);
+// - depth imbalance: the same over the top L levels, level l weighted by
+//   w_l = exp(-depth_decay * l);
+// - OFI (Cont, Kukanov & Stoikov, 2014): net order flow at the touch, from the
+//   changes of the best levels between consecutive book states,
+//       e = 1{b >= b'} qb - 1{b <= b'} qb' - 1{a <= a'} qa + 1{a >= a'} qa'
+//   (primes: previous state), i.e. bid queue growth, bid price moves and
+//   depletions count as buying pressure, and symmetrically on the ask side;
+// - multi-level OFI: the same e_l at every level l (l-th best bid / ask),
+//   combined with the depth weights w_l;
+// - both OFIs as exponentially decayed sums over several horizons tau_h.
+//
+// update() runs on every book event of a symbol in O(levels): it computes the
+// OFI contributions against the previous levels of that symbol, stores the new
+// levels and adds the contributions to per-symbol accumulators. refresh(dt)
+// then advances the whole universe at once: the decayed sums become
+// S_h = S_h exp(-dt / tau_h) + accumulated flow, and the imbalances are
+// recomputed from the stored levels. Events between two refreshes are thus
+// weighted equally (the decay is applied per refresh interval, exact when
+// refreshing on a fixed clock).
+//
+// Everything is laid out as structure of arrays, one contiguous row of
+// symbols per level / horizon (row stride rounded up to 4), so refresh() is
+// a few streaming passes that AVX2 does four symbols at a time.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "order_book.hpp"
+
+namespace ofi {
+
+constexpr int kMaxLevels = 16;
+constexpr int kMaxHorizons = 8;
+
+struct Config {
+    int levels = 5;                        // book levels per side (<= kMaxLevels)
+    double depth_decay = 0.5;              // w_l = exp(-depth_decay * l)
+    std::vector<double> horizons = {1.0, 10.0, 60.0};   // decay times, s (<= kMaxHorizons)
+};
+
+class Engine {
+public:
+    Engine(size_t n_symbols, const Config& cfg)
+        : cfg_(cfg), n_(n_symbols), stride_((n_symbols + 3) / 4 * 4),
+          levels_(std::min(std::max(cfg.levels, 1), kMaxLevels)),
+          horizons_(std::min((int)cfg.horizons.size(), kMaxHorizons)) {
+        for (int l = 0; l < levels_; ++l) w_[l] = std::exp(-cfg.depth_decay * l);
+        const size_t lv = (size_t)levels_ * stride_, hz = (size_t)horizons_ * stride_;
+        bid_px_.assign(lv, lob::kNoBid);
+        ask_px_.assign(lv, lob::kNoAsk);
+        bid_qty_.assign(lv, 0.0);
+        ask_qty_.assign(lv, 0.0);
+        acc_top_.assign(stride_, 0.0);
+        acc_ml_.assign(stride_, 0.0);
+        ofi_.assign(hz, 0.0);
+        mlofi_.assign(hz, 0.0);
+        imb_.assign(stride_, 0.0);
+        dimb_.assign(stride_, 0.0);
+        seen_.assign(n_symbols, 0);
+    }
+
+    size_t symbols() const { return n_; }
+    int levels() const { return levels_; }
+    int horizons() const { return horizons_; }
+    double horizon(int h) const { return cfg_.horizons[h]; }
+    double weight(int l) const { return w_[l]; }
+
+    // Feature rows, one value per symbol, as of the last refresh().
+    const double* imbalance() const { return imb_.data(); }
+    const double* depth_imbalance() const { return dimb_.data(); }
+    const double* ofi(int h) const { return ofi_.data() + (size_t)h * stride_; }
+    const double* mlofi(int h) const { return mlofi_.data() + (size_t)h * stride_; }
+
+    // New top levels of symbol s (best first; nb / na of them exist). The
+    // first call for a symbol only records its book.
+    void update(size_t s, const int64_t* bid_px, const int64_t* bid_qty, int nb,
+                const int64_t* ask_px, const int64_t* ask_qty, int na) {
+        double top = 0.0, ml = 0.0;
+        for (int l = 0; l < levels_; ++l) {
+            const size_t k = (size_t)l * stride_ + s;
+            const int64_t b = l < nb ? bid_px[l] : lob::kNoBid, a = l < na ? ask_px[l] : lob::kNoAsk;
+            const double qb = l < nb ? (double)bid_qty[l] : 0.0, qa = l < na ? (double)ask_qty[l] : 0.0;
+            const int64_t b0 = bid_px_[k], a0 = ask_px_[k];
+            const double qb0 = bid_qty_[k], qa0 = ask_qty_[k];
+            const double e = (b >= b0 ? qb : 0.0) - (b <= b0 ? qb0 : 0.0) - (a <= a0 ? qa : 0.0) + (a >= a0 ? qa0 : 0.0);
+            if (l == 0) top = e;
+            ml += w_[l] * e;
+            bid_px_[k] = b;
+            ask_px_[k] = a;
+            bid_qty_[k] = qb;
+            ask_qty_[k] = qa;
+        }
+        if (!seen_[s]) {
+            seen_[s] = 1;
+            return;
+        }
+        acc_top_[s] += top;
+        acc_ml_[s] += ml;
+    }
+
+    void update(size_t s, const lob::Book& book) {
+        int64_t bp[kMaxLevels], bq[kMaxLevels], ap[kMaxLevels], aq[kMaxLevels];
+        const int nb = book.top_levels(lob::Side::Buy, levels_, bp, bq);
+        const int na = book.top_levels(lob::Side::Sell, levels_, ap, aq);
+        update(s, bp, bq, nb, ap, aq, na);
+    }
+
+    // Advances every symbol by dt seconds: folds the flow accumulated since
+    // the last refresh into the decayed sums, recomputes the imbalances.
+    void refresh(double dt) {
+#if defined(__AVX2__)
+        double decay[kMaxHorizons];
+        for (int h = 0; h < horizons_; ++h) decay[h] = std::exp(-dt / cfg_.horizons[h]);
+        const size_t S = stride_;
+        for (size_t s = 0; s < S; s += 4) {
+            const __m256d top = _mm256_loadu_pd(&acc_top_[s]), ml = _mm256_loadu_pd(&acc_ml_[s]);
+            for (int h = 0; h < horizons_; ++h) {
+                const __m256d d = _mm256_set1_pd(decay[h]);
+                double* o = &ofi_[(size_t)h * S + s];
+                double* m = &mlofi_[(size_t)h * S + s];
+                _mm256_storeu_pd(o, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(o), d), top));
+                _mm256_storeu_pd(m, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(m), d), ml));
+            }
+            _mm256_storeu_pd(&acc_top_[s], _mm256_setzero_pd());
+            _mm256_storeu_pd(&acc_ml_[s], _mm256_setzero_pd());
+
+            __m256d diff = _mm256_setzero_pd(), sum = _mm256_setzero_pd();
+            for (int l = 0; l < levels_; ++l) {
+                const __m256d w = _mm256_set1_pd(w_[l]);
+                const __m256d qb = _mm256_loadu_pd(&bid_qty_[(size_t)l * S + s]);
+                const __m256d qa = _mm256_loadu_pd(&ask_qty_[(size_t)l * S + s]);
+                diff = _mm256_add_pd(diff, _mm256_mul_pd(w, _mm256_sub_pd(qb, qa)));
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(w, _mm256_add_pd(qb, qa)));
+                if (l == 0) _mm256_storeu_pd(&imb_[s], ratio(_mm256_sub_pd(qb, qa), _mm256_add_pd(qb, qa)));
+            }
+            _mm256_storeu_pd(&dimb_[s], ratio(diff, sum));
+        }
+#else
+        refresh_scalar(dt);
+#endif
+    }
+
+    // refresh() one symbol at a time, without SIMD (reference for checks).
+    void refresh_scalar(double dt) {
+        double decay[kMaxHorizons];
+        for (int h = 0; h < horizons_; ++h) decay[h] = std::exp(-dt / cfg_.horizons[h]);
+        const size_t S = stride_;
+        for (size_t s = 0; s < S; ++s) {
+            for (int h = 0; h < horizons_; ++h) {
+                ofi_[(size_t)h * S + s] = ofi_[(size_t)h * S + s] * decay[h] + acc_top_[s];
+                mlofi_[(size_t)h * S + s] = mlofi_[(size_t)h * S + s] * decay[h] + acc_ml_[s];
+            }
+            acc_top_[s] = acc_ml_[s] = 0.0;
+
+            double diff = 0.0, sum = 0.0;
+            for (int l = 0; l < levels_; ++l) {
+                const double qb = bid_qty_[(size_t)l * S + s], qa = ask_qty_[(size_t)l * S + s];
+                diff += w_[l] * (qb - qa);
+                sum += w_[l] * (qb + qa);
+                if (l == 0) imb_[s] = qb + qa > 0.0 ? (qb - qa) / (qb + qa) : 0.0;
+            }
+            dimb_[s] = sum > 0.0 ? diff / sum : 0.0;
+        }
+    }
+
+private:
+#if defined(__AVX2__)
+    // num / den where den > 0, else 0
+    static __m256d ratio(__m256d num, __m256d den) {
+        const __m256d pos = _mm256_cmp_pd(den, _mm256_setzero_pd(), _CMP_GT_OQ);
+        const __m256d safe = _mm256_blendv_pd(_mm256_set1_pd(1.0), den, pos);
+        return _mm256_and_pd(_mm256_div_pd(num, safe), pos);
+    }
+#endif
+
+    Config cfg_;
+    size_t n_, stride_;
+    int levels_, horizons_;
+    double w_[kMaxLevels];
+    std::vector<int64_t> bid_px_, ask_px_;        // [level][symbol]
+    std::vector<double> bid_qty_, ask_qty_;       // [level][symbol]
+    std::vector<double> acc_top_, acc_ml_;        // flow since the last refresh
+    std::vector<double> ofi_, mlofi_;             // [horizon][symbol]
+    std::vector<double> imb_, dimb_;
+    std::vector<uint8_t> seen_;
+};
+
+} // namespace ofi
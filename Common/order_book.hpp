@@ -0,0 +1,379 @@
+#pragma once
+
+// Full-depth limit order book: price levels on both sides, individual orders
+// with IDs, price-time (FIFO) priority. Header-only.
+//
+// Prices are integer ticks. Each side is a tick-indexed array of levels (Ladder)
+// with one occupancy bit per level, so the next non-empty level behind the touch
+// is found with a bit scan over 64 levels at a time. The array grows (and is
+// re-centered) when an order lands outside it; in steady state it does not move.
+//
+// Orders live in one pool (std::vector<Order>) and are linked into their level's
+// FIFO by pool index (intrusive prev / next), with freed slots kept on a free
+// list. Adding, cancelling, modifying and executing therefore allocate nothing
+// once the pool and the ladders have reached their working size (reserve them
+// up front with the constructor).
+//
+// An OrderId is (generation << 32) | pool slot: lookups are one array access,
+// and the generation, bumped when a slot is freed, turns IDs of dead orders
+// into misses instead of aliases.
+//
+// Matching: a buy order executes against asks from the lowest price up (sells
+// against bids from the highest down), each level oldest order first. Limit
+// orders that cross the spread execute up to their limit price and rest the
+// remainder; market orders never rest. Fills are reported through an optional
+// callback fill(maker_id, price, qty).
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace lob {
+
+enum class Side : uint8_t { Buy = 0, Sell = 1 };
+
+inline Side opposite(Side s) { return s == Side::Buy ? Side::Sell : Side::Buy; }
+
+using OrderId = uint64_t;
+constexpr OrderId kNoOrder = 0;
+constexpr uint32_t kNil = 0xFFFFFFFFu;
+constexpr int64_t kNoBid = std::numeric_limits<int64_t>::min();
+constexpr int64_t kNoAsk = std::numeric_limits<int64_t>::max();
+
+struct Order {
+    int64_t price = 0;              // ticks
+    int64_t qty = 0;                // remaining
+    uint32_t prev = kNil, next = kNil;   // FIFO links within the level (free list: next)
+    uint32_t gen = 1;               // generation of the slot
+    Side side = Side::Buy;
+    bool live = false;
+};
+
+struct Level {
+    int64_t qty = 0;                // total resting quantity
+    uint32_t head = kNil, tail = kNil;   // oldest / newest order
+    uint32_t count = 0;             // number of orders
+};
+
+// Result of an aggressive order.
+struct Exec {
+    int64_t filled = 0;             // executed quantity
+    int64_t notional = 0;           // sum of price * qty, in ticks
+};
+
+// Tick-indexed levels of one side plus their occupancy bitmap.
+class Ladder {
+public:
+    bool empty_range() const { return levels_.empty(); }
+    bool contains(int64_t px) const { return px >= base_ && px - base_ < (int64_t)levels_.size(); }
+
+    Level& at(int64_t px) { return levels_[(size_t)(px - base_)]; }
+    const Level& at(int64_t px) const { return levels_[(size_t)(px - base_)]; }
+
+    // Makes [lo, hi] addressable; the covered range at least doubles when it grows.
+    void cover(int64_t lo, int64_t hi) {
+        if (!levels_.empty() && contains(lo) && contains(hi)) return;
+        int64_t new_lo = lo, new_hi = hi;
+        if (!levels_.empty()) {
+            const int64_t size = (int64_t)levels_.size();
+            new_lo = std::min(new_lo, base_);
+            new_hi = std::max(new_hi, base_ + size - 1);
+            const int64_t grow = std::max<int64_t>(size, new_hi - new_lo + 1);
+            if (lo < base_) new_lo -= grow / 2;
+            if (hi >= base_ + size) new_hi += grow / 2;
+        } else {
+            new_lo -= kInitial / 2;
+            new_hi += kInitial / 2;
+        }
+        new_lo = floor64(new_lo);
+        const int64_t n = ((new_hi - new_lo + 1 + 63) / 64) * 64;
+
+        std::vector<Level> levels((size_t)n);
+        std::vector<uint64_t> bits((size_t)(n / 64), 0);
+        if (!levels_.empty()) {
+            const size_t shift = (size_t)(base_ - new_lo);   // multiple of 64
+            std::copy(levels_.begin(), levels_.end(), levels.begin() + shift);
+            std::copy(bits_.begin(), bits_.end(), bits.begin() + shift / 64);
+        }
+        levels_.swap(levels);
+        bits_.swap(bits);
+        base_ = new_lo;
+    }
+
+    void mark(int64_t px)   { const size_t i = (size_t)(px - base_); bits_[i >> 6] |=  (1ull << (i & 63)); }
+    void unmark(int64_t px) { const size_t i = (size_t)(px - base_); bits_[i >> 6] &= ~(1ull << (i & 63)); }
+
+    // Highest non-empty level <= px, or kNoBid.
+    int64_t highest_at_or_below(int64_t px) const {
+        if (levels_.empty() || px < base_) return kNoBid;
+        size_t i = (size_t)std::min<int64_t>(px - base_, (int64_t)levels_.size() - 1);
+        size_t w = i >> 6;
+        uint64_t word = bits_[w] & (~0ull >> (63 - (i & 63)));
+        while (true) {
+            if (word) return base_ + (int64_t)(w * 64 + 63 - __builtin_clzll(word));
+            if (w == 0) return kNoBid;
+            word = bits_[--w];
+        }
+    }
+
+    // Lowest non-empty level >= px, or kNoAsk.
+    int64_t lowest_at_or_above(int64_t px) const {
+        const int64_t size = (int64_t)levels_.size();
+        if (levels_.empty() || px - base_ >= size) return kNoAsk;
+        size_t i = (size_t)std::max<int64_t>(px - base_, 0);
+        size_t w = i >> 6;
+        uint64_t word = bits_[w] & (~0ull << (i & 63));
+        while (true) {
+            if (word) return base_ + (int64_t)(w * 64 + __builtin_ctzll(word));
+            if (++w == bits_.size()) return kNoAsk;
+            word = bits_[w];
+        }
+    }
+
+private:
+    static constexpr int64_t kInitial = 4096;
+    static int64_t floor64(int64_t x) { return x >= 0 ? x / 64 * 64 : -((-x + 63) / 64 * 64); }
+
+    std::vector<Level> levels_;
+    std::vector<uint64_t> bits_;
+    int64_t base_ = 0;
+};
+
+class Book {
+public:
+    explicit Book(size_t order_capacity = 1 << 16) { pool_.reserve(order_capacity); }
+
+    // Pre-sizes both ladders for prices in [lo, hi] (ticks).
+    void reserve_prices(int64_t lo, int64_t hi) {
+        side_[0].cover(lo, hi);
+        side_[1].cover(lo, hi);
+    }
+
+    // --- Queries
+    int64_t best_bid() const { return best_[0]; }
+    int64_t best_ask() const { return best_[1]; }
+    size_t order_count() const { return live_; }
+
+    // Resting quantity / order count at a price (0 if none).
+    int64_t depth(Side s, int64_t px) const {
+        const Ladder& l = side_[(int)s];
+        return l.contains(px) ? l.at(px).qty : 0;
+    }
+    uint32_t orders_at(Side s, int64_t px) const {
+        const Ladder& l = side_[(int)s];
+        return l.contains(px) ? l.at(px).count : 0;
+    }
+
+    // The order behind an ID, or nullptr once it is filled or cancelled.
+    const Order* find(OrderId id) const {
+        const uint32_t slot = (uint32_t)id;
+        if (slot >= pool_.size()) return nullptr;
+        const Order& o = pool_[slot];
+        return (o.live && o.gen == (uint32_t)(id >> 32)) ? &o : nullptr;
+    }
+
+    // Best n levels of a side, from the touch outwards; returns how many exist.
+    int top_levels(Side s, int n, int64_t* px, int64_t* qty) const {
+        const Ladder& l = side_[(int)s];
+        int k = 0;
+        for (int64_t p = best_[(int)s]; k < n && p != kNoBid && p != kNoAsk; ++k) {
+            px[k] = p;
+            qty[k] = l.at(p).qty;
+            p = (s == Side::Buy) ? l.highest_at_or_below(p - 1) : l.lowest_at_or_above(p + 1);
+        }
+        return k;
+    }
+
+    // Visits the orders of one level in priority order: fn(id, qty).
+    template <class Fn>
+    void for_each_order(Side s, int64_t px, Fn&& fn) const {
+        const Ladder& l = side_[(int)s];
+        if (!l.contains(px)) return;
+        for (uint32_t i = l.at(px).head; i != kNil; i = pool_[i].next) fn(id_of(i), pool_[i].qty);
+    }
+
+    // Last order in the queue of a level (kNoOrder if the level is empty).
+    OrderId newest(Side s, int64_t px) const {
+        const Ladder& l = side_[(int)s];
+        if (!l.contains(px) || l.at(px).tail == kNil) return kNoOrder;
+        return id_of(l.at(px).tail);
+    }
+
+    // --- Operations
+
+    // Limit order: executes against the other side up to `px`, rests the rest.
+    // Returns the ID of the resting order (kNoOrder if it filled completely).
+    template <class Fill>
+    OrderId add(Side s, int64_t px, int64_t qty, Fill&& fill) {
+        if (qty <= 0) return kNoOrder;
+        qty -= match(s, qty, px, fill).filled;
+        if (qty == 0) return kNoOrder;
+        const uint32_t i = alloc();
+        Order& o = pool_[i];
+        o.side = s;
+        o.price = px;
+        o.qty = qty;
+        rest(i);
+        return id_of(i);
+    }
+    OrderId add(Side s, int64_t px, int64_t qty) { return add(s, px, qty, [](OrderId, int64_t, int64_t) {}); }
+
+    bool cancel(OrderId id) {
+        const Order* o = find(id);
+        if (!o) return false;
+        const uint32_t i = (uint32_t)id;
+        unlink(i);
+        release(i);
+        return true;
+    }
+
+    // Same price and a smaller quantity keeps the order's place in the queue;
+    // anything else re-queues it at the back of its (new) level, executing first
+    // if the new price crosses. qty <= 0 cancels. The ID is kept; returns false
+    // if the order is gone.
+    template <class Fill>
+    bool modify(OrderId id, int64_t px, int64_t qty, Fill&& fill) {
+        const Order* po = find(id);
+        if (!po) return false;
+        if (qty <= 0) return cancel(id);
+        const uint32_t i = (uint32_t)id;
+        Order& o = pool_[i];
+        if (px == o.price && qty <= o.qty) {
+            side_[(int)o.side].at(px).qty -= o.qty - qty;
+            o.qty = qty;
+            return true;
+        }
+        unlink(i);
+        qty -= match(o.side, qty, px, fill).filled;
+        if (qty == 0) {
+            release(i);
+            return true;
+        }
+        o.price = px;
+        o.qty = qty;
+        rest(i);
+        return true;
+    }
+    bool modify(OrderId id, int64_t px, int64_t qty) {
+        return modify(id, px, qty, [](OrderId, int64_t, int64_t) {});
+    }
+
+    // Market order from the `taker` side: executes up to qty, never rests.
+    template <class Fill>
+    Exec market(Side taker, int64_t qty, Fill&& fill) {
+        return match(taker, qty, taker == Side::Buy ? kNoAsk : kNoBid, fill);
+    }
+    Exec market(Side taker, int64_t qty) { return market(taker, qty, [](OrderId, int64_t, int64_t) {}); }
+
+private:
+    OrderId id_of(uint32_t i) const { return ((OrderId)pool_[i].gen << 32) | i; }
+
+    uint32_t alloc() {
+        uint32_t i;
+        if (free_ != kNil) {
+            i = free_;
+            free_ = pool_[i].next;
+        } else {
+            i = (uint32_t)pool_.size();
+            pool_.emplace_back();
+        }
+        Order& o = pool_[i];
+        o.live = true;
+        o.prev = o.next = kNil;
+        ++live_;
+        return i;
+    }
+
+    void release(uint32_t i) {
+        Order& o = pool_[i];
+        o.live = false;
+        if (++o.gen == 0) o.gen = 1;   // id 0 stays invalid
+        o.next = free_;
+        free_ = i;
+        --live_;
+    }
+
+    // Appends order i at the back of its level.
+    void rest(uint32_t i) {
+        Order& o = pool_[i];
+        const int s = (int)o.side;
+        Ladder& l = side_[s];
+        l.cover(o.price, o.price);
+        Level& lv = l.at(o.price);
+        o.prev = lv.tail;
+        o.next = kNil;
+        if (lv.tail != kNil) pool_[lv.tail].next = i;
+        else {
+            lv.head = i;
+            l.mark(o.price);
+        }
+        lv.tail = i;
+        lv.qty += o.qty;
+        ++lv.count;
+        if (o.side == Side::Buy ? (best_[0] == kNoBid || o.price > best_[0])
+                                : (best_[1] == kNoAsk || o.price < best_[1]))
+            best_[s] = o.price;
+    }
+
+    // Removes order i from its level (the slot stays allocated).
+    void unlink(uint32_t i) {
+        Order& o = pool_[i];
+        const int s = (int)o.side;
+        Ladder& l = side_[s];
+        Level& lv = l.at(o.price);
+        if (o.prev != kNil) pool_[o.prev].next = o.next; else lv.head = o.next;
+        if (o.next != kNil) pool_[o.next].prev = o.prev; else lv.tail = o.prev;
+        lv.qty -= o.qty;
+        if (--lv.count == 0) level_emptied(s, o.price);
+    }
+
+    void level_emptied(int s, int64_t px) {
+        Ladder& l = side_[s];
+        l.unmark(px);
+        if (px == best_[s]) best_[s] = (s == 0) ? l.highest_at_or_below(px - 1) : l.lowest_at_or_above(px + 1);
+    }
+
+    // Executes up to qty from the `taker` side against the other side, at
+    // prices no worse than `limit`.
+    template <class Fill>
+    Exec match(Side taker, int64_t qty, int64_t limit, Fill& fill) {
+        Exec ex;
+        const int m = (int)opposite(taker);
+        Ladder& l = side_[m];
+        while (qty > 0) {
+            const int64_t px = best_[m];
+            if (px == kNoBid || px == kNoAsk) break;
+            if (taker == Side::Buy ? px > limit : px < limit) break;
+            Level& lv = l.at(px);
+            while (qty > 0 && lv.head != kNil) {
+                const uint32_t i = lv.head;
+                Order& o = pool_[i];
+                const int64_t take = std::min(qty, o.qty);
+                fill(id_of(i), px, take);
+                o.qty -= take;
+                lv.qty -= take;
+                qty -= take;
+                ex.filled += take;
+                ex.notional += take * px;
+                if (o.qty == 0) {
+                    lv.head = o.next;
+                    if (lv.head != kNil) pool_[lv.head].prev = kNil; else lv.tail = kNil;
+                    --lv.count;
+                    release(i);
+                }
+            }
+            if (lv.count == 0) level_emptied(m, px);
+        }
+        return ex;
+    }
+
+    std::vector<Order> pool_;
+    uint32_t free_ = kNil;
+    size_t live_ = 0;
+    Ladder side_[2];                 // [Buy] bids, [Sell] asks
+    int64_t best_[2] = {kNoBid, kNoAsk};
+};
+
+} // namespace lob
@@ -0,0 +1,221 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "async_writer.hpp"
+#include "ctr_rng.hpp"
+#include "util.hpp"
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream s;
+    s << in.rdbuf();
+    return s.str();
+}
+
+// A tick-like record: step, price, return, size.
+struct Tick {
+    int64_t t;
+    double price, ret;
+    int32_t qty;
+};
+
+// Reproducible records: a random walk on a 0.1 grid.
+class TickSource {
+public:
+    explicit TickSource(uint64_t seed) : rng_(seed, 0, 0) {}
+    Tick next() {
+        const double ret = 1e-3 * (rng_.uniform() - 0.5);
+        price_ *= 1.0 + ret;
+        return Tick{t_++, std::round(price_ * 10.0) / 10.0, ret, (int32_t)(1 + rng_.next_u32() % 500)};
+    }
+
+private:
+    ctr::Stream rng_;
+    double price_ = 100.0;
+    int64_t t_ = 0;
+};
+
+// --- Modes
+
+static int bench(uint64_t n, const std::string& path) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << n << " records (step, price, return, size) to " << path << ":\n";
+
+    auto report = [&](const char* name, double loop_secs, double total_secs, uint64_t bytes) {
+        std::cout << "  " << std::left << std::setw(22) << name << std::right << std::setw(7) << n / total_secs / 1e6
+                  << " M records/s";
+        if (bytes > 0) std::cout << ", " << std::setw(7) << bytes / total_secs / 1e6 << " MB/s";
+        if (loop_secs > 0.0) std::cout << "  (loop " << n / loop_secs / 1e6 << " M records/s)";
+        std::cout << "\n";
+    };
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "cannot create " << path << "\n";
+            return 1;
+        }
+        TickSource src(42);
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; ++i) {
+            const Tick k = src.next();
+            out << k.t << " " << k.price << " " << k.ret << " " << k.qty << "\n";
+        }
+        const uint64_t bytes = (uint64_t)out.tellp();
+        out.close();
+        report("std::ofstream text", 0.0, seconds_since(t0), bytes);
+    }
+    {
+        aout::Writer out;
+        if (!out.open(path)) {
+            std::cerr << out.error() << "\n";
+            return 1;
+        }
+        TickSource src(42);
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; ++i) {
+            const Tick k = src.next();
+            out << k.t << ' ' << k.price << ' ' << k.ret << ' ' << k.qty << '\n';
+        }
+        const double loop = seconds_since(t0);
+        const uint64_t bytes = out.bytes();
+        out.close();
+        report("aout::Writer text", loop, seconds_since(t0), bytes);
+    }
+    {
+        aout::Writer out;
+        if (!out.open(path)) {
+            std::cerr << out.error() << "\n";
+            return 1;
+        }
+        TickSource src(42);
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; ++i) out.raw(src.next());
+        const double loop = seconds_since(t0);
+        const uint64_t bytes = out.bytes();
+        out.close();
+        report("aout::Writer binary", loop, seconds_since(t0), bytes);
+    }
+    {
+        TickSource src(42);
+        auto t0 = std::chrono::steady_clock::now();
+        volatile double sink = 0.0;   // keeps the loop
+        for (uint64_t i = 0; i < n; ++i) sink = sink + src.next().price;
+        report("records only", 0.0, seconds_since(t0), 0);
+    }
+    std::remove(path.c_str());
+    return 0;
+}
+
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAILED: " << what << "\n";
+            ++failures;
+        }
+    };
+
+    // Formatting: same text as std::ostream for integers, default doubles and
+    // fixed doubles, over random magnitudes and the special values.
+    {
+        ctr::Stream rng(11, 0, 0);
+        std::vector<double> xs = {0.0, -0.0, 1.0, -1.0, 0.1, 1e-5, 1e-4, 123456.0, 1234567.0, 999999.5, 9.999995,
+                                  1e300, -1e-300, 5e-324, std::numeric_limits<double>::max(),
+                                  std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                  std::numeric_limits<double>::quiet_NaN()};
+        for (int i = 0; i < 200000; ++i) {
+            const double m = rng.uniform() - 0.5;
+            xs.push_back(m * std::pow(10.0, (int)(rng.next_u32() % 40) - 20));
+            xs.push_back(std::round(m * 1e5) / 10.0);
+        }
+        const std::string path = "out_bench_check.txt";
+        std::ostringstream ref;
+        {
+            aout::Writer out(64, 2);   // tiny blocks: numbers land across block hand-overs
+            out.open(path);
+            uint64_t u = 1000003;
+            for (double x : xs) {
+                u = u * 6364136223846793005ull + 1442695040888963407ull;
+                const int64_t k = (int64_t)u >> (u % 60);
+                const int decimals = (int)(u % 7);
+                out << x << ' ' << k << ' ' << aout::Fixed{x, decimals} << ' ' << (uint32_t)k << '\n';
+                ref << x << ' ' << k << ' ' << std::fixed << std::setprecision(decimals) << x
+                    << std::defaultfloat << std::setprecision(6) << ' ' << (uint32_t)k << '\n';
+            }
+            expect(out.close(), "text file written");
+        }
+        const std::string got = read_file(path);
+        const bool same = got == ref.str();
+        expect(same, "numbers formatted as std::ostream does");
+        std::cout << "Formatting: " << xs.size() << " doubles and integers, default and fixed: "
+                  << (same ? "identical to std::ostream" : "DIFFERENT") << "\n";
+        std::remove(path.c_str());
+    }
+
+    // Binary records and long strings through a small ring (every block size /
+    // count combination wraps around many times), then flush() and reuse.
+    {
+        const std::string path = "out_bench_check.bin";
+        bool same = true;
+        for (size_t block : {64, 100, 4096}) {
+            for (int blocks : {2, 3, 8}) {
+                std::string ref;
+                aout::Writer out(block, blocks);
+                out.open(path);
+                TickSource src(block * 10 + blocks);
+                for (int i = 0; i < 20000; ++i) {
+                    const Tick k = src.next();
+                    out.raw(k);
+                    ref.append(reinterpret_cast<const char*>(&k), sizeof k);
+                    if (i % 1000 == 0) {
+                        const std::string s(i % 3000, 'a' + i % 26);
+                        out << s;
+                        ref += s;
+                    }
+                    if (i == 10000) out.flush();
+                }
+                same = same && out.bytes() == ref.size();
+                out.close();
+                same = same && read_file(path) == ref;
+            }
+        }
+        expect(same, "binary records through the ring");
+        std::cout << "Binary records: 9 ring sizes, 20000 records each: " << (same ? "identical" : "DIFFERENT") << "\n";
+        std::remove(path.c_str());
+    }
+
+    // Errors are reported, not thrown, and do not block the producer.
+    {
+        aout::Writer out;
+        const bool opened = out.open("/nonexistent-dir/out.txt");
+        expect(!opened && !out.error().empty(), "open error reported");
+        std::cout << "Open error: " << out.error() << "\n";
+    }
+
+    std::cout << (failures == 0 ? "Output check: OK" : "Output check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "bench") return bench(util::arg_u64(argc, argv, "n", 20000000), util::arg_string(argc, argv, "path", "out_bench.tmp"));
+    if (mode == "check") return run_check();
+    std::cerr << "usage: out_bench bench [n=20000000] [path=out_bench.tmp] | out_bench check\n";
+    return 1;
+}
@@ -0,0 +1,431 @@
+#pragma once
+
+// Rolling-hedge pairs strategy, shared by pairs_trading and pair_scanner.
+// Header-only.
+//
+// Each step fits y ~ a + b x on the bars up to t-1 (hedge model), takes the
+// z-score of the spread y - (a + b x) over the last L_z values, enters when
+// |z| > z_entry and exits when |z| < z_exit or after max_hold bars. The hedge
+// models share one interface, so run_strategy is written once:
+//   RescanModel       full rescans of both windows (reference, O(L_beta + L_z))
+//   IncrementalModel  rolling or EW sufficient statistics, O(1) per step
+//   KalmanModel       recursive hedge coefficients (KalmanBook of one pair)
+// The pair series is any type with size() and operator[](t) -> PairPoint: a
+// std::vector<PairPoint>, or PairColumns over two arrays read in place.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "util.hpp"
+
+namespace pairs {
+
+enum class PosState { FLAT, LONG_SPREAD, SHORT_SPREAD };
+
+struct PairPoint { double x, y; };
+
+// Pair series over two column arrays (e.g. the col::View of a columnar file).
+struct PairColumns {
+    const double* x = nullptr;
+    const double* y = nullptr;
+    size_t n = 0;
+
+    size_t size() const { return n; }
+    PairPoint operator[](size_t t) const { return {x[t], y[t]}; }
+};
+
+struct Trade {
+    int entry=-1, exit=-1;
+    PosState side=PosState::FLAT;
+    double entry_spread=0.0, exit_spread=0.0;
+    double pnl=0.0;
+    std::string reason;
+};
+
+// WINDOW: equal weights over the last L_beta points (original estimator)
+// EWMA:   exponentially weighted, no hard window edge (decay lambda per step)
+enum class OlsMode { WINDOW, EWMA };
+
+struct Params {
+    int L_beta = 200;     // rolling OLS window
+    int L_z    = 200;     // rolling zscore window on spread
+    double z_entry = 2.0;
+    double z_exit  = 0.5;
+    int max_hold   = 400;
+
+    OlsMode ols_mode = OlsMode::WINDOW;
+    double ew_lambda = 1.0 - 1.0 / 200.0; // EWMA decay (effective memory ~ 1/(1-lambda))
+
+    // Kalman hedge ratio (state [a, b] as a random walk)
+    double kf_delta = 1e-5;  // state noise: Q = delta/(1-delta) * I
+    double kf_R     = 1.0;   // observation noise variance
+    double kf_P0    = 1e3;   // initial state variance
+};
+
+inline double mean(const std::vector<double>& v, int start, int end) {
+    double s = 0.0;
+    for(int i=start;i<=end;i++) s += v[i];
+    return s / (end - start + 1);
+}
+
+inline double stdev(const std::vector<double>& v, int start, int end, double mu) {
+    double s2 = 0.0;
+    for(int i=start;i<=end;i++){
+        double d = v[i] - mu;
+        s2 += d*d;
+    }
+    double var = s2 / (end - start + 1);
+    return std::sqrt(std::max(var, 1e-12));
+}
+
+// Rolling OLS: y ≈ a + b x
+template <class Series>
+void rolling_ols_beta_alpha(
+    const Series& data,
+    int t_end,
+    int L,
+    double& a,
+    double& b
+){
+    int start = t_end - L + 1;
+    double mx=0.0, my=0.0;
+    for(int i=start;i<=t_end;i++){
+        mx += data[i].x;
+        my += data[i].y;
+    }
+    mx /= L; my /= L;
+
+    double num=0.0, den=0.0;
+    for(int i=start;i<=t_end;i++){
+        double dx = data[i].x - mx;
+        double dy = data[i].y - my;
+        num += dx * dy;
+        den += dx * dx;
+    }
+    b = (den > 1e-12) ? (num / den) : 0.0;
+    a = my - b * mx;
+}
+
+// --- Incremental estimators (O(1) per step)
+
+// Sufficient statistics Σx, Σy, Σxy, Σx² over a sliding window of L points.
+// Sums are taken on (x - Kx, y - Ky) so the centered moments do not cancel at
+// price level; the anchor is moved to the window means and the sums rebuilt
+// from the ring buffer every `reanchor` slides to bound drift.
+class RollingOLS {
+public:
+    explicit RollingOLS(int L, int reanchor = 0)
+        : buf_(L), L_(L), reanchor_(reanchor > 0 ? reanchor : std::max(L, 1024)) {}
+
+    void push(const PairPoint& p) {
+        if (count_ == 0) { kx_ = p.x; ky_ = p.y; }
+        if (count_ == L_) remove(buf_[head_]);
+        else ++count_;
+        add(p);
+        buf_[head_] = p;
+        if (++head_ == L_) head_ = 0;
+
+        if (count_ == L_ && ++since_anchor_ >= reanchor_) rebuild();
+    }
+
+    // y ≈ a + b x over the current window
+    void coeffs(double& a, double& b) const {
+        double n = count_;
+        double mx = sx_.value() / n, my = sy_.value() / n;
+        double num = sxy_.value() - n * mx * my;
+        double den = sxx_.value() - n * mx * mx;
+        b = (den > 1e-12) ? (num / den) : 0.0;
+        a = (ky_ + my) - b * (kx_ + mx);
+    }
+
+private:
+    void add(const PairPoint& p) {
+        double dx = p.x - kx_, dy = p.y - ky_;
+        sx_.add(dx); sy_.add(dy); sxy_.add(dx * dy); sxx_.add(dx * dx);
+    }
+    void remove(const PairPoint& p) {
+        double dx = p.x - kx_, dy = p.y - ky_;
+        sx_.add(-dx); sy_.add(-dy); sxy_.add(-dx * dy); sxx_.add(-dx * dx);
+    }
+    void rebuild() {
+        double mx = 0.0, my = 0.0;
+        for (const auto& p : buf_) { mx += p.x; my += p.y; }
+        kx_ = mx / L_; ky_ = my / L_;
+        sx_ = sy_ = sxy_ = sxx_ = util::CompensatedSum{};
+        for (const auto& p : buf_) add(p);
+        since_anchor_ = 0;
+    }
+
+    std::vector<PairPoint> buf_;
+    int L_;
+    int reanchor_;
+    int head_ = 0;
+    int count_ = 0;
+    int since_anchor_ = 0;
+    double kx_ = 0.0, ky_ = 0.0;
+    util::CompensatedSum sx_, sy_, sxy_, sxx_;
+};
+
+// Exponentially weighted OLS: every sum decays by lambda per step, so there is
+// no window edge and no buffer. Anchored like RollingOLS; moving the anchor is
+// an exact algebraic shift of the weighted sums.
+class EwOLS {
+public:
+    explicit EwOLS(double lambda) : lambda_(lambda) {}
+
+    void push(const PairPoint& p) {
+        if (w_ == 0.0) { kx_ = p.x; ky_ = p.y; }
+        double dx = p.x - kx_, dy = p.y - ky_;
+        w_   = lambda_ * w_   + 1.0;
+        sx_  = lambda_ * sx_  + dx;
+        sy_  = lambda_ * sy_  + dy;
+        sxy_ = lambda_ * sxy_ + dx * dy;
+        sxx_ = lambda_ * sxx_ + dx * dx;
+        syy_ = lambda_ * syy_ + dy * dy;
+        if (++since_anchor_ >= 1024) reanchor();
+    }
+
+    void coeffs(double& a, double& b) const {
+        double mx = sx_ / w_, my = sy_ / w_;
+        double num = sxy_ - w_ * mx * my;
+        double den = sxx_ - w_ * mx * mx;
+        b = (den > 1e-12) ? (num / den) : 0.0;
+        a = (ky_ + my) - b * (kx_ + mx);
+    }
+
+    // Weighted standard deviation of the residuals y - (a + b x) of coeffs().
+    double resid_sd() const {
+        double a, b;
+        coeffs(a, b);
+        double mx = sx_ / w_, my = sy_ / w_;
+        double cxx = sxx_ - w_ * mx * mx, cxy = sxy_ - w_ * mx * my, cyy = syy_ - w_ * my * my;
+        return std::sqrt(std::max(cyy - 2.0 * b * cxy + b * b * cxx, 0.0) / w_);
+    }
+
+private:
+    // shift anchor to the weighted means: sums of (x - K') from sums of (x - K)
+    void reanchor() {
+        double ux = sx_ / w_, uy = sy_ / w_;
+        sxy_ -= ux * sy_ + uy * sx_ - w_ * ux * uy;
+        sxx_ -= 2.0 * ux * sx_ - w_ * ux * ux;
+        syy_ -= 2.0 * uy * sy_ - w_ * uy * uy;
+        kx_ += ux; ky_ += uy;
+        sx_ = sy_ = 0.0;
+        since_anchor_ = 0;
+    }
+
+    double lambda_;
+    double w_ = 0.0;
+    double kx_ = 0.0, ky_ = 0.0;
+    double sx_ = 0.0, sy_ = 0.0, sxy_ = 0.0, sxx_ = 0.0, syy_ = 0.0;
+    int since_anchor_ = 0;
+};
+
+// Kalman filter on the hedge coefficients, batched across a book of pairs.
+// State theta = [a, b] follows a random walk (Q = q I); observation y = a + b x + v,
+// Var(v) = R. The 2x2 covariance is symmetric, so each pair carries five numbers
+// (a, b, p00, p01, p11), stored struct-of-arrays: one update() is a single
+// branch-free pass over contiguous arrays that the compiler vectorizes.
+struct KalmanBook {
+    int n = 0;
+    double q = 0.0, R = 1.0;
+    std::vector<double> a, b, p00, p01, p11;
+
+    KalmanBook(int n_pairs, double delta, double R_, double P0)
+        : n(n_pairs), q(delta / (1.0 - delta)), R(R_),
+          a(n_pairs, 0.0), b(n_pairs, 0.0), p00(n_pairs, P0), p01(n_pairs, 0.0), p11(n_pairs, P0) {}
+
+    // One observation per pair: x[k], y[k] for pair k.
+    void update(const double* __restrict x, const double* __restrict y) {
+        double* __restrict A = a.data();
+        double* __restrict B = b.data();
+        double* __restrict P00 = p00.data();
+        double* __restrict P01 = p01.data();
+        double* __restrict P11 = p11.data();
+        const double Q = q, Rv = R;
+
+        for (int k = 0; k < n; ++k) {
+            // predict
+            double c00 = P00[k] + Q, c01 = P01[k], c11 = P11[k] + Q;
+            double xk = x[k];
+            // innovation and its variance
+            double e = y[k] - (A[k] + B[k] * xk);
+            double h0 = c00 + c01 * xk;        // (P H')_0
+            double h1 = c01 + c11 * xk;        // (P H')_1
+            double S = h0 + h1 * xk + Rv;
+            double k0 = h0 / S, k1 = h1 / S;   // Kalman gain
+            // correct: theta += K e ; P -= K S K'
+            A[k] += k0 * e;
+            B[k] += k1 * e;
+            P00[k] = c00 - k0 * h0;
+            P01[k] = c01 - k0 * h1;
+            P11[k] = c11 - k1 * h1;
+        }
+    }
+};
+
+// Hedge models: hedge(t_end, a, b) fits y ≈ a + b x on data up to t_end,
+// zscore(spread, sig) standardizes spread[sig] over the last L_z values.
+// Both are called once per step with increasing arguments.
+
+// Reference model: full rescans of both windows every step (original implementation).
+template <class Series>
+struct RescanModel {
+    const Series& data;
+    Params p;
+
+    void hedge(int t_end, double& a, double& b) {
+        rolling_ols_beta_alpha(data, t_end, p.L_beta, a, b);
+    }
+    double zscore(const std::vector<double>& spread, int sig) {
+        int z_start = sig - p.L_z + 1;
+        double mu = mean(spread, z_start, sig);
+        double sd = stdev(spread, z_start, sig, mu);
+        return (spread[sig] - mu) / sd;
+    }
+};
+template <class Series> RescanModel(const Series&, const Params&) -> RescanModel<Series>;
+
+// Incremental model: windowed or EW sufficient statistics + rolling spread moments.
+template <class Series>
+class IncrementalModel {
+public:
+    IncrementalModel(const Series& data, const Params& p)
+        : data_(data), mode_(p.ols_mode), ols_(p.L_beta), ew_(p.ew_lambda), zmv_(p.L_z) {}
+
+    void hedge(int t_end, double& a, double& b) {
+        while (next_x_ <= t_end) {
+            if (mode_ == OlsMode::WINDOW) ols_.push(data_[next_x_]);
+            else                          ew_.push(data_[next_x_]);
+            ++next_x_;
+        }
+        if (mode_ == OlsMode::WINDOW) ols_.coeffs(a, b);
+        else                          ew_.coeffs(a, b);
+    }
+    double zscore(const std::vector<double>& spread, int sig) {
+        while (next_s_ <= sig) zmv_.push(spread[next_s_++]);
+        double sd = std::sqrt(std::max(zmv_.variance(), 1e-12));
+        return (spread[sig] - zmv_.mean()) / sd;
+    }
+
+private:
+    const Series& data_;
+    OlsMode mode_;
+    RollingOLS ols_;
+    EwOLS ew_;
+    util::RollingMeanVar zmv_;
+    int next_x_ = 0;
+    int next_s_ = 0;
+};
+
+// Kalman model: recursive hedge coefficients (a book of one pair), no window
+// edge; the spread z-score keeps the rolling L_z window.
+template <class Series>
+class KalmanModel {
+public:
+    KalmanModel(const Series& data, const Params& p)
+        : data_(data), kf_(1, p.kf_delta, p.kf_R, p.kf_P0), zmv_(p.L_z) {}
+
+    void hedge(int t_end, double& a, double& b) {
+        while (next_x_ <= t_end) {
+            const PairPoint pt = data_[next_x_];
+            kf_.update(&pt.x, &pt.y);
+            ++next_x_;
+        }
+        a = kf_.a[0];
+        b = kf_.b[0];
+    }
+    double zscore(const std::vector<double>& spread, int sig) {
+        while (next_s_ <= sig) zmv_.push(spread[next_s_++]);
+        double sd = std::sqrt(std::max(zmv_.variance(), 1e-12));
+        return (spread[sig] - zmv_.mean()) / sd;
+    }
+
+private:
+    const Series& data_;
+    KalmanBook kf_;
+    util::RollingMeanVar zmv_;
+    int next_x_ = 0;
+    int next_s_ = 0;
+};
+
+template <class Series, class Model>
+std::vector<Trade> run_strategy(const Series& data, const Params& p, Model&& model) {
+    const int T = (int)data.size();
+
+    std::vector<double> spread(T, 0.0);
+
+    PosState pos = PosState::FLAT;
+    int entry_t=-1;
+    double entry_sp=0.0;
+    double pnl=0.0;
+
+    std::vector<Trade> trades;
+    trades.reserve(128);
+
+    for(int t = std::max(p.L_beta, p.L_z); t < T; ++t){
+        // estimate hedge ratio using only past data up to t-1 (closed-bar discipline)
+        double a=0.0, b=0.0;
+        model.hedge(t-1, a, b);
+
+        // current spread at time t-1 (signal evaluated on closed obs)
+        int sig = t-1;
+        spread[sig] = data[sig].y - (a + b * data[sig].x);
+
+        // z-score using spread history up to sig
+        double z = model.zscore(spread, sig);
+
+        // PnL accrual from t-1 to t on hedged portfolio if in position
+        if(pos != PosState::FLAT){
+            // portfolio weights consistent with spread: S = y - (a + b x)
+            // Long spread: +1*y and -b*x ; Short spread: -1*y and +b*x
+            int s = (pos == PosState::LONG_SPREAD) ? +1 : -1;
+            double dy = data[t].y - data[t-1].y;
+            double dx = data[t].x - data[t-1].x;
+            pnl += s * (dy - b * dx);
+        }
+
+        // Exit logic first
+        if(pos != PosState::FLAT){
+            bool exit_cond = (std::fabs(z) < p.z_exit);
+            bool time_stop = (t - entry_t >= p.max_hold);
+
+            if(exit_cond || time_stop){
+                Trade tr;
+                tr.entry = entry_t;
+                tr.exit  = t;
+                tr.side  = pos;
+                tr.entry_spread = entry_sp;
+                tr.exit_spread  = spread[sig];
+                tr.pnl = pnl;
+                tr.reason = exit_cond ? "Z_EXIT" : "TIME_STOP";
+                trades.push_back(tr);
+
+                pos = PosState::FLAT;
+                entry_t=-1;
+                entry_sp=0.0;
+                pnl=0.0;
+            }
+            continue;
+        }
+
+        // Entry logic
+        if(z > p.z_entry){
+            pos = PosState::SHORT_SPREAD;
+            entry_t = t;
+            entry_sp = spread[sig];
+            pnl = 0.0;
+        } else if(z < -p.z_entry){
+            pos = PosState::LONG_SPREAD;
+            entry_t = t;
+            entry_sp = spread[sig];
+            pnl = 0.0;
+        }
+    }
+
+    return trades;
+}
+
+} // namespace pairs
@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ctr_rng.hpp"
+#include "util.hpp"
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static const double kMu = 0.0002, kSigma = 0.01;
+
+// GBM path as the strategy generators build it: each block draws its normals,
+// turns them into exp factors in place, then one sequential pass chains them.
+static std::vector<double> gbm_ctr(size_t n, uint64_t seed, int n_threads) {
+    std::vector<double> s(n);
+    ctr::for_blocks(n, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        ctr::Stream rng(seed, 0, b);
+        double* x = s.data() + t0;
+        const size_t len = t1 - t0;
+        rng.normals(x, len);
+        for (size_t i = 0; i < len; ++i) x[i] = (kMu - 0.5 * kSigma * kSigma) + kSigma * x[i];
+        ctr::exp_batch(x, len);
+    });
+    if (n > 0) s[0] = 100.0;
+    for (size_t t = 1; t < n; ++t) s[t] *= s[t-1];
+    return s;
+}
+
+// Same draws one step at a time (normal() + std::exp per step).
+static std::vector<double> gbm_ctr_steps(size_t n, uint64_t seed) {
+    std::vector<double> s(n);
+    for (size_t b = 0; b * ctr::kStepBlock < n; ++b) {
+        ctr::Stream rng(seed, 0, (uint32_t)b);
+        for (size_t t = b * ctr::kStepBlock; t < std::min(n, (b + 1) * ctr::kStepBlock); ++t)
+            s[t] = std::exp((kMu - 0.5 * kSigma * kSigma) + kSigma * rng.normal());
+    }
+    if (n > 0) s[0] = 100.0;
+    for (size_t t = 1; t < n; ++t) s[t] *= s[t-1];
+    return s;
+}
+
+// The same path from one std::mt19937 (the generators before the port).
+static std::vector<double> gbm_mt(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> N(0.0, 1.0);
+    std::vector<double> s(n);
+    if (n > 0) s[0] = 100.0;
+    for (size_t t = 1; t < n; ++t) s[t] = s[t-1] * std::exp((kMu - 0.5 * kSigma * kSigma) + kSigma * N(rng));
+    return s;
+}
+
+// OHLC bars as in ATR / London: three normals and three exp per bar.
+struct Ohlc { std::vector<double> open, high, low, close; };
+
+static Ohlc ohlc_mt(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> N(0.0, 1.0);
+    Ohlc b{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+    double last = 100.0;
+    for (size_t t = 0; t < n; ++t) {
+        double z1 = N(rng), z2 = N(rng), z3 = N(rng);
+        double open = last, close = open * std::exp(-0.5 * kSigma * kSigma + kSigma * z1);
+        b.open[t] = open;
+        b.close[t] = close;
+        b.high[t] = std::max(open, close) * std::exp(std::fabs(kSigma * z2));
+        b.low[t] = std::min(open, close) / std::exp(std::fabs(kSigma * z3));
+        last = close;
+    }
+    return b;
+}
+
+static Ohlc ohlc_ctr(size_t n, uint64_t seed, int n_threads) {
+    Ohlc b{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+    ctr::for_blocks(n, n_threads, [&](uint32_t blk, size_t t0, size_t t1) {
+        const size_t len = t1 - t0;
+        std::vector<double> z(3 * len);
+        ctr::Stream(seed, 0, blk).normals(z.data(), z.size());
+        double *c = &b.close[t0], *h = &b.high[t0], *l = &b.low[t0];
+        for (size_t i = 0; i < len; ++i) {
+            c[i] = -0.5 * kSigma * kSigma + kSigma * z[3*i];
+            h[i] = std::fabs(kSigma * z[3*i+1]);
+            l[i] = std::fabs(kSigma * z[3*i+2]);
+        }
+        ctr::exp_batch(c, len);
+        ctr::exp_batch(h, len);
+        ctr::exp_batch(l, len);
+    });
+    double last = 100.0;
+    for (size_t t = 0; t < n; ++t) {
+        double open = last, close = open * b.close[t];
+        b.open[t] = open;
+        b.close[t] = close;
+        b.high[t] = std::max(open, close) * b.high[t];
+        b.low[t] = std::min(open, close) / b.low[t];
+        last = close;
+    }
+    return b;
+}
+
+static int bench(size_t n, int n_threads) {
+    const int n_thr = ctr::thread_count(n_threads);
+    std::cout << std::fixed << std::setprecision(1);
+    volatile double sink = 0.0;
+    auto rate = [&](double secs) { return n / secs / 1e6; };
+
+    std::cout << "Normal draws, " << n << "\n";
+    {
+        std::mt19937 mt(42);
+        std::normal_distribution<double> N(0.0, 1.0);
+        auto t0 = std::chrono::steady_clock::now();
+        double acc = 0.0;
+        for (size_t i = 0; i < n; ++i) acc += N(mt);
+        double s_mt = seconds_since(t0);
+
+        std::vector<double> z(ctr::kStepBlock);
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i += z.size()) {
+            ctr::Stream(42, 0, (uint32_t)(i / z.size())).normals(z.data(), z.size());
+            acc += z[0];
+        }
+        double s_batch = seconds_since(t0);
+        sink = sink + acc;
+        std::cout << "  std::normal_distribution (mt19937): " << rate(s_mt) << " M/s\n"
+                  << "  ctr::Stream::normals: " << rate(s_batch) << " M/s (x" << std::setprecision(2)
+                  << s_mt / s_batch << ")\n" << std::setprecision(1);
+    }
+
+    std::cout << "GBM path, " << n << " steps\n";
+    auto t0 = std::chrono::steady_clock::now();
+    sink = sink + gbm_mt(n, 42).back();
+    double s_mt = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    sink = sink + gbm_ctr_steps(n, 42).back();
+    double s_steps = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    std::vector<double> one = gbm_ctr(n, 42, 1);
+    double s_one = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    std::vector<double> many = gbm_ctr(n, 42, n_thr);
+    double s_many = seconds_since(t0);
+    std::cout << "  mt19937 + normal_distribution + exp: " << rate(s_mt) << " M steps/s\n"
+              << "  Philox, normal() + exp per step: " << rate(s_steps) << " M steps/s\n"
+              << "  Philox, blocks, 1 thread: " << rate(s_one) << " M steps/s (x" << std::setprecision(2)
+              << s_mt / s_one << " vs mt19937)\n" << std::setprecision(1)
+              << "  Philox, blocks, " << n_thr << " threads: " << rate(s_many) << " M steps/s\n";
+
+    std::cout << "OHLC bars, " << n << " bars\n";
+    t0 = std::chrono::steady_clock::now();
+    sink = sink + ohlc_mt(n, 42).close.back();
+    double o_mt = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    Ohlc o1 = ohlc_ctr(n, 42, 1);
+    double o_one = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    Ohlc on = ohlc_ctr(n, 42, n_thr);
+    double o_many = seconds_since(t0);
+    std::cout << "  mt19937, 3 normals + 3 exp per bar: " << rate(o_mt) << " M bars/s\n"
+              << "  Philox, blocks, 1 thread: " << rate(o_one) << " M bars/s (x" << std::setprecision(2)
+              << o_mt / o_one << ")\n" << std::setprecision(1)
+              << "  Philox, blocks, " << n_thr << " threads: " << rate(o_many) << " M bars/s\n";
+
+    const bool same = one == many && o1.close == on.close && o1.high == on.high && o1.low == on.low;
+    std::cout << "  identical across thread counts: " << (same ? "yes" : "NO") << "\n";
+    return same ? 0 : 1;
+}
+
+// --- Statistical validation
+
+// Kolmogorov distribution tail, P(sqrt(n) D > lambda).
+static double kolmogorov_q(double lambda) {
+    if (lambda < 0.2) return 1.0;
+    double q = 0.0;
+    for (int k = 1; k <= 100; ++k) q += ((k & 1) ? 2.0 : -2.0) * std::exp(-2.0 * k * k * lambda * lambda);
+    return std::min(1.0, std::max(0.0, q));
+}
+
+// KS statistic of a sample (sorted in place) against a continuous CDF, and its p-value.
+template <class Cdf>
+static void ks_test(std::vector<double>& x, Cdf&& cdf, double& D, double& p) {
+    std::sort(x.begin(), x.end());
+    const double n = (double)x.size();
+    D = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double F = cdf(x[i]);
+        D = std::max(D, std::max(F - i / n, (i + 1) / n - F));
+    }
+    const double sn = std::sqrt(n);
+    p = kolmogorov_q((sn + 0.12 + 0.11 / sn) * D);
+}
+
+struct Moments { double mean, var, skew, kurt; };   // kurt = excess kurtosis
+
+static Moments moments(const std::vector<double>& x) {
+    double m1 = 0.0;
+    for (double v : x) m1 += v;
+    m1 /= x.size();
+    double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    for (double v : x) {
+        double d = v - m1, d2 = d * d;
+        m2 += d2;
+        m3 += d2 * d;
+        m4 += d2 * d2;
+    }
+    m2 /= x.size();
+    m3 /= x.size();
+    m4 /= x.size();
+    return {m1, m2, m3 / std::pow(m2, 1.5), m4 / (m2 * m2) - 3.0};
+}
+
+struct Validation {
+    Moments m;
+    double z_mean, z_var, z_skew, z_kurt;   // in standard errors under N(0, 1)
+    double ks_normal, p_normal, ks_uniform, p_uniform;
+};
+
+// n normals drawn in blocks of kStepBlock, as the generators do, and n uniforms.
+static Validation validate(size_t n, uint64_t seed) {
+    std::vector<double> z(n);
+    ctr::for_blocks(n, 0, [&](uint32_t b, size_t t0, size_t t1) {
+        ctr::Stream(seed, 0, b).normals(z.data() + t0, t1 - t0);
+    });
+    Validation v;
+    v.m = moments(z);
+    const double nn = (double)n;
+    v.z_mean = v.m.mean / std::sqrt(1.0 / nn);
+    v.z_var = (v.m.var - 1.0) / std::sqrt(2.0 / nn);
+    v.z_skew = v.m.skew / std::sqrt(6.0 / nn);
+    v.z_kurt = v.m.kurt / std::sqrt(24.0 / nn);
+    ks_test(z, [](double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }, v.ks_normal, v.p_normal);
+
+    ctr::Stream rng(seed, 1, 0);
+    for (auto& u : z) u = rng.uniform();
+    ks_test(z, [](double x) { return x; }, v.ks_uniform, v.p_uniform);
+    return v;
+}
+
+// Kernel errors against long double libm: log (relative), sin / cos of 2 pi u
+// (absolute), exp (relative).
+struct KernelError { double log_rel, sincos_abs, exp_rel; };
+
+static double kernel_log(double x) {
+#if defined(__AVX2__)
+    return _mm256_cvtsd_f64(ctr::detail::log4(_mm256_set1_pd(x)));
+#else
+    return ctr::detail::log1(x);
+#endif
+}
+
+static void kernel_sincos(double u, double& s, double& c) {
+#if defined(__AVX2__)
+    __m256d vs, vc;
+    ctr::detail::sincos2pi4(_mm256_set1_pd(u), vs, vc);
+    s = _mm256_cvtsd_f64(vs);
+    c = _mm256_cvtsd_f64(vc);
+#else
+    ctr::detail::sincos2pi1(u, s, c);
+#endif
+}
+
+static KernelError kernel_errors(size_t n) {
+    KernelError e{0.0, 0.0, 0.0};
+    ctr::Stream rng(3, 0, 0);
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = (rng.uniform() - 0.5) * (i % 3 == 0 ? 1400.0 : 2.0);
+    std::vector<double> ex = x;
+    ctr::exp_batch(ex.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        long double ref = std::exp((long double)x[i]);
+        e.exp_rel = std::max(e.exp_rel, (double)(std::fabs(ex[i] - ref) / ref));
+
+        double u = 1.0 - rng.uniform();
+        if (i % 4 == 0) u = 1.0 - u * 1e-6;   // near 1, where log is small
+        long double lr = std::log((long double)u);
+        if (lr != 0.0L) e.log_rel = std::max(e.log_rel, (double)(std::fabs(kernel_log(u) - lr) / std::fabs(lr)));
+
+        double a = rng.uniform(), s, c;
+        kernel_sincos(a, s, c);
+        long double ang = 6.283185307179586476925286766559L * a;
+        e.sincos_abs = std::max(e.sincos_abs, (double)std::max(std::fabs(s - std::sin(ang)), std::fabs(c - std::cos(ang))));
+    }
+    return e;
+}
+
+static int stats(size_t n) {
+    Validation v = validate(n, 2024);
+    KernelError e = kernel_errors(std::min<size_t>(n, 2000000));
+    std::cout << std::setprecision(5) << std::fixed
+              << "Normals (" << n << ", blocks of " << ctr::kStepBlock << "):\n"
+              << "  mean " << v.m.mean << " (" << std::setprecision(2) << v.z_mean << " s.e.)\n" << std::setprecision(5)
+              << "  variance " << v.m.var << " (" << std::setprecision(2) << v.z_var << " s.e.)\n" << std::setprecision(5)
+              << "  skewness " << v.m.skew << " (" << std::setprecision(2) << v.z_skew << " s.e.)\n" << std::setprecision(5)
+              << "  excess kurtosis " << v.m.kurt << " (" << std::setprecision(2) << v.z_kurt << " s.e.)\n"
+              << std::setprecision(6)
+              << "  KS vs N(0,1): D = " << v.ks_normal << ", p = " << std::setprecision(3) << v.p_normal << "\n"
+              << std::setprecision(6)
+              << "Uniforms (" << n << "): KS vs U(0,1): D = " << v.ks_uniform << ", p = " << std::setprecision(3)
+              << v.p_uniform << "\n"
+              << std::scientific << std::setprecision(2)
+              << "Kernels vs long double libm: log " << e.log_rel << " rel, sin/cos(2 pi u) " << e.sincos_abs
+              << " abs, exp " << e.exp_rel << " rel\n";
+    return 0;
+}
+
+static int run_check() {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAIL " << what << "\n";
+            ++failures;
+        }
+    };
+
+    // Known-answer vectors of the reference implementation (Random123 kat_vectors).
+    struct Kat { ctr::Counter c; ctr::Key k; ctr::Counter out; };
+    const Kat kats[] = {
+        {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+         {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    for (const auto& k : kats) expect(ctr::philox4x32_10(k.c, k.k) == k.out, "Philox4x32-10 known answer");
+
+    // Coordinates: the same (seed, path, block) replays, any other one differs.
+    auto first = [](uint64_t seed, uint64_t path, uint32_t block) {
+        ctr::Stream s(seed, path, block);
+        return s.next_u64();
+    };
+    const uint64_t ref = first(7, 3, 5);
+    expect(first(7, 3, 5) == ref, "stream replays");
+    expect(first(8, 3, 5) != ref && first(7, 4, 5) != ref && first(7, 3, 6) != ref &&
+           first(7, 3 + (1ull << 32), 5) != ref && first(7 + (1ull << 32), 3, 5) != ref, "stream coordinates");
+
+    // Batches: normals(n) holds the values of n normal() calls, for every length and
+    // split (odd lengths leave a spare), and after integer draws.
+    {
+        bool same = true;
+        for (size_t split : {0, 1, 2, 7, 8, 9, 33}) {
+            ctr::Stream a(5, 1, 2), b(5, 1, 2);
+            std::vector<double> za(101);
+            a.normals(za.data(), split);
+            a.normals(za.data() + split, za.size() - split);
+            for (double z : za) same = same && z == b.normal();
+            same = same && a.normal() == b.normal();
+        }
+        ctr::Stream a(5, 1, 3), b(5, 1, 3);
+        a.next_u32();
+        b.next_u32();
+        std::vector<double> za(17);
+        a.normals(za.data(), za.size());
+        for (double z : za) same = same && z == b.normal();
+        expect(same, "normals() vs normal()");
+
+        std::vector<double> x(23), y;
+        for (size_t i = 0; i < x.size(); ++i) x[i] = -30.0 + 3.0 * i;
+        y = x;
+        ctr::exp_batch(y.data(), y.size());
+        bool tail = true;
+        for (size_t i = 0; i < x.size(); ++i) {
+            double one = x[i];
+            ctr::exp_batch(&one, 1);
+            tail = tail && one == y[i];
+        }
+        expect(tail, "exp_batch tail");
+    }
+
+    // Kernels close to libm (a few ulp).
+    {
+        KernelError e = kernel_errors(1000000);
+        expect(e.log_rel < 5e-16, "log kernel (" + std::to_string(e.log_rel) + ")");
+        expect(e.sincos_abs < 5e-16, "sin / cos kernel (" + std::to_string(e.sincos_abs) + ")");
+        expect(e.exp_rel < 5e-16, "exp kernel (" + std::to_string(e.exp_rel) + ")");
+    }
+
+    // Distribution: moments within 5 standard errors, KS p-values not extreme (1M draws).
+    {
+        Validation v = validate(1000000, 11);
+        expect(std::fabs(v.z_mean) < 5 && std::fabs(v.z_var) < 5 && std::fabs(v.z_skew) < 5 &&
+               std::fabs(v.z_kurt) < 5, "normal moments");
+        expect(v.p_normal > 1e-3, "KS normal (p = " + std::to_string(v.p_normal) + ")");
+        expect(v.p_uniform > 1e-3, "KS uniform (p = " + std::to_string(v.p_uniform) + ")");
+    }
+
+    // Paths: bit-identical for any thread count, and one block drawn on its own
+    // matches the same block inside the full path.
+    {
+        const size_t n = 20 * ctr::kStepBlock + 123;
+        std::vector<double> base = gbm_ctr(n, 5, 1);
+        for (int th : {2, 3, 8}) expect(gbm_ctr(n, 5, th) == base, "path with " + std::to_string(th) + " threads");
+        Ohlc o = ohlc_ctr(n, 5, 1);
+        for (int th : {2, 3, 8}) {
+            Ohlc p = ohlc_ctr(n, 5, th);
+            expect(p.open == o.open && p.high == o.high && p.low == o.low && p.close == o.close,
+                   "bars with " + std::to_string(th) + " threads");
+        }
+
+        std::vector<double> f(ctr::kStepBlock);
+        ctr::Stream(5, 0, 7).normals(f.data(), f.size());
+        for (auto& x : f) x = (kMu - 0.5 * kSigma * kSigma) + kSigma * x;
+        ctr::exp_batch(f.data(), f.size());
+        double s = base[7 * ctr::kStepBlock - 1];
+        bool same = true;
+        for (size_t i = 0; i < f.size(); ++i) {
+            s *= f[i];
+            same = same && s == base[7 * ctr::kStepBlock + i];
+        }
+        expect(same, "block produced on its own");
+    }
+
+    std::cout << (failures == 0 ? "All checks passed\n" : "Checks FAILED\n");
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "check") return run_check();
+    if (mode == "bench") {
+        uint64_t threads;
+        std::string err;
+        if (!util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        return bench(util::arg_u64(argc, argv, "n", 20000000), (int)threads);
+    }
+    if (mode == "stats") return stats(util::arg_u64(argc, argv, "n", 10000000));
+
+    std::cerr << "Usage: rng_bench bench [n=20000000] [threads=N] | rng_bench stats [n=10000000] | rng_bench check\n";
+    return 1;
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+// Compressed tick storage (.tcz): tick-size quantization, delta + zigzag
+// encoding and per-block bit-packing, with a per-chunk min/max index.
+// Header-only, POSIX (mmap) for the file reader.
+//
+// Column model: every value is quantized to an integer number of ticks,
+// q = llround(x / tick) (tick = 1 for integer columns), and the round trip is
+// exact on q; decoded values are q * tick.
+//
+// Chunk (up to kChunk values): first value, min, max and byte range in the chunk
+// directory; payload = ceil(n / kBlock) blocks, each one width byte b followed by
+// kBlock zigzag deltas packed on b bits (16 * b bytes). Flat runs (unchanged
+// quantities, prices between moves) cost one byte per block.
+//
+// Decoding unpacks a block of deltas with unaligned 64-bit loads (no per-value
+// branch), then zigzag-decodes and prefix-sums four values per AVX2 instruction
+// (scalar fallback without AVX2).
+//
+// File layout (little-endian):
+//   [0, 64)                 FileHeader
+//   [64, 64 + 128 * n_cols) ColumnDesc[n_cols]
+//   desc.dir_offset         ChunkInfo[n_chunks]
+//   desc.data_offset        chunk payloads (+ 8 zero bytes of read slack)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace tcz {
+
+constexpr int kBlock = 128;     // values per bit-packed block
+constexpr int kChunk = 4096;    // values per chunk (32 blocks)
+
+inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t unzigzag(uint64_t u) { return (int64_t)(u >> 1) ^ -(int64_t)(u & 1); }
+
+inline int64_t quantize(double x, double tick) { return (int64_t)std::llround(x / tick); }
+
+struct ChunkInfo {
+    uint64_t offset;   // payload offset within the column data
+    uint32_t n;        // values in the chunk
+    uint32_t bytes;    // payload bytes
+    int64_t first, min, max;
+};
+static_assert(sizeof(ChunkInfo) == 40, "ChunkInfo must be 40 bytes");
+
+// --- Bit packing of one block (kBlock values on b bits)
+
+inline void pack_block(const uint64_t* v, int b, std::vector<uint8_t>& out) {
+    out.push_back((uint8_t)b);
+    if (b == 0) return;
+    const size_t base = out.size();
+    out.resize(base + (size_t)kBlock * b / 8, 0);
+    uint8_t* dst = out.data() + base;
+    uint64_t acc = 0;
+    int fill = 0;
+    size_t pos = 0;
+    for (int i = 0; i < kBlock; ++i) {
+        acc |= v[i] << fill;
+        if (fill + b >= 64) {
+            std::memcpy(dst + pos, &acc, 8);
+            pos += 8;
+            int used = 64 - fill;                       // bits of v[i] already stored
+            acc = (used < 64) ? (v[i] >> used) : 0;
+            fill = b - used;
+        } else {
+            fill += b;
+        }
+    }
+    // kBlock * b is a multiple of 64, so nothing is left in acc
+}
+
+// Unpacks kBlock values; src must be readable 8 bytes past the block.
+inline void unpack_block(const uint8_t* src, int b, uint64_t* v) {
+    if (b == 0) {
+        std::fill(v, v + kBlock, 0);
+        return;
+    }
+    const uint64_t mask = (b == 64) ? ~0ull : ((1ull << b) - 1);
+    uint64_t bit = 0;
+    if (b <= 56) {
+        for (int i = 0; i < kBlock; ++i, bit += b) {
+            uint64_t w;
+            std::memcpy(&w, src + (bit >> 3), 8);
+            v[i] = (w >> (bit & 7)) & mask;
+        }
+    } else {
+        for (int i = 0; i < kBlock; ++i, bit += b) {
+            uint64_t lo;
+            std::memcpy(&lo, src + (bit >> 3), 8);
+            const int s = (int)(bit & 7);
+            uint64_t x = lo >> s;
+            if (s + b > 64) x |= (uint64_t)src[(bit >> 3) + 8] << (64 - s);   // tail byte, inside the block
+            v[i] = x & mask;
+        }
+    }
+}
+
+// out[i] = prev + sum_{j<=i} unzigzag(zz[j]); returns the last value.
+inline int64_t unzigzag_prefix(const uint64_t* zz, int n, int64_t prev, int64_t* out) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i carry = _mm256_set1_epi64x(prev);
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(zz + i));
+        __m256i d = _mm256_xor_si256(_mm256_srli_epi64(x, 1), _mm256_sub_epi64(zero, _mm256_and_si256(x, one)));
+        // in-register inclusive scan over 4 lanes: shift by one lane, then by two
+        d = _mm256_add_epi64(d, _mm256_blend_epi32(_mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+        d = _mm256_add_epi64(d, _mm256_blend_epi32(_mm256_permute4x64_epi64(d, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+        d = _mm256_add_epi64(d, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), d);
+        carry = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if (i > 0) prev = out[i - 1];
+#endif
+    for (; i < n; ++i) {
+        prev = (int64_t)((uint64_t)prev + (uint64_t)unzigzag(zz[i]));
+        out[i] = prev;
+    }
+    return prev;
+}
+
+// --- Chunk codec
+
+inline ChunkInfo encode_chunk(const int64_t* q, int n, std::vector<uint8_t>& out) {
+    ChunkInfo ci{};
+    ci.offset = out.size();
+    ci.n = (uint32_t)n;
+    ci.first = q[0];
+    ci.min = ci.max = q[0];
+    uint64_t zz[kBlock];
+    int64_t prev = q[0];
+    for (int b0 = 0; b0 < n; b0 += kBlock) {
+        uint64_t all = 0;
+        for (int i = 0; i < kBlock; ++i) {
+            int k = b0 + i;
+            if (k < n) {
+                ci.min = std::min(ci.min, q[k]);
+                ci.max = std::max(ci.max, q[k]);
+                // wrap-around delta: exact for any int64 pair
+                zz[i] = zigzag((int64_t)((uint64_t)q[k] - (uint64_t)prev));
+                prev = q[k];
+            } else {
+                zz[i] = 0;
+            }
+            all |= zz[i];
+        }
+        int b = all ? 64 - __builtin_clzll(all) : 0;
+        pack_block(zz, b, out);
+    }
+    ci.bytes = (uint32_t)(out.size() - ci.offset);
+    return ci;
+}
+
+// src points at the chunk payload (8 bytes of slack after the column data).
+inline void decode_chunk(const uint8_t* src, const ChunkInfo& ci, int64_t* out) {
+    alignas(32) uint64_t zz[kBlock];
+    int64_t prev = ci.first;
+    for (uint32_t b0 = 0; b0 < ci.n; b0 += kBlock) {
+        const int b = *src++;
+        unpack_block(src, b, zz);
+        src += (size_t)kBlock * b / 8;
+        prev = unzigzag_prefix(zz, (int)std::min<uint32_t>(kBlock, ci.n - b0), prev, out + b0);
+    }
+}
+
+// True if the ceil(n / kBlock) blocks of the payload have widths <= 64 and
+// fit in ci.bytes (the reader's check before any chunk is decoded).
+inline bool valid_chunk(const uint8_t* src, const ChunkInfo& ci) {
+    uint64_t pos = 0;
+    for (uint32_t b0 = 0; b0 < ci.n; b0 += kBlock) {
+        if (pos >= ci.bytes) return false;
+        const int b = src[pos];
+        if (b > 64) return false;
+        pos += 1 + (uint64_t)kBlock * b / 8;
+    }
+    return pos <= ci.bytes;
+}
+
+struct EncodedColumn {
+    std::vector<ChunkInfo> chunks;
+    std::vector<uint8_t> data;   // payloads + 8 bytes of slack
+    uint64_t n = 0;
+};
+
+inline EncodedColumn encode_column(const int64_t* q, uint64_t n) {
+    EncodedColumn c;
+    c.n = n;
+    for (uint64_t i = 0; i < n; i += kChunk)
+        c.chunks.push_back(encode_chunk(q + i, (int)std::min<uint64_t>(kChunk, n - i), c.data));
+    c.data.resize(c.data.size() + 8, 0);
+    return c;
+}
+
+// --- File container
+
+constexpr char kMagic[8] = {'A', 'T', 'S', 'T', 'C', 'Z', '1', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t n_cols;
+    uint64_t n_rows;
+    char     reserved[40];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader must be 64 bytes");
+
+struct ColumnDesc {
+    char     name[40];
+    uint8_t  is_float;     // 1: decoded as q * tick (double), 0: integer (tick = 1)
+    uint8_t  reserved0[7];
+    double   tick;
+    uint64_t dir_offset;
+    uint64_t n_chunks;
+    uint64_t data_offset;
+    uint64_t data_bytes;
+    char     reserved1[40];
+};
+static_assert(sizeof(ColumnDesc) == 128, "ColumnDesc must be 128 bytes");
+
+struct ColumnInput {
+    std::string name;
+    bool is_float;
+    double tick;                 // quantization step (1 for integers)
+    std::vector<int64_t> q;      // quantized values
+};
+
+// Writes all columns (same length) to path; returns an empty string or the error.
+inline std::string write_file(const std::string& path, const std::vector<ColumnInput>& cols) {
+    if (cols.empty()) return "no columns";
+    const uint64_t n = cols[0].q.size();
+    std::vector<EncodedColumn> enc;
+    for (const auto& c : cols) {
+        if (c.q.size() != n) return "columns of different lengths";
+        if (c.name.empty() || c.name.size() >= sizeof(ColumnDesc::name)) return "bad column name: " + c.name;
+        enc.push_back(encode_column(c.q.data(), n));
+    }
+
+    FileHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.n_cols = (uint32_t)cols.size();
+    h.n_rows = n;
+
+    std::vector<ColumnDesc> desc(cols.size(), ColumnDesc{});
+    uint64_t off = sizeof(FileHeader) + desc.size() * sizeof(ColumnDesc);
+    for (size_t k = 0; k < cols.size(); ++k) {
+        ColumnDesc& d = desc[k];
+        std::memcpy(d.name, cols[k].name.data(), cols[k].name.size());
+        d.is_float = cols[k].is_float ? 1 : 0;
+        d.tick = cols[k].tick;
+        off = (off + 7) / 8 * 8;   // ChunkInfo is read in place
+        d.dir_offset = off;
+        d.n_chunks = enc[k].chunks.size();
+        off += d.n_chunks * sizeof(ChunkInfo);
+        d.data_offset = off;
+        d.data_bytes = enc[k].data.size();
+        off += d.data_bytes;
+    }
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return "cannot create " + path;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+              std::fwrite(desc.data(), sizeof(ColumnDesc), desc.size(), f) == desc.size();
+    uint64_t pos = sizeof(FileHeader) + desc.size() * sizeof(ColumnDesc);
+    const char pad[8] = {0};
+    for (size_t k = 0; ok && k < enc.size(); ++k) {
+        ok = std::fwrite(pad, 1, desc[k].dir_offset - pos, f) == desc[k].dir_offset - pos;
+        pos = desc[k].data_offset + desc[k].data_bytes;
+        ok = ok && std::fwrite(enc[k].chunks.data(), sizeof(ChunkInfo), enc[k].chunks.size(), f) == enc[k].chunks.size() &&
+             std::fwrite(enc[k].data.data(), 1, enc[k].data.size(), f) == enc[k].data.size();
+    }
+    ok = (std::fclose(f) == 0) && ok;
+    return ok ? std::string() : "write failed: " + path;
+}
+
+// Memory-mapped reader: chunk directory and payloads are read in place.
+class Reader {
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+            ::close(fd);
+            return fail(path + ": not a tcz file (too small)");
+        }
+        size_ = (size_t)st.st_size;
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return fail("cannot map " + path);
+        base_ = static_cast<const uint8_t*>(p);
+
+        hdr_ = reinterpret_cast<const FileHeader*>(base_);
+        if (std::memcmp(hdr_->magic, kMagic, sizeof(kMagic)) != 0 || hdr_->version != kVersion)
+            return fail(path + ": bad magic or version");
+        if (sizeof(FileHeader) + (uint64_t)hdr_->n_cols * sizeof(ColumnDesc) > size_)
+            return fail(path + ": truncated header");
+        desc_ = reinterpret_cast<const ColumnDesc*>(base_ + sizeof(FileHeader));
+        // Descriptors and chunk directories are checked before anything is
+        // decoded: every chunk but the last holds kChunk values (chunk_begin and
+        // the decode_all buffer rely on it), and every payload's blocks fit in it.
+        for (int c = 0; c < columns(); ++c) {
+            const ColumnDesc& d = desc_[c];
+            if (d.dir_offset > size_ || d.n_chunks > (size_ - d.dir_offset) / sizeof(ChunkInfo) ||
+                d.data_offset > size_ || d.data_bytes > size_ - d.data_offset ||
+                d.data_bytes < 8 || d.dir_offset % 8 != 0)
+                return fail(path + ": bad column descriptor");
+            uint64_t rows = 0;
+            for (uint64_t k = 0; k < d.n_chunks; ++k) {
+                const ChunkInfo& ci = chunk(c, k);
+                const bool last = (k + 1 == d.n_chunks);
+                if (ci.n == 0 || ci.n > (uint32_t)kChunk || (!last && ci.n != (uint32_t)kChunk) ||
+                    ci.offset > d.data_bytes - 8 || ci.bytes > d.data_bytes - 8 - ci.offset)
+                    return fail(path + ": bad chunk directory");
+                if (!valid_chunk(base_ + d.data_offset + ci.offset, ci))
+                    return fail(path + ": bad chunk payload (column " + name(c) + ", chunk " + std::to_string(k) + ")");
+                rows += ci.n;
+            }
+            if (rows != hdr_->n_rows) return fail(path + ": row count mismatch");
+        }
+        return true;
+    }
+
+    // Unmaps and forgets any earlier error, so a Reader can be reopened.
+    void close() {
+        if (base_) ::munmap(const_cast<uint8_t*>(base_), size_);
+        error_.clear();
+        base_ = nullptr;
+        hdr_ = nullptr;
+        desc_ = nullptr;
+        size_ = 0;
+    }
+
+    bool ok() const { return hdr_ != nullptr && error_.empty(); }
+    const std::string& error() const { return error_; }
+    size_t file_bytes() const { return size_; }
+
+    uint64_t rows() const { return hdr_->n_rows; }
+    int columns() const { return (int)hdr_->n_cols; }
+    const ColumnDesc& desc(int c) const { return desc_[c]; }
+    std::string name(int c) const { return std::string(desc_[c].name, strnlen(desc_[c].name, sizeof(desc_[c].name))); }
+    int find(const std::string& name_) const {
+        for (int c = 0; c < columns(); ++c)
+            if (name(c) == name_) return c;
+        return -1;
+    }
+
+    uint64_t chunks(int c) const { return desc_[c].n_chunks; }
+    const ChunkInfo& chunk(int c, uint64_t k) const {
+        return reinterpret_cast<const ChunkInfo*>(base_ + desc_[c].dir_offset)[k];
+    }
+    // First row of chunk k (all chunks but the last hold kChunk rows).
+    uint64_t chunk_begin(uint64_t k) const { return k * (uint64_t)kChunk; }
+
+    // Decodes chunk k of column c into out (chunk(c, k).n quantized values).
+    void decode(int c, uint64_t k, int64_t* out) const {
+        const ChunkInfo& ci = chunk(c, k);
+        decode_chunk(base_ + desc_[c].data_offset + ci.offset, ci, out);
+    }
+
+    // Whole column, quantized.
+    std::vector<int64_t> decode_all(int c) const {
+        std::vector<int64_t> q(rows());
+        for (uint64_t k = 0; k < chunks(c); ++k) decode(c, k, q.data() + chunk_begin(k));
+        return q;
+    }
+
+private:
+    bool fail(const std::string& msg) {
+        close();
+        error_ = msg;
+        return false;
+    }
+
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    const FileHeader* hdr_ = nullptr;
+    const ColumnDesc* desc_ = nullptr;
+    std::string error_;
+};
+
+} // namespace tcz
@@ -0,0 +1,433 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "columnar.hpp"
+#include "tick_codec.hpp"
+#include "util.hpp"
+
+// Quantizes a float column on `tick`; integer columns are copied as is (no
+// double round trip, int64 above 2^53 stays exact). Returns max |x - q * tick|;
+// on_grid is false when some value is off the grid by more than the precision
+// of T, i.e. when the packed column would not decode to the stored values.
+template <class T>
+static double append_q(const col::Reader& r, const std::string& name, double tick, std::vector<int64_t>& q,
+                       bool& on_grid) {
+    col::View<T> v = r.column<T>(name);
+    q.resize(v.size);
+    double worst = 0.0;
+    on_grid = true;
+    if constexpr (std::is_integral<T>::value) {
+        for (size_t i = 0; i < v.size; ++i) q[i] = (int64_t)v[i];
+        return worst;
+    }
+    for (size_t i = 0; i < v.size; ++i) {
+        const double x = (double)v[i];
+        q[i] = tcz::quantize(x, tick);
+        const double err = std::fabs(x - (double)q[i] * tick);
+        worst = std::max(worst, err);
+        if (err > 1e-9 * tick + std::numeric_limits<T>::epsilon() * std::fabs(x)) on_grid = false;
+    }
+    return worst;
+}
+
+// tick=STEP[,NAME:STEP...]: a default step for float columns, then per-column
+// steps. Returns an empty string or the error.
+static std::string parse_ticks(const std::string& spec, double& def, std::map<std::string, double>& per) {
+    size_t a = 0;
+    while (a <= spec.size()) {
+        size_t b = spec.find(',', a);
+        if (b == std::string::npos) b = spec.size();
+        const std::string item = spec.substr(a, b - a);
+        const size_t c = item.rfind(':');
+        const std::string v = (c == std::string::npos) ? item : item.substr(c + 1);
+        char* end = nullptr;
+        const double step = std::strtod(v.c_str(), &end);
+        if (v.empty() || *end != '\0' || !(step > 0.0)) return "bad tick step in '" + item + "'";
+        if (c == std::string::npos) def = step;
+        else per[item.substr(0, c)] = step;
+        a = b + 1;
+    }
+    return "";
+}
+
+// .col -> .tcz: float columns quantized on their tick, integer columns stored
+// as is. A float column off its grid is refused unless lossy=1; the ratio is
+// reported for the lossless columns only.
+static int pack(const std::string& in, const std::string& out, const std::string& tick_spec, bool allow_lossy) {
+    double def_tick = 0.1;
+    std::map<std::string, double> ticks;
+    std::string err = parse_ticks(tick_spec, def_tick, ticks);
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    col::Reader r;
+    if (!r.open(in)) {
+        std::cerr << r.error() << "\n";
+        return 1;
+    }
+    for (const auto& kv : ticks) {
+        if (r.find(kv.first) < 0) {
+            std::cerr << in << ": no column " << kv.first << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<tcz::ColumnInput> cols;
+    std::vector<double> max_err;
+    std::vector<char> lossless;
+    for (int c = 0; c < r.columns(); ++c) {
+        tcz::ColumnInput ci;
+        ci.name = r.name(c);
+        ci.is_float = (r.type(c) == col::Type::F64 || r.type(c) == col::Type::F32);
+        auto it = ticks.find(ci.name);
+        ci.tick = !ci.is_float ? 1.0 : (it != ticks.end() ? it->second : def_tick);
+        bool on_grid = true;
+        double e = 0.0;
+        switch (r.type(c)) {
+            case col::Type::F64: e = append_q<double>(r, ci.name, ci.tick, ci.q, on_grid); break;
+            case col::Type::F32: e = append_q<float>(r, ci.name, ci.tick, ci.q, on_grid); break;
+            case col::Type::I64: e = append_q<int64_t>(r, ci.name, 1.0, ci.q, on_grid); break;
+            case col::Type::I32: e = append_q<int32_t>(r, ci.name, 1.0, ci.q, on_grid); break;
+            case col::Type::I16: e = append_q<int16_t>(r, ci.name, 1.0, ci.q, on_grid); break;
+            case col::Type::I8:  e = append_q<int8_t>(r, ci.name, 1.0, ci.q, on_grid); break;
+            case col::Type::U8:  e = append_q<uint8_t>(r, ci.name, 1.0, ci.q, on_grid); break;
+        }
+        if (!on_grid) {
+            std::cerr << (allow_lossy ? "warning: " : "") << in << ": column " << ci.name << " is not on tick "
+                      << ci.tick << " (max |x - q*tick| = " << e << ")"
+                      << (allow_lossy ? ", packed lossy\n" : "; set tick=" + ci.name + ":STEP, or lossy=1 to pack anyway\n");
+        }
+        max_err.push_back(e);
+        lossless.push_back(on_grid);
+        cols.push_back(std::move(ci));
+    }
+    if (!allow_lossy && std::find(lossless.begin(), lossless.end(), 0) != lossless.end()) return 1;
+
+    err = tcz::write_file(out, cols);
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    tcz::Reader t;
+    if (!t.open(out)) {
+        std::cerr << t.error() << "\n";
+        return 1;
+    }
+    std::cout << in << " -> " << out << ": " << r.rows() << " rows, " << t.file_bytes() << " bytes\n";
+    std::cout << std::setw(16) << "column" << std::setw(10) << "tick" << std::setw(14) << "max error"
+              << std::setw(14) << "bytes" << std::setw(10) << "ratio" << "\n";
+    uint64_t raw = 0, packed = 0;
+    for (int c = 0; c < r.columns(); ++c) {
+        const uint64_t bytes = t.desc(c).data_bytes + t.desc(c).n_chunks * sizeof(tcz::ChunkInfo);
+        std::cout << std::setw(16) << cols[c].name << std::setw(10) << std::defaultfloat << cols[c].tick
+                  << std::setw(14) << std::scientific << std::setprecision(2) << max_err[c]
+                  << std::setw(14) << bytes << std::fixed << std::setprecision(1);
+        if (lossless[c]) {
+            std::cout << std::setw(9) << (double)r.desc(c).bytes / bytes << "x\n";
+            raw += r.desc(c).bytes;
+            packed += bytes;
+        } else {
+            std::cout << std::setw(10) << "lossy" << "\n";
+        }
+    }
+    if (packed > 0)
+        std::cout << "lossless columns: " << raw << " -> " << packed << " bytes (x" << (double)raw / packed << ")\n";
+    return 0;
+}
+
+// Rows whose value lies in [lo, hi], decoding only chunks whose min/max overlap it.
+static int query(const std::string& in, const std::string& name, double lo, double hi) {
+    tcz::Reader t;
+    if (!t.open(in)) {
+        std::cerr << t.error() << "\n";
+        return 1;
+    }
+    int c = t.find(name);
+    if (c < 0) {
+        std::cerr << in << ": no column " << name << "\n";
+        return 1;
+    }
+    const double tick = t.desc(c).tick;
+    const int64_t qlo = (int64_t)std::ceil(lo / tick - 1e-9), qhi = (int64_t)std::floor(hi / tick + 1e-9);
+
+    std::vector<int64_t> buf(tcz::kChunk);
+    uint64_t hits = 0, decoded = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t k = 0; k < t.chunks(c); ++k) {
+        const tcz::ChunkInfo& ci = t.chunk(c, k);
+        if (ci.max < qlo || ci.min > qhi) continue;
+        if (ci.min >= qlo && ci.max <= qhi) { hits += ci.n; continue; }
+        t.decode(c, k, buf.data());
+        decoded++;
+        for (uint32_t i = 0; i < ci.n; ++i) hits += (buf[i] >= qlo && buf[i] <= qhi);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << name << " in [" << lo << ", " << hi << "]: " << hits << " of " << t.rows() << " rows | chunks: "
+              << t.chunks(c) << ", decoded " << decoded << " | " << std::fixed << std::setprecision(6) << secs << "s\n";
+    return 0;
+}
+
+// --- Benchmarks and round-trip checks
+
+struct Series {
+    std::string name;
+    double tick;
+    std::vector<int64_t> q;
+    size_t text_bytes;
+};
+
+static size_t text_size(const std::vector<int64_t>& q, double tick) {
+    size_t bytes = 0;
+    char buf[64];
+    for (int64_t v : q) bytes += (size_t)std::snprintf(buf, sizeof(buf), "%g ", (double)v * tick);
+    return bytes;
+}
+
+// LOB snapshots as in lob_simulator.cpp, and a GBM price path on a 1e-4 grid.
+static std::vector<Series> make_series(uint64_t n) {
+    std::vector<Series> s(5);
+    s[0] = {"lob bid_price", 0.1, {}, 0};
+    s[1] = {"lob ask_price", 0.1, {}, 0};
+    s[2] = {"lob bid_qty", 1.0, {}, 0};
+    s[3] = {"lob ask_qty", 1.0, {}, 0};
+    s[4] = {"gbm price (1e-4 grid)", 1e-4, {}, 0};
+    for (auto& x : s) x.q.resize(n);
+
+    std::mt19937 rng(42);
+    std::poisson_distribution<int> arrivals(5);
+    std::uniform_int_distribution<int> side(0, 1);
+    double bid = 100.0, ask = 100.1;
+    int bq = 100, aq = 100;
+    for (uint64_t t = 0; t < n; ++t) {
+        int events = arrivals(rng);
+        for (int i = 0; i < events; ++i) {
+            if (side(rng)) { if (--aq <= 0) { ask += 0.1; aq = 100; } }
+            else           { if (--bq <= 0) { bid -= 0.1; bq = 100; } }
+        }
+        s[0].q[t] = tcz::quantize(bid, 0.1);
+        s[1].q[t] = tcz::quantize(ask, 0.1);
+        s[2].q[t] = bq;
+        s[3].q[t] = aq;
+    }
+    std::normal_distribution<double> N(0.0, 1.0);
+    double px = 100.0;
+    for (uint64_t t = 0; t < n; ++t) {
+        px *= std::exp(1e-4 * N(rng));
+        s[4].q[t] = tcz::quantize(px, 1e-4);
+    }
+    for (auto& x : s) x.text_bytes = text_size(x.q, x.tick);
+    return s;
+}
+
+static bool round_trip(const std::vector<int64_t>& q, double* enc_s = nullptr, double* dec_s = nullptr,
+                       size_t* bytes = nullptr, int reps = 1) {
+    auto t0 = std::chrono::steady_clock::now();
+    tcz::EncodedColumn e = tcz::encode_column(q.data(), q.size());
+    if (enc_s) *enc_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (bytes) *bytes = e.data.size() + e.chunks.size() * sizeof(tcz::ChunkInfo);
+
+    std::vector<int64_t> out(q.size());
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        uint64_t row = 0;
+        for (const auto& ci : e.chunks) {
+            tcz::decode_chunk(e.data.data() + ci.offset, ci, out.data() + row);
+            row += ci.n;
+        }
+    }
+    if (dec_s) *dec_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / reps;
+    return out == q;
+}
+
+static int bench(uint64_t n) {
+    std::vector<Series> series = make_series(n);
+    std::cout << "Tick codec benchmark: " << n << " values per series\n\n";
+    std::cout << std::setw(24) << "series" << std::setw(12) << "bytes/val" << std::setw(10) << "vs raw"
+              << std::setw(10) << "vs text" << std::setw(12) << "enc GB/s" << std::setw(12) << "dec GB/s"
+              << std::setw(12) << "round trip" << "\n";
+    int failures = 0;
+    for (const auto& s : series) {
+        double enc = 0, dec = 0;
+        size_t bytes = 0;
+        bool ok = round_trip(s.q, &enc, &dec, &bytes, 5);
+        if (!ok) failures++;
+        const double raw = 8.0 * n;   // decoded int64 / f64 bytes
+        std::cout << std::setw(24) << s.name << std::fixed << std::setprecision(3)
+                  << std::setw(12) << (double)bytes / n
+                  << std::setw(9) << std::setprecision(1) << raw / bytes << "x"
+                  << std::setw(9) << (double)s.text_bytes / bytes << "x"
+                  << std::setw(12) << std::setprecision(2) << raw / 1e9 / enc
+                  << std::setw(12) << raw / 1e9 / dec
+                  << std::setw(12) << (ok ? "exact" : "MISMATCH") << "\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Round trips on adversarial inputs: every block width 0..64, int64 extremes,
+// partial blocks and chunks, constant runs.
+static int run_check() {
+    int failures = 0;
+    std::mt19937_64 rng(9);
+    auto report = [&](const std::string& what, bool ok) {
+        if (!ok) failures++;
+        std::cout << what << ": " << (ok ? "exact" : "MISMATCH") << "\n";
+    };
+
+    for (int b = 0; b <= 64; b += (b < 8 ? 1 : 7)) {
+        std::vector<int64_t> q(3 * tcz::kChunk + 77);
+        int64_t v = 0;
+        for (auto& x : q) {
+            uint64_t d = (b == 0) ? 0 : (b == 64 ? rng() : rng() & ((1ull << b) - 1));
+            v = (int64_t)((uint64_t)v + (uint64_t)tcz::unzigzag(d));
+            x = v;
+        }
+        report("delta width " + std::to_string(b), round_trip(q));
+    }
+
+    std::vector<int64_t> ext = {INT64_MIN, INT64_MAX, 0, -1, INT64_MIN, 1, INT64_MAX, INT64_MAX};
+    report("int64 extremes", round_trip(ext));
+    for (int n : {1, 2, 3, 127, 128, 129, tcz::kChunk - 1, tcz::kChunk, tcz::kChunk + 1}) {
+        std::vector<int64_t> q(n);
+        for (auto& x : q) x = (int64_t)(rng() % 2001) - 1000;
+        report("length " + std::to_string(n), round_trip(q));
+    }
+    report("constant run", round_trip(std::vector<int64_t>(100000, 424242)));
+
+    // file round trip + chunk index
+    std::vector<Series> s = make_series(200000);
+    std::vector<tcz::ColumnInput> cols;
+    for (size_t k = 0; k < s.size(); ++k) cols.push_back({"c" + std::to_string(k), s[k].tick != 1.0, s[k].tick, s[k].q});
+    const std::string path = "tick_pack_check.tcz";
+    std::string err = tcz::write_file(path, cols);
+    tcz::Reader r;
+    bool ok = err.empty() && r.open(path) && r.rows() == 200000;
+    for (int c = 0; ok && c < r.columns(); ++c) {
+        ok = r.decode_all(c) == s[c].q;
+        for (uint64_t k = 0; ok && k < r.chunks(c); ++k) {
+            const tcz::ChunkInfo& ci = r.chunk(c, k);
+            auto lo = std::min_element(s[c].q.begin() + r.chunk_begin(k), s[c].q.begin() + r.chunk_begin(k) + ci.n);
+            auto hi = std::max_element(s[c].q.begin() + r.chunk_begin(k), s[c].q.begin() + r.chunk_begin(k) + ci.n);
+            ok = (*lo == ci.min && *hi == ci.max);
+        }
+    }
+    r.close();
+    report("file round trip + chunk min/max", ok);
+
+    // corrupt chunk directories and payloads are refused by open(): a short
+    // chunk before the last, a block width above 64, widths past the payload
+    {
+        std::vector<uint8_t> file;
+        if (std::FILE* fp = std::fopen(path.c_str(), "rb")) {
+            uint8_t buf[65536];
+            for (size_t n; (n = std::fread(buf, 1, sizeof(buf), fp)) > 0; ) file.insert(file.end(), buf, buf + n);
+            std::fclose(fp);
+        }
+        bool ok2 = r.open(path) && r.chunks(0) >= 3;
+        const tcz::ColumnDesc d = ok2 ? r.desc(0) : tcz::ColumnDesc{};
+        const tcz::ChunkInfo c0 = ok2 ? r.chunk(0, 0) : tcz::ChunkInfo{};
+        r.close();
+        const std::string bad = "tick_pack_check_bad.tcz";
+        auto refused = [&](auto&& patch) {
+            std::vector<uint8_t> f = file;
+            patch(f);
+            std::FILE* fp = std::fopen(bad.c_str(), "wb");
+            bool written = fp && std::fwrite(f.data(), 1, f.size(), fp) == f.size();
+            if (fp) std::fclose(fp);
+            tcz::Reader t;
+            bool opened = t.open(bad);
+            std::remove(bad.c_str());
+            return written && !opened;
+        };
+        auto chunk_at = [&](std::vector<uint8_t>& f, uint64_t k) {
+            return reinterpret_cast<tcz::ChunkInfo*>(f.data() + d.dir_offset + k * sizeof(tcz::ChunkInfo));
+        };
+        ok2 = ok2 && refused([&](std::vector<uint8_t>& f) { chunk_at(f, 0)->n -= 1; chunk_at(f, 1)->n += 1; });
+        ok2 = ok2 && refused([&](std::vector<uint8_t>& f) { f[d.data_offset + c0.offset] = 200; });
+        ok2 = ok2 && refused([&](std::vector<uint8_t>& f) { f[d.data_offset + c0.offset] = 64; chunk_at(f, 0)->bytes = 40; });
+        report("corrupt chunk directory / payload refused", ok2);
+    }
+    std::remove(path.c_str());
+
+    // pack: a column on its grid decodes to the stored doubles; an off-grid
+    // column is refused, or packed and flagged with lossy=1
+    {
+        const std::string in = "tick_pack_check.col", out = "tick_pack_check_pack.tcz";
+        const int n = 10000;
+        std::vector<double> a(n);
+        col::Writer w;
+        bool ok2 = w.open(in, {{"a", col::Type::F64}, {"b", col::Type::F64}}, n);
+        for (int i = 0; ok2 && i < n; ++i) {
+            a[i] = (double)(1000000 + (int64_t)(rng() % 2001) - 1000) * 1e-4;
+            w.append(a[i], a[i] + 3e-7);
+        }
+        ok2 = w.close() && ok2;
+        ok2 = ok2 && pack(in, out, "1e-4", false) == 1;
+        if (std::FILE* fp = std::fopen(out.c_str(), "rb")) {   // refused: nothing written
+            std::fclose(fp);
+            ok2 = false;
+        }
+        ok2 = ok2 && pack(in, out, "0.1,a:1e-4", true) == 0;
+        tcz::Reader t;
+        if (ok2 && t.open(out)) {
+            const std::vector<int64_t> q = t.decode_all(t.find("a"));
+            for (int i = 0; ok2 && i < n; ++i) ok2 = (double)q[i] * t.desc(t.find("a")).tick == a[i];
+        } else {
+            ok2 = false;
+        }
+        t.close();
+        std::remove(in.c_str());
+        std::remove(out.c_str());
+        report("pack: per-column tick, off-grid column refused / flagged", ok2);
+    }
+
+    // pack: integer columns are copied, not rounded through double (int64
+    // nanosecond timestamps above 2^53)
+    {
+        const std::string in = "tick_pack_check_i64.col", out = "tick_pack_check_i64.tcz";
+        std::vector<int64_t> ts = {1700000000123456789, 1700000000123456790, 1700000000123456791,
+                                   INT64_MAX, INT64_MIN, (int64_t(1) << 53) + 1, -((int64_t(1) << 53) + 1)};
+        for (int i = 0; i < 5000; ++i) ts.push_back(1700000000000000000 + (int64_t)(rng() % 1000000007));
+        col::Writer w;
+        bool ok2 = w.open(in, {{"ts", col::Type::I64}}, ts.size());
+        for (int64_t v : ts) w.append(v);
+        ok2 = w.close() && ok2 && pack(in, out, "0.1", false) == 0;
+        tcz::Reader t;
+        ok2 = ok2 && t.open(out) && t.decode_all(t.find("ts")) == ts;
+        t.close();
+        std::remove(in.c_str());
+        std::remove(out.c_str());
+        report("pack: int64 above 2^53 bit-exact", ok2);
+    }
+
+    std::cout << "Tick codec check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "check") return run_check();
+    if (mode == "bench") return bench(util::arg_u64(argc, argv, "n", 10000000));
+    if (mode == "pack" && argc >= 4)
+        return pack(argv[2], argv[3], util::arg_string(argc, argv, "tick", "0.1"), util::arg_value(argc, argv, "lossy", 0) != 0);
+    if (mode == "query" && argc >= 6) return query(argv[2], argv[3], std::atof(argv[4]), std::atof(argv[5]));
+
+    std::cerr << "Usage:\n"
+              << "  tick_pack pack IN.col OUT.tcz [tick=0.1[,COLUMN:STEP...]] [lossy=1]\n"
+              << "  tick_pack query IN.tcz COLUMN LO HI\n"
+              << "  tick_pack bench [n=10000000]\n"
+              << "  tick_pack check\n";
+    return 1;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+// Small helpers shared by the standalone programs. Header-only.
+//   CompensatedSum   Neumaier running sum (prefix sums, rolling windows)
+//   RollingMeanVar   rolling mean / variance over a window (Bollinger bands, z-scores)
+//   Range            lo:hi:step sweep axis, parsed from key=lo:hi:step
+//   arg_*            key=value command-line arguments (arg_count: checked counts)
+//   AlignedAllocator 64-byte aligned std::vector storage (SIMD rows / columns)
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// Compensated (Neumaier) running sum: keeps add/remove drift at O(eps)
+// instead of O(n*eps) over millions of updates.
+struct CompensatedSum {
+    double sum = 0.0;
+    double comp = 0.0;
+
+    void add(double v) {
+        double t = sum + v;
+        if (std::fabs(sum) >= std::fabs(v)) comp += (sum - t) + v;
+        else                                 comp += (v - t) + sum;
+        sum = t;
+    }
+    double value() const { return sum + comp; }
+};
+
+// Rolling mean / population variance over the last `window` inputs, O(1) per push.
+// Welford-style updates: add while filling, then a single add+remove slide once full.
+// Moments are kept relative to an anchor K (the window mean at the last re-anchor),
+// so the updates work on small deviations instead of raw price levels. Every
+// `reanchor` slides K is moved and the moments are recomputed two-pass from the
+// ring buffer, which bounds drift at O(window/reanchor) extra work per push.
+class RollingMeanVar {
+public:
+    explicit RollingMeanVar(int window, int reanchor = 0)
+        : buf_(window, 0.0), window_(window),
+          reanchor_(reanchor > 0 ? reanchor : std::max(window, 1024)) {}
+
+    void push(double x) {
+        if (count_ == 0) anchor_ = x;
+        double xs = x - anchor_;
+        if (count_ < window_) {
+            ++count_;
+            double d = xs - mean_;
+            mean_ += d / count_;
+            m2_ += d * (xs - mean_);
+        } else {
+            double ys = buf_[head_] - anchor_;
+            double new_mean = mean_ + (xs - ys) / window_;
+            m2_ += (xs - ys) * ((xs - new_mean) + (ys - mean_));
+            mean_ = new_mean;
+        }
+        buf_[head_] = x;
+        if (++head_ == window_) head_ = 0;
+
+        if (count_ == window_ && ++since_anchor_ >= reanchor_) reanchor();
+    }
+
+    bool ready() const { return count_ == window_; }
+    double mean() const { return anchor_ + mean_; }
+    double variance() const { return count_ > 0 ? std::max(m2_, 0.0) / count_ : 0.0; }
+    double stdev() const { return std::sqrt(variance()); }
+
+private:
+    void reanchor() {
+        double s = 0.0;
+        for (double v : buf_) s += v;
+        double m = s / window_;
+        double ss = 0.0;
+        for (double v : buf_) { double d = v - m; ss += d * d; }
+        anchor_ = m;
+        mean_ = 0.0;
+        m2_ = ss;
+        since_anchor_ = 0;
+    }
+
+    std::vector<double> buf_;
+    int window_;
+    int reanchor_;
+    int head_ = 0;
+    int count_ = 0;
+    int since_anchor_ = 0;
+    double anchor_ = 0.0;
+    double mean_ = 0.0; // relative to anchor_
+    double m2_ = 0.0;
+};
+
+// Inclusive range lo:hi:step (a single value is a range of one). ok is false
+// after parse_range read a malformed value; count() is then 1.
+struct Range {
+    double lo = 0.0, hi = 0.0, step = 1.0;
+    bool ok = true;
+
+    static constexpr int kMaxCount = 1 << 20;   // points per axis
+
+    int count() const { return (ok && step > 0.0 && hi >= lo) ? (int)((hi - lo) / step + 1e-9) + 1 : 1; }
+    double at(int k) const { return lo + k * step; }
+};
+
+// Parses "key=lo[:hi[:step]]" into r; false (r untouched) if arg is another key.
+// Each part must be a number (strtod, nothing left over), with lo <= hi,
+// step > 0 and at most Range::kMaxCount points; otherwise r.ok is false.
+inline bool parse_range(const std::string& arg, const std::string& key, Range& r) {
+    if (arg.compare(0, key.size() + 1, key + "=") != 0) return false;
+    const char* p = arg.c_str() + key.size() + 1;
+    double v[3] = {0.0, 0.0, 1.0};
+    int parts = 0;
+    bool ok = true;
+    for (; ok && parts < 3; ++parts) {
+        char* end = nullptr;
+        errno = 0;
+        v[parts] = std::strtod(p, &end);
+        ok = end != p && errno != ERANGE && std::isfinite(v[parts]);
+        p = end;
+        if (!ok || *p != ':') break;
+        ++p;
+    }
+    ok = ok && *p == '\0' && parts < 3;
+    if (parts == 0) v[1] = v[0];
+    ok = ok && v[2] > 0.0 && v[0] <= v[1] && (v[1] - v[0]) / v[2] < Range::kMaxCount;
+    r.lo = v[0];
+    r.hi = v[1];
+    r.step = v[2];
+    r.ok = ok;
+    return true;
+}
+
+// Points of the grid spanned by several axes, or 0 above Range::kMaxCount.
+inline uint64_t grid_count(std::initializer_list<const Range*> axes) {
+    uint64_t n = 1;
+    for (const Range* r : axes) {
+        n *= (uint64_t)r->count();
+        if (n > (uint64_t)Range::kMaxCount) return 0;
+    }
+    return n;
+}
+
+// Message for an axis that parse_range rejected.
+inline std::string range_error(const std::string& key) {
+    return key + "= must be lo[:hi[:step]]: numbers with lo <= hi, step > 0 and at most " +
+           std::to_string(Range::kMaxCount) + " points";
+}
+
+// --- key=value command-line arguments
+// Every program scans argv[1..argc): a mode word or a file name never starts
+// with "key=", so "./prog n=100" and "./prog run n=100" read the same keys.
+// The first match wins.
+
+// True if arg is key=... (to accept a mode's scalar keys while it checks for unknown ones).
+inline bool arg_has_key(const std::string& arg, const std::string& key) {
+    return arg.compare(0, key.size(), key) == 0 && arg.size() > key.size() && arg[key.size()] == '=';
+}
+
+// Value of key=..., or nullptr if absent.
+inline const char* arg_find(int argc, char** argv, const std::string& key) {
+    const size_t n = key.size();
+    for (int a = 1; a < argc; ++a)
+        if (std::strncmp(argv[a], key.c_str(), n) == 0 && argv[a][n] == '=') return argv[a] + n + 1;
+    return nullptr;
+}
+
+inline std::string arg_string(int argc, char** argv, const std::string& key, const std::string& def) {
+    const char* v = arg_find(argc, argv, key);
+    return v ? std::string(v) : def;
+}
+
+inline double arg_value(int argc, char** argv, const std::string& key, double def) {
+    const char* v = arg_find(argc, argv, key);
+    return v ? std::atof(v) : def;
+}
+
+// Counts and seeds, exact beyond 2^53.
+inline uint64_t arg_u64(int argc, char** argv, const std::string& key, uint64_t def) {
+    const char* v = arg_find(argc, argv, key);
+    return v ? std::strtoull(v, nullptr, 10) : def;
+}
+
+// Checked count: out = def when key is absent; false when key=... is not a
+// plain decimal number in range (n=abc, n=-5, n=12x are not read as 0).
+inline bool arg_count(int argc, char** argv, const std::string& key, uint64_t def, uint64_t& out) {
+    out = def;
+    const char* v = arg_find(argc, argv, key);
+    if (!v) return true;
+    if (*v < '0' || *v > '9') return false;
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long x = std::strtoull(v, &end, 10);
+    if (*end != '\0' || errno == ERANGE) return false;
+    out = x;
+    return true;
+}
+
+// Upper bound of threads= (0 = all hardware threads) for the programs that read it as a count.
+constexpr uint64_t kMaxThreads = 1024;
+
+// arg_count limited to [lo, hi]; on failure err names the key and the accepted
+// range, so several keys can be chained with || and reported once.
+inline bool arg_count_in(int argc, char** argv, const std::string& key, uint64_t def, uint64_t lo, uint64_t hi,
+                         uint64_t& out, std::string& err) {
+    if (arg_count(argc, argv, key, def, out) && out >= lo && out <= hi) return true;
+    err = key + "= must be a count in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]";
+    return false;
+}
+
+// 64-byte aligned allocator: each vector's data starts on a cache line.
+template <class T>
+struct AlignedAllocator {
+    using value_type = T;
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = (n * sizeof(T) + 63) & ~size_t(63);
+        void* p = std::aligned_alloc(64, bytes);
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { std::free(p); }
+
+    template <class U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+} // namespace util
@@ -1,10 +1,21 @@
 #include <iostream>
 #include <vector>
 #include <random>
-#include <iomanip>
+#include <climits>
+#include <cstdint>
+#include <string>
 
-int main() {
-    const int T = 100;              // execution horizon
+#include "../Common/async_writer.hpp"
+#include "../Common/util.hpp"
+
+// ./twap_execution [T=100]    slice lines and summary to stdout
+int main(int argc, char** argv) {
+    uint64_t n = 0;                 // execution horizon
+    if (!util::arg_count(argc, argv, "T", 100, n) || n == 0 || n > INT_MAX) {
+        std::cerr << "T= must be a count in [1, " << INT_MAX << "]\n";
+        return 1;
+    }
+    const int T = (int)n;
     const double total_qty = 10000; // parent order size
     const double slice_qty = total_qty / T;
 
@@ -19,6 +30,10 @@ int main() {
     double executed_qty = 0.0;
     double cost = 0.0;
 
+    // Lines are formatted here and written by a background thread.
+    aout::Writer out;
+    out.open_fd(1);
+
     for (int t = 0; t < T; ++t) {
         // market evolution
         price *= std::exp(noise(rng));
@@ -30,20 +45,23 @@ int main() {
         executed_qty += slice_qty;
         cost += slice_qty * execution_price;
 
-        std::cout << "t=" << t
-                  << " exec_price=" << execution_price
-                  << " cum_qty=" << executed_qty << "\n";
+        out << "t=" << t
+            << " exec_price=" << execution_price
+            << " cum_qty=" << executed_qty << '\n';
     }
 
     double avg_price = cost / total_qty;
 
-    std::cout << "\nTWAP execution summary\n";
-    std::cout << "Total quantity: " << total_qty << "\n";
-    std::cout << "Average execution price: "
-              << std::fixed << std::setprecision(4)
-              << avg_price << "\n";
-    std::cout << "Implementation shortfall: "
-              << avg_price - base_price << "\n";
+    out << "\nTWAP execution summary\n";
+    out << "Total quantity: " << total_qty << '\n';
+    out << "Average execution price: "
+        << aout::Fixed{avg_price, 4} << '\n';
+    out << "Implementation shortfall: "
+        << aout::Fixed{avg_price - base_price, 4} << '\n';
 
+    if (!out.close()) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
     return 0;
 }
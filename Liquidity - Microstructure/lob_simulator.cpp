@@ -1,44 +1,320 @@
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <random>
+#include <string>
+#include <vector>
 
-struct LOB {
-    double bid_price;
-    double ask_price;
-    int bid_qty;
-    int ask_qty;
-};
+#include "../Common/async_writer.hpp"
+#include "../Common/columnar.hpp"
+#include "../Common/hawkes_lob.hpp"
+#include "../Common/lob_shards.hpp"
+#include "../Common/order_book.hpp"
+#include "../Common/tick_codec.hpp"
+#include "../Common/util.hpp"
+
+// Passive liquidity provider: keeps kDepthLevels price levels of 100 (four
+// orders of 25) on each side of the book. When market orders exhaust the touch,
+// the next level becomes the touch and a new level is posted at the back.
+constexpr int kDepthLevels = 10;
+constexpr int kOrdersPerLevel = 4;
+constexpr int64_t kLot = 25;
+
+static void post_level(lob::Book& book, lob::Side s, int64_t px) {
+    for (int k = 0; k < kOrdersPerLevel; ++k) book.add(s, px, kLot);
+}
+
+static void replenish(lob::Book& book) {
+    int64_t px[kDepthLevels], qty[kDepthLevels];
+    for (lob::Side s : {lob::Side::Buy, lob::Side::Sell}) {
+        const int dir = (s == lob::Side::Buy) ? -1 : +1;   // away from the touch
+        int n = book.top_levels(s, kDepthLevels, px, qty);
+        for (; n < kDepthLevels; ++n) {
+            px[n] = px[n - 1] + dir;
+            post_level(book, s, px[n]);
+        }
+    }
+}
+
+// --- Event-driven mode: Hawkes order flow (market / limit / cancel per side,
+// self-exciting) on the same 0.1 grid, 100.0 at the start. See ../Common/hawkes_lob.hpp.
+
+static double price_or_nan(int64_t px, double tick) {
+    return (px == lob::kNoBid || px == lob::kNoAsk) ? NAN : px * tick;
+}
+
+// Snapshots every dt seconds of simulated time: t bid ask bid_qty ask_qty.
+static int run_hawkes(double horizon, double dt, uint64_t seed) {
+    const double tick = 0.1;
+    hawkes::Params p = hawkes::Params::standard();
+    p.mid = 1000;
+    hawkes::Queue q;
+    hawkes::BookSim sim(p, seed, 0);
+    sim.start(q);
+    aout::Writer out;
+    out.open_fd(1);
+    for (double t = dt; t <= horizon + 1e-9; t += dt) {
+        hawkes::run(sim, q, t, [](const hawkes::Record&) {});
+        const lob::Book& b = sim.book();
+        out << t << ' ' << price_or_nan(b.best_bid(), tick) << ' ' << price_or_nan(b.best_ask(), tick) << ' '
+            << b.depth(lob::Side::Buy, b.best_bid()) << ' ' << b.depth(lob::Side::Sell, b.best_ask()) << '\n';
+    }
+    if (!out.close()) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Event log of the first n events as a columnar file: time, kind (hawkes::Kind),
+// price, quantity and executed quantity of the event, and the touch after it.
+static int write_events(const char* path, uint64_t n, uint64_t seed) {
+    const double tick = 0.1;
+    hawkes::Params p = hawkes::Params::standard();
+    p.mid = 1000;
+    col::Writer out;
+    if (!out.open(path, {{"t", col::Type::F64}, {"kind", col::Type::U8}, {"price", col::Type::F64},
+                         {"qty", col::Type::I32}, {"filled", col::Type::I32},
+                         {"bid_price", col::Type::F64}, {"ask_price", col::Type::F64}}, n)) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
+    hawkes::Queue q;
+    hawkes::BookSim sim(p, seed, 0);
+    sim.start(q);
+    double t;
+    hawkes::Event e;
+    for (uint64_t k = 0; k < n && q.pop(t, e); ++k) {
+        const hawkes::Record r = sim.apply(e, t, q);
+        const lob::Book& b = sim.book();
+        out.append(r.t, r.kind, r.price * tick, (int32_t)r.qty, (int32_t)r.filled,
+                   price_or_nan(b.best_bid(), tick), price_or_nan(b.best_ask(), tick));
+    }
+    if (!out.close()) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// --- Market-wide sessions: many books sharded over threads (../Common/lob_shards.hpp)
+
+// One line per interval, then the session totals and distributions.
+static int run_universe(size_t n_books, double horizon, double dt, int n_threads, uint64_t seed) {
+    hawkes::Params p = hawkes::Params::standard();
+    p.mid = 1000;
+    const int n_intervals = std::max(1, (int)std::lround(horizon / dt));
+    shard::Stats total;
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    std::cout << std::fixed;
+    std::cout << std::setw(8) << "t" << std::setw(11) << "events" << std::setw(9) << "markets" << std::setw(9)
+              << "volume" << std::setw(8) << "spread" << std::setw(8) << "1 tick" << std::setw(10) << "one-sided" << "\n";
+    const auto t0 = std::chrono::steady_clock::now();
+    const int used = shard::run_session(n_books, p, seed, n_threads, n_intervals, dt,
+                                        [&](int, double t_end, const shard::Stats& st) {
+        total.merge(st);
+        hash = st.hash(hash);
+        std::cout << std::setprecision(1) << std::setw(8) << t_end << std::setw(11) << st.events << std::setw(9)
+                  << st.market_orders << std::setw(9) << st.volume << std::setprecision(2) << std::setw(8)
+                  << st.mean_spread() << std::setprecision(1) << std::setw(7)
+                  << 100.0 * st.spread[0] / std::max<uint64_t>(1, st.books) << "%" << std::setw(10) << st.one_sided << "\n";
+    });
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "\n" << n_books << " books, " << n_intervals << " intervals of " << std::setprecision(2) << dt
+              << " s, " << used << " thread(s): " << total.events << " events in " << secs << " s ("
+              << std::setprecision(1) << total.events / secs / 1e6 << " M events/s), " << total.volume << " traded\n";
+    std::cout << "Spread at interval ends (ticks):";
+    for (int k = 0; k < shard::kSpreadBins; ++k)
+        if (total.spread[k])
+            std::cout << " " << (k + 1) << (k + 1 == shard::kSpreadBins ? "+" : "") << ": " << std::setprecision(1)
+                      << 100.0 * total.spread[k] / total.books << "%";
+    std::cout << "\nTop-of-book imbalance at interval ends, " << shard::kImbalanceBins << " bins over [-1, 1] (%):";
+    for (int k = 0; k < shard::kImbalanceBins; ++k)
+        std::cout << " " << std::setprecision(1) << 100.0 * total.imbalance[k] / std::max<uint64_t>(1, total.books - total.one_sided);
+    std::cout << "\nSession hash: " << std::hex << hash << std::dec << "\n";
+    return 0;
+}
+
+// Sessions on 1, 2, 3 and 8 threads against a single-threaded reference that
+// runs the books one by one over the whole session.
+static int run_check() {
+    const size_t n_books = 120;
+    const int n_intervals = 20;
+    const double dt = 0.5;
+    const uint64_t seed = 17;
+    hawkes::Params p = hawkes::Params::standard();
+    p.mid = 1000;
+
+    std::vector<shard::Stats> ref(n_intervals);
+    for (size_t i = 0; i < n_books; ++i) {
+        hawkes::Queue q;
+        hawkes::BookSim sim(p, seed, (uint32_t)i);
+        sim.start(q);
+        for (int k = 0; k < n_intervals; ++k) {
+            hawkes::run(sim, q, (k + 1) * dt, [&](const hawkes::Record& r) { ref[k].add_event(r); });
+            ref[k].add_book(sim.book());
+        }
+    }
+
+    int failures = 0;
+    for (int threads : {1, 2, 3, 8}) {
+        std::vector<shard::Stats> got;
+        const int used = shard::run_session(n_books, p, seed, threads, n_intervals, dt,
+                                            [&](int, double, const shard::Stats& st) { got.push_back(st); });
+        bool same = got.size() == ref.size();
+        for (size_t k = 0; same && k < got.size(); ++k) same = got[k] == ref[k];
+        std::cout << n_books << " books x " << n_intervals << " intervals on " << used << " thread(s): "
+                  << (same ? "identical to the reference" : "DIFFERENT") << "\n";
+        if (!same) ++failures;
+    }
+    std::cout << (failures == 0 ? "Sharded session check: OK" : "Sharded session check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// Horizon t= and step (dt= or interval=) of the timed modes: both positive, and
+// at most INT_MAX steps, or the snapshot loop would never reach the horizon.
+static bool valid_horizon(double t, double dt, const char* step_key) {
+    if (t > 0 && dt > 0 && t / dt <= INT_MAX) return true;
+    std::cerr << "Need t > 0 and " << step_key << " > 0 (seconds), with at most " << INT_MAX << " steps\n";
+    return false;
+}
+
+static int usage() {
+    std::cerr << "Usage: lob_simulator [n=T]\n"
+                 "       lob_simulator write FILE [n=T] | pack FILE [n=T]\n"
+                 "       lob_simulator hawkes [t=3600] [dt=1] [seed=42]\n"
+                 "       lob_simulator events FILE [n=1000000] [seed=42]\n"
+                 "       lob_simulator universe [books=1000] [t=60] [interval=1] [threads=0] [seed=42]\n"
+                 "       lob_simulator check\n";
+    return 1;
+}
+
+// ./lob_simulator [n=T]                text to stdout (bid ask bid_qty ask_qty)
+// ./lob_simulator write FILE [n=T]     columnar binary file (bid/ask f64, quantities i32)
+// ./lob_simulator pack FILE [n=T]      compressed tick file (prices on the 0.1 grid, quantities as is)
+// ./lob_simulator hawkes [t=3600] [dt=1] [seed=42]   event-driven Hawkes flow, snapshots every dt seconds
+// ./lob_simulator events FILE [n=1000000] [seed=42]  its event log as a columnar file
+// ./lob_simulator universe [books=1000] [t=60] [interval=1] [threads=0] [seed=42]  many books, sharded over threads
+// ./lob_simulator check                 sharded sessions vs a single-threaded reference
+int main(int argc, char** argv) {
+    std::string err;
+    if (argc > 1 && std::string(argv[1]) == "universe") {
+        uint64_t books = 0, threads = 0;
+        if (!util::arg_count_in(argc, argv, "books", 1000, 1, UINT32_MAX, books, err) ||
+            !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        const double t = util::arg_value(argc, argv, "t", 60), dt = util::arg_value(argc, argv, "interval", 1);
+        if (!valid_horizon(t, dt, "interval")) return 1;
+        return run_universe(books, t, dt, (int)threads, util::arg_u64(argc, argv, "seed", 42));
+    }
+    if (argc > 1 && std::string(argv[1]) == "check") return run_check();
+    if (argc > 1 && std::string(argv[1]) == "hawkes") {
+        const double t = util::arg_value(argc, argv, "t", 3600), dt = util::arg_value(argc, argv, "dt", 1);
+        if (!valid_horizon(t, dt, "dt")) return 1;
+        return run_hawkes(t, dt, util::arg_u64(argc, argv, "seed", 42));
+    }
+
+    // file modes need FILE; text mode takes no mode word
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    const bool binary = (mode == "write");
+    const bool packed = (mode == "pack");
+    if (binary || packed || mode == "events") {
+        if (argc < 3 || std::strchr(argv[2], '=') != nullptr) return usage();
+    } else if (!mode.empty() && mode.compare(0, 2, "n=") != 0) {
+        return usage();
+    }
+    uint64_t n = 0;
+    if (!util::arg_count_in(argc, argv, "n", mode == "events" ? 1000000 : 5000, 1, INT_MAX, n, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    if (mode == "events") return write_events(argv[2], n, util::arg_u64(argc, argv, "seed", 42));
+    const int T = (int)n;
+
+    const double tick = 0.1;
+    std::vector<tcz::ColumnInput> cols;
+    if (packed) {
+        cols = {{"bid_price", true, tick, {}}, {"ask_price", true, tick, {}},
+                {"bid_qty", false, 1.0, {}}, {"ask_qty", false, 1.0, {}}};
+        for (auto& c : cols) c.q.reserve(T);
+    }
+
+    // Text lines are formatted in the loop and written by a background thread.
+    aout::Writer text;
+    if (!binary && !packed) text.open_fd(1);
+
+    col::Writer out;
+    if (binary && !out.open(argv[2], {{"bid_price", col::Type::F64}, {"ask_price", col::Type::F64},
+                                      {"bid_qty", col::Type::I32}, {"ask_qty", col::Type::I32}}, T)) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
 
-int main() {
     std::mt19937 rng(42);
     std::poisson_distribution<int> arrivals(5);
     std::uniform_int_distribution<int> side(0,1);
 
-    LOB book{100.0, 100.1, 100, 100};
+    // Full-depth book on the 0.1 grid (prices in ticks), 100.0 / 100.1 at the start
+    lob::Book book;
+    post_level(book, lob::Side::Buy, 1000);
+    post_level(book, lob::Side::Sell, 1001);
+    replenish(book);
 
-    for(int t=0; t<5000; ++t){
+    for(int t=0; t<T; ++t){
         int events = arrivals(rng);
         for(int i=0;i<events;i++){
             bool buy = side(rng);
 
-            if(buy){
-                book.ask_qty -= 1;
-                if(book.ask_qty <= 0){
-                    book.ask_price += 0.1;
-                    book.ask_qty = 100;
-                }
-            } else {
-                book.bid_qty -= 1;
-                if(book.bid_qty <= 0){
-                    book.bid_price -= 0.1;
-                    book.bid_qty = 100;
-                }
-            }
+            // unit market order, filled FIFO at the touch
+            book.market(buy ? lob::Side::Buy : lob::Side::Sell, 1);
+            replenish(book);
+        }
+
+        const double bid_price = book.best_bid() * tick, ask_price = book.best_ask() * tick;
+        const int bid_qty = (int)book.depth(lob::Side::Buy, book.best_bid());
+        const int ask_qty = (int)book.depth(lob::Side::Sell, book.best_ask());
+
+        if(binary){
+            out.append(bid_price, ask_price, bid_qty, ask_qty);
+            continue;
+        }
+        if(packed){
+            cols[0].q.push_back(book.best_bid());
+            cols[1].q.push_back(book.best_ask());
+            cols[2].q.push_back(bid_qty);
+            cols[3].q.push_back(ask_qty);
+            continue;
         }
 
-        std::cout << book.bid_price << " "
-                  << book.ask_price << " "
-                  << book.bid_qty   << " "
-                  << book.ask_qty   << "\n";
+        text << bid_price << ' '
+             << ask_price << ' '
+             << bid_qty   << ' '
+             << ask_qty   << '\n';
+    }
+
+    if(!text.close()){
+        std::cerr << text.error() << "\n";
+        return 1;
+    }
+    if(binary && !out.close()){
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
+    if(packed){
+        std::string write_err = tcz::write_file(argv[2], cols);
+        if(!write_err.empty()){
+            std::cerr << write_err << "\n";
+            return 1;
+        }
     }
 
     return 0;
@@ -1,6 +1,20 @@
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <random>
+#include <string>
+#include <vector>
+
+#include "../Common/columnar.hpp"
+#include "../Common/ctr_rng.hpp"
+#include "../Common/hawkes_lob.hpp"
+#include "../Common/ofi_features.hpp"
+#include "../Common/tick_codec.hpp"
+#include "../Common/util.hpp"
 
 enum class PosState { FLAT, LONG, SHORT };
 
@@ -11,7 +25,455 @@ struct LOB {
     int ask_qty;
 };
 
-int main(){
+const double theta = 0.6;
+const double theta_exit = 0.2;
+const int max_hold = 50;
+
+// Imbalance rule on one snapshot: enter beyond theta, exit inside theta_exit
+// or after max_hold steps.
+static void decide(PosState& pos, int& hold, double I) {
+    if(pos == PosState::FLAT){
+        if(I > theta){
+            pos = PosState::LONG;
+            hold = 0;
+        } else if(I < -theta){
+            pos = PosState::SHORT;
+            hold = 0;
+        }
+    } else {
+        hold++;
+        if(std::fabs(I) < theta_exit || hold > max_hold){
+            pos = PosState::FLAT;
+        }
+    }
+}
+
+// Same rule on the event-driven Hawkes book (../Common/hawkes_lob.hpp), one
+// step per second of simulated time, queues read at the touch.
+static int run_hawkes(int T, uint64_t seed){
+    hawkes::Queue q;
+    hawkes::BookSim sim(hawkes::Params::standard(), seed, 0);
+    sim.start(q);
+
+    PosState pos = PosState::FLAT;
+    int hold = 0;
+
+    for(int t=0;t<T;t++){
+        hawkes::run(sim, q, t + 1.0, [](const hawkes::Record&) {});
+        const lob::Book& b = sim.book();
+        const int64_t bid_qty = b.depth(lob::Side::Buy, b.best_bid());
+        const int64_t ask_qty = b.depth(lob::Side::Sell, b.best_ask());
+        double I = bid_qty + ask_qty > 0 ? (bid_qty - ask_qty) / double(bid_qty + ask_qty) : 0.0;
+
+        decide(pos, hold, I);
+
+        if(t % 500 == 0){
+            std::cout << "t=" << t
+                      << " I=" << I
+                      << " pos=" << int(pos)
+                      << "\n";
+        }
+    }
+    return 0;
+}
+
+// --- Recorded books: the snapshots written by lob_simulator (write FILE as
+// columns, pack FILE as tcz), one decision per snapshot. A position earns the
+// mid change until the next snapshot.
+
+struct Replay {
+    PosState pos = PosState::FLAT;
+    int hold = 0;
+    uint64_t t = 0, entries = 0;
+    double last_mid = NAN, pnl = 0.0;
+
+    void step(const LOB& s){
+        const double mid = 0.5 * (s.bid_price + s.ask_price);
+        if(pos != PosState::FLAT) pnl += (pos == PosState::LONG ? 1.0 : -1.0) * (mid - last_mid);
+        last_mid = mid;
+
+        const int qsum = s.bid_qty + s.ask_qty;
+        double I = qsum > 0 ? (s.bid_qty - s.ask_qty) / double(qsum) : 0.0;
+
+        const PosState before = pos;
+        decide(pos, hold, I);
+        if(before == PosState::FLAT && pos != PosState::FLAT) ++entries;
+
+        if(t % 500 == 0){
+            std::cout << "t=" << t
+                      << " I=" << I
+                      << " pos=" << int(pos)
+                      << "\n";
+        }
+        ++t;
+    }
+};
+
+static int run_replay(const std::string& path){
+    Replay r;
+    col::Reader cr;
+    tcz::Reader tr;
+    if(cr.open(path)){
+        col::View<double> bp = cr.column<double>("bid_price"), ap = cr.column<double>("ask_price");
+        col::View<int32_t> bq = cr.column<int32_t>("bid_qty"), aq = cr.column<int32_t>("ask_qty");
+        if(!bp || !ap || !bq || !aq){
+            std::cerr << path << ": need columns bid_price, ask_price (f64), bid_qty, ask_qty (i32)\n";
+            return 1;
+        }
+        for(size_t i = 0; i < bp.size; ++i) r.step(LOB{bp[i], ap[i], bq[i], aq[i]});
+    } else if(tr.open(path)){
+        const int c[4] = {tr.find("bid_price"), tr.find("ask_price"), tr.find("bid_qty"), tr.find("ask_qty")};
+        if(c[0] < 0 || c[1] < 0 || c[2] < 0 || c[3] < 0){
+            std::cerr << path << ": need columns bid_price, ask_price, bid_qty, ask_qty\n";
+            return 1;
+        }
+        // all columns share the chunk grid: decode one chunk of each, then walk it
+        std::vector<int64_t> q[4];
+        for(auto& v : q) v.resize(tcz::kChunk);
+        const double bid_tick = tr.desc(c[0]).tick, ask_tick = tr.desc(c[1]).tick;
+        for(uint64_t k = 0; k < tr.chunks(c[0]); ++k){
+            for(int j = 0; j < 4; ++j) tr.decode(c[j], k, q[j].data());
+            const uint32_t n = tr.chunk(c[0], k).n;
+            for(uint32_t i = 0; i < n; ++i)
+                r.step(LOB{q[0][i] * bid_tick, q[1][i] * ask_tick, (int)q[2][i], (int)q[3][i]});
+        }
+    } else {
+        // neither layout: report the open failure, else the format mismatch
+        if(tr.error().compare(0, 11, "cannot open") == 0) std::cerr << tr.error() << "\n";
+        else std::cerr << path << ": neither a columnar nor a tcz file (lob_simulator write / pack)\n";
+        return 1;
+    }
+
+    std::cout << "Snapshots: " << r.t << " | Entries: " << r.entries
+              << " | Mid PnL (price units): " << std::fixed << std::setprecision(4) << r.pnl << "\n";
+    return 0;
+}
+
+// --- Universe: many Hawkes books, order-flow features from
+// ofi::Engine (../Common/ofi_features.hpp), updated on every book event and
+// refreshed for all symbols once per second.
+
+static double seconds_since(std::chrono::steady_clock::time_point t0){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Books never interact, so each one runs on its own event queue: between two
+// refreshes, the books are advanced one after the other, each with its queue
+// and book hot in cache.
+struct Universe {
+    std::vector<hawkes::Queue> queues;
+    std::vector<hawkes::BookSim> books;
+
+    Universe(size_t n, uint64_t seed) : queues(n, hawkes::Queue(512)) {
+        const hawkes::Params p = hawkes::Params::standard();
+        books.reserve(n);
+        for(size_t i = 0; i < n; ++i){
+            books.emplace_back(p, seed, (uint32_t)i);
+            books.back().start(queues[i]);
+        }
+    }
+
+    // Applies every book's events before t_end; on(book index) after each one
+    // that changed its book.
+    template <class Fn>
+    uint64_t advance(double t_end, Fn&& on){
+        uint64_t n = 0;
+        for(size_t s = 0; s < books.size(); ++s)
+            n += hawkes::run(books[s], queues[s], t_end, [&](const hawkes::Record& r){
+                if(r.price != 0) on((uint32_t)s);
+            });
+        return n;
+    }
+};
+
+static double mid_of(const lob::Book& b){
+    if(b.best_bid() == lob::kNoBid || b.best_ask() == lob::kNoAsk) return NAN;
+    return 0.5 * (double)(b.best_bid() + b.best_ask());
+}
+
+// Pearson correlation from running sums.
+struct Corr {
+    double n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+    void add(double x, double y){ n += 1; sx += x; sy += y; sxx += x * x; syy += y * y; sxy += x * y; }
+    double value() const {
+        const double vx = n * sxx - sx * sx, vy = n * syy - sy * sy;
+        return (vx > 0 && vy > 0) ? (n * sxy - sx * sy) / std::sqrt(vx * vy) : 0.0;
+    }
+};
+
+// Features of symbol s, in the order of feature_names().
+static int features_of(const ofi::Engine& f, size_t s, double* out){
+    int k = 0;
+    out[k++] = f.imbalance()[s];
+    out[k++] = f.depth_imbalance()[s];
+    for(int h = 0; h < f.horizons(); ++h) out[k++] = f.ofi(h)[s];
+    for(int h = 0; h < f.horizons(); ++h) out[k++] = f.mlofi(h)[s];
+    return k;
+}
+
+static std::vector<std::string> feature_names(const ofi::Engine& f){
+    std::vector<std::string> names = {"imbalance", "depth imbalance"};
+    for(int h = 0; h < f.horizons(); ++h) names.push_back("OFI " + std::to_string((int)f.horizon(h)) + "s");
+    for(int h = 0; h < f.horizons(); ++h) names.push_back("ML-OFI " + std::to_string((int)f.horizon(h)) + "s");
+    return names;
+}
+
+// Runs the universe for T seconds: features at each second against the mid
+// change over the next second, pooled over symbols; the imbalance rule on the
+// depth-weighted imbalance of every book.
+static int run_universe(size_t n_books, int T, uint64_t seed){
+    Universe u(n_books, seed);
+    ofi::Engine f(n_books, ofi::Config{});
+    for(size_t s = 0; s < n_books; ++s) f.update(s, u.books[s].book());
+
+    const std::vector<std::string> names = feature_names(f);
+    const int nf = (int)names.size();
+    std::vector<Corr> corr(nf);
+    std::vector<double> prev((size_t)nf * n_books, 0.0), mid(n_books, NAN);
+    std::vector<PosState> pos(n_books, PosState::FLAT);
+    std::vector<int> hold(n_books, 0);
+    uint64_t events = 0, entries = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for(int t = 0; t < T; t++){
+        events += u.advance(t + 1.0, [&](uint32_t s){ f.update(s, u.books[s].book()); });
+        f.refresh(1.0);
+        const double* di = f.depth_imbalance();
+        for(size_t s = 0; s < n_books; ++s){
+            double x[2 + 2 * ofi::kMaxHorizons];
+            features_of(f, s, x);
+            const double m = mid_of(u.books[s].book());
+            if(t > 0 && !std::isnan(m) && !std::isnan(mid[s]))
+                for(int k = 0; k < nf; ++k) corr[k].add(prev[(size_t)k * n_books + s], m - mid[s]);
+            for(int k = 0; k < nf; ++k) prev[(size_t)k * n_books + s] = x[k];
+            mid[s] = m;
+
+            const PosState before = pos[s];
+            decide(pos[s], hold[s], di[s]);
+            if(before == PosState::FLAT && pos[s] != PosState::FLAT) ++entries;
+        }
+    }
+    const double secs = seconds_since(t0);
+
+    std::cout << n_books << " books, " << T << " s: " << events << " events in " << std::fixed << std::setprecision(2)
+              << secs << " s (" << std::setprecision(1) << events / secs / 1e6 << " M events/s with features)\n";
+    std::cout << "Correlation of each feature with the mid change over the next second:\n";
+    std::cout << std::setprecision(3);
+    for(int k = 0; k < nf; ++k) std::cout << "  " << std::left << std::setw(16) << names[k] << std::right << std::setw(8) << corr[k].value() << "\n";
+    std::cout << "Depth-imbalance entries (theta " << theta << "): " << entries << "\n";
+    return 0;
+}
+
+static int run_bench(size_t n_books, uint64_t n_events){
+    std::cout << std::fixed << std::setprecision(1);
+    {
+        Universe u(n_books, 1);
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t n = 0;
+        for(double t = 1; n < n_events; t += 1) n += u.advance(t, [](uint32_t){});
+        const double flow = seconds_since(t0);
+
+        Universe v(n_books, 1);
+        ofi::Engine f(n_books, ofi::Config{});
+        t0 = std::chrono::steady_clock::now();
+        uint64_t m = 0;
+        for(double t = 1; m < n_events; t += 1){
+            m += v.advance(t, [&](uint32_t s){ f.update(s, v.books[s].book()); });
+            f.refresh(1.0);
+        }
+        const double both = seconds_since(t0);
+        std::cout << n_books << " books: flow alone " << n / flow / 1e6 << " M events/s, with feature updates "
+                  << m / both / 1e6 << " M events/s (" << std::setprecision(0) << (both / m - flow / n) * 1e9
+                  << " ns per event, 5 levels)\n" << std::setprecision(1);
+    }
+
+    for(size_t n : {1000, 10000, 100000}){
+        ofi::Engine a(n, ofi::Config{}), b(n, ofi::Config{});
+        ctr::Stream rng(5, 0, 0);
+        int64_t bp[5], bq[5], ap[5], aq[5];
+        for(size_t s = 0; s < n; ++s){
+            for(int l = 0; l < 5; ++l){
+                bp[l] = 1000 - l; ap[l] = 1001 + l;
+                bq[l] = 1 + rng.next_u32() % 50; aq[l] = 1 + rng.next_u32() % 50;
+            }
+            a.update(s, bp, bq, 5, ap, aq, 5);
+            b.update(s, bp, bq, 5, ap, aq, 5);
+        }
+        const int reps = (int)std::max<size_t>(10, 20000000 / n);
+        auto t0 = std::chrono::steady_clock::now();
+        for(int r = 0; r < reps; ++r) a.refresh(1.0);
+        const double simd = seconds_since(t0) / reps;
+        t0 = std::chrono::steady_clock::now();
+        for(int r = 0; r < reps; ++r) b.refresh_scalar(1.0);
+        const double scalar = seconds_since(t0) / reps;
+        std::cout << "Refresh of " << std::setw(6) << n << " symbols: " << std::setprecision(2) << simd * 1e9 / n
+                  << " ns per symbol (scalar " << scalar * 1e9 / n << ", x" << scalar / simd << ")\n"
+                  << std::setprecision(1);
+    }
+    return 0;
+}
+
+static int run_check(){
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string& what){
+        if(!ok){
+            std::cout << "FAILED: " << what << "\n";
+            ++failures;
+        }
+    };
+
+    // Cont OFI on one level, no decay over the test
+    {
+        ofi::Config c;
+        c.levels = 1;
+        c.horizons = {1e300};
+        ofi::Engine f(1, c);
+        double last = 0.0;
+        auto step = [&](int64_t b, int64_t qb, int64_t a, int64_t qa){
+            f.update(0, &b, &qb, 1, &a, &qa, 1);
+            f.refresh(1.0);
+            const double e = f.ofi(0)[0] - last;
+            last = f.ofi(0)[0];
+            return e;
+        };
+        step(100, 10, 101, 10);
+        expect(step(100, 15, 101, 10) == 5, "bid queue grows: +5");
+        expect(step(100, 15, 101, 7) == 3, "ask queue depleted by 3: +3");
+        expect(step(100, 15, 101, 12) == -5, "ask queue grows: -5");
+        expect(step(99, 8, 101, 12) == -15, "bid level gone: -old bid queue");
+        expect(step(100, 4, 101, 12) == 4, "better bid: +new bid queue");
+        expect(step(100, 4, 102, 6) == 12, "ask level gone: +old ask queue");
+        expect(step(100, 4, 101, 2) == -2, "better ask: -new ask queue");
+        expect(f.imbalance()[0] == (4.0 - 2.0) / 6.0, "top imbalance");
+    }
+
+    // SIMD refresh vs scalar, and both vs a per-symbol reference, on a universe
+    {
+        const size_t n = 37;   // not a multiple of 4
+        Universe u(n, 9);
+        ofi::Config c;
+        ofi::Engine f(n, c), g(n, c);
+        for(size_t s = 0; s < n; ++s){ f.update(s, u.books[s].book()); g.update(s, u.books[s].book()); }
+
+        struct Ref { std::vector<int64_t> bp, bq, ap, aq; double acc_top = 0, acc_ml = 0; std::vector<double> o, m; };
+        std::vector<Ref> ref(n);
+        auto levels = [&](size_t s, Ref& r){
+            r.bp.assign(c.levels, lob::kNoBid); r.ap.assign(c.levels, lob::kNoAsk);
+            r.bq.assign(c.levels, 0); r.aq.assign(c.levels, 0);
+            u.books[s].book().top_levels(lob::Side::Buy, c.levels, r.bp.data(), r.bq.data());
+            u.books[s].book().top_levels(lob::Side::Sell, c.levels, r.ap.data(), r.aq.data());
+        };
+        for(size_t s = 0; s < n; ++s){
+            levels(s, ref[s]);
+            ref[s].o.assign(c.horizons.size(), 0.0);
+            ref[s].m.assign(c.horizons.size(), 0.0);
+        }
+
+        double worst = 0.0;
+        auto close = [&](double x, double y){
+            const double d = std::fabs(x - y) / (1.0 + std::fabs(y));
+            worst = std::max(worst, d);
+            return d < 1e-9;
+        };
+        bool same_simd = true, same_ref = true;
+        for(int t = 0; t < 300; t++){
+            u.advance(t + 1.0, [&](uint32_t s){
+                f.update(s, u.books[s].book());
+                g.update(s, u.books[s].book());
+                Ref r;
+                levels(s, r);
+                double ml = 0.0;
+                for(int l = 0; l < c.levels; ++l){
+                    const Ref& p = ref[s];
+                    double e = 0.0;
+                    if(r.bp[l] >= p.bp[l]) e += r.bq[l];
+                    if(r.bp[l] <= p.bp[l]) e -= p.bq[l];
+                    if(r.ap[l] <= p.ap[l]) e -= r.aq[l];
+                    if(r.ap[l] >= p.ap[l]) e += p.aq[l];
+                    if(l == 0) ref[s].acc_top += e;
+                    ml += std::exp(-c.depth_decay * l) * e;
+                }
+                ref[s].acc_ml += ml;
+                ref[s].bp = r.bp; ref[s].bq = r.bq; ref[s].ap = r.ap; ref[s].aq = r.aq;
+            });
+            f.refresh(1.0);
+            g.refresh_scalar(1.0);
+            for(size_t s = 0; s < n; ++s){
+                Ref& r = ref[s];
+                double diff = 0.0, sum = 0.0;
+                for(int l = 0; l < c.levels; ++l){
+                    const double w = std::exp(-c.depth_decay * l);
+                    diff += w * (double)(r.bq[l] - r.aq[l]);
+                    sum += w * (double)(r.bq[l] + r.aq[l]);
+                }
+                const double qsum = (double)(r.bq[0] + r.aq[0]);
+                const double imb = qsum > 0 ? (r.bq[0] - r.aq[0]) / qsum : 0.0;
+                same_ref = same_ref && close(g.imbalance()[s], imb) && close(g.depth_imbalance()[s], sum > 0 ? diff / sum : 0.0);
+                for(size_t h = 0; h < c.horizons.size(); ++h){
+                    const double d = std::exp(-1.0 / c.horizons[h]);
+                    r.o[h] = r.o[h] * d + r.acc_top;
+                    r.m[h] = r.m[h] * d + r.acc_ml;
+                    same_ref = same_ref && close(g.ofi((int)h)[s], r.o[h]) && close(g.mlofi((int)h)[s], r.m[h]);
+                    same_simd = same_simd && close(f.ofi((int)h)[s], g.ofi((int)h)[s]) && close(f.mlofi((int)h)[s], g.mlofi((int)h)[s]);
+                }
+                same_simd = same_simd && close(f.imbalance()[s], g.imbalance()[s]) &&
+                            close(f.depth_imbalance()[s], g.depth_imbalance()[s]);
+                r.acc_top = r.acc_ml = 0.0;
+            }
+        }
+        expect(same_ref, "features vs per-symbol reference");
+        expect(same_simd, "SIMD refresh vs scalar refresh");
+        std::cout << "Features of " << n << " books over 300 s: engine vs reference and SIMD vs scalar "
+                  << ((same_ref && same_simd) ? "agree" : "DIFFER") << " (max relative difference "
+                  << std::scientific << std::setprecision(1) << worst << std::defaultfloat << ")\n";
+    }
+
+    std::cout << (failures == 0 ? "Order-flow features check: OK" : "Order-flow features check: FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+static int usage(const std::string& err, const char* args){
+    std::cerr << err << "\nUsage: order_flow_alpha " << args << "\n";
+    return 1;
+}
+
+// ./order_flow_alpha                                  Poisson unit market orders, top-of-book queues
+// ./order_flow_alpha hawkes [T=5000] [seed=123]         Hawkes market / limit / cancel flow on a full book
+// ./order_flow_alpha run data=FILE                      the rule on a lob_simulator write / pack file
+// ./order_flow_alpha universe [books=1000] [T=600] [seed=123]   many books, multi-level OFI features
+// ./order_flow_alpha bench [books=1000] [events=10000000]      feature update and refresh throughput
+// ./order_flow_alpha check                              OFI cases, features vs reference, SIMD vs scalar
+int main(int argc, char** argv){
+    const std::string mode = argc > 1 ? argv[1] : "";
+    uint64_t books = 0, T = 0, events = 0;
+    std::string err;
+    if(mode == "hawkes"){
+        if(!util::arg_count_in(argc, argv, "T", 5000, 1, INT_MAX, T, err))
+            return usage(err, "hawkes [T=5000] [seed=123]");
+        return run_hawkes((int)T, util::arg_u64(argc, argv, "seed", 123));
+    }
+    if(mode == "universe"){
+        if(!util::arg_count_in(argc, argv, "books", 1000, 1, UINT32_MAX, books, err) ||
+           !util::arg_count_in(argc, argv, "T", 600, 1, INT_MAX, T, err))
+            return usage(err, "universe [books=1000] [T=600] [seed=123]");
+        return run_universe(books, (int)T, util::arg_u64(argc, argv, "seed", 123));
+    }
+    if(mode == "bench"){
+        if(!util::arg_count_in(argc, argv, "books", 1000, 1, UINT32_MAX, books, err) ||
+           !util::arg_count_in(argc, argv, "events", 10000000, 1, UINT64_MAX, events, err))
+            return usage(err, "bench [books=1000] [events=10000000]");
+        return run_bench(books, events);
+    }
+    if(mode == "check") return run_check();
+    if(mode == "run"){
+        const std::string path = util::arg_string(argc, argv, "data", "");
+        if(path.empty()){
+            std::cerr << "Usage: order_flow_alpha run data=FILE (lob_simulator write or pack output)\n";
+            return 1;
+        }
+        return run_replay(path);
+    }
+
     std::mt19937 rng(123);
     std::poisson_distribution<int> arrivals(5);
     std::uniform_int_distribution<int> side(0,1);
@@ -21,10 +483,6 @@ int main(){
     PosState pos = PosState::FLAT;
     int hold = 0;
 
-    const double theta = 0.6;
-    const double theta_exit = 0.2;
-    const int max_hold = 50;
-
     for(int t=0;t<5000;t++){
         int events = arrivals(rng);
         for(int i=0;i<events;i++){
@@ -47,20 +505,7 @@ int main(){
         double I = (book.bid_qty - book.ask_qty) /
                    double(book.bid_qty + book.ask_qty);
 
-        if(pos == PosState::FLAT){
-            if(I > theta){
-                pos = PosState::LONG;
-                hold = 0;
-            } else if(I < -theta){
-                pos = PosState::SHORT;
-                hold = 0;
-            }
-        } else {
-            hold++;
-            if(std::fabs(I) < theta_exit || hold > max_hold){
-                pos = PosState::FLAT;
-            }
-        }
+        decide(pos, hold, I);
 
         if(t % 500 == 0){
             std::cout << "t=" << t
@@ -1,11 +1,19 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
-#include <random>
 #include <string>
 #include <vector>
 
+#include "../Common/ctr_rng.hpp"
+#include "../Common/ensemble.hpp"
+#include "../Common/mt5_csv.hpp"
+#include "../Common/util.hpp"
+
 enum class PosState { FLAT=0, LONG=1, SHORT=-1 };
 
 struct Trade {
@@ -18,6 +26,18 @@ struct Trade {
     double pnl = 0.0; // signed (in price units)
 };
 
+struct Params {
+    // --- Bollinger parameters
+    int    N_bb = 20;
+    double k    = 2.0;
+
+    // --- Risk parameters (percent of entry price)
+    bool   useSLTP = true;
+    double alphaSL = 0.01; // 1%
+    double alphaTP = 0.01; // 1%
+};
+
+// Exact two-pass statistics (reference for the rolling kernel).
 static double mean(const std::vector<double>& x, int start, int end_excl) {
     double s = 0.0;
     for (int i = start; i < end_excl; ++i) s += x[i];
@@ -33,41 +53,84 @@ static double stdev(const std::vector<double>& x, int start, int end_excl, doubl
     return std::sqrt(ss / (end_excl - start));
 }
 
-int main() {
-    // --- Synthetic price generation (GBM-like random walk)
-    const int    T = 4000;        // number of bars
-    const double S0 = 100.0;
-    const double mu = 0.00;       // drift per step
-    const double sigma = 0.01;    // vol per step
-    const uint32_t seed = 42;
+struct Bands {
+    double mid, up, lo;
+};
 
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
+// Band sources: bands(t) returns the bands over [t-N_bb, t); called for consecutive t.
 
-    std::vector<double> close(T);
-    close[0] = S0;
-    for (int t = 1; t < T; ++t) {
-        double z = N(rng);
-        // lognormal step
-        close[t] = close[t-1] * std::exp((mu - 0.5*sigma*sigma) + sigma*z);
+// Reference source: two full passes over the window per bar (original implementation).
+struct TwoPassBands {
+    const std::vector<double>& close;
+    Params p;
+
+    Bands bands(int t) const {
+        int start = t - p.N_bb;
+        int end   = t; // [start, end)
+        double m = mean(close, start, end);
+        double sd = stdev(close, start, end, m);
+        return {m, m + p.k * sd, m - p.k * sd};
     }
+};
 
-    // --- Bollinger parameters
-    const int    N_bb = 20;
-    const double k    = 2.0;
+// Streaming source: one rolling-kernel push per bar.
+class RollingBands {
+public:
+    RollingBands(const std::vector<double>& close, const Params& p)
+        : close_(close), k_(p.k), mv_(p.N_bb) {}
 
-    // --- Risk parameters (percent of entry price)
-    const bool   useSLTP = true;
-    const double alphaSL = 0.01; // 1%
-    const double alphaTP = 0.01; // 1%
+    Bands bands(int t) {
+        while (next_ < t) mv_.push(close_[next_++]);
+        double m = mv_.mean();
+        double sd = mv_.stdev();
+        return {m, m + k_ * sd, m - k_ * sd};
+    }
+
+private:
+    const std::vector<double>& close_;
+    double k_;
+    util::RollingMeanVar mv_;
+    int next_ = 0;
+};
+
+// --- Synthetic price generation (GBM-like random walk)
+// Counter-based draws (Common/ctr_rng.hpp): step t uses block t / kStepBlock of
+// path 0, blocks are filled on n_threads threads (batch normals, then one exp
+// over the block) and chained in one pass, so the series does not depend on the
+// thread count.
+static void fill_close(std::vector<double>& close, double S0, double mu, double sigma, uint32_t seed, int n_threads) {
+    const int T = (int)close.size();
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        double* x = &close[t0];
+        const size_t len = t1 - t0;
+        ctr::Stream(seed, 0, b).normals(x, len);
+        // lognormal step
+        for (size_t i = 0; i < len; ++i) x[i] = (mu - 0.5*sigma*sigma) + sigma*x[i];
+        ctr::exp_batch(x, len);
+    });
+    if (T == 0) return;
+    close[0] = S0;
+    for (int t = 1; t < T; ++t) close[t] *= close[t-1];
+}
+
+static std::vector<double> generate_close(int T, double S0, double mu, double sigma, uint32_t seed, int n_threads = 0) {
+    std::vector<double> close(T);
+    fill_close(close, S0, mu, sigma, seed, n_threads);
+    return close;
+}
+
+// Fills `trades` (cleared first, capacity kept) with the trades of one run.
+template <class BandSource>
+static void run_strategy(const std::vector<double>& close, const Params& p, BandSource&& src,
+                         std::vector<Trade>& trades) {
+    const int T = (int)close.size();
 
     // --- Strategy state
     PosState pos = PosState::FLAT;
     double entry = 0.0;
     int entry_idx = -1;
 
-    std::vector<Trade> trades;
-    trades.reserve(256);
+    trades.clear();
 
     auto open_trade = [&](int idx, PosState side, double px) {
         pos = side;
@@ -97,28 +160,24 @@ int main() {
     // --- Main loop (closed-bar logic)
     // We compute BB at time t using window [t-N_bb, t) and make decisions based on close[t-1]
     // to avoid lookahead (signal uses last closed bar).
-    for (int t = N_bb + 1; t < T; ++t) {
-        // compute BB using past N_bb closes ending at t-1 (exclusive of t)
-        int start = t - N_bb;
-        int end   = t; // [start, end)
-        double m = mean(close, start, end);
-        double sd = stdev(close, start, end, m);
+    for (int t = p.N_bb + 1; t < T; ++t) {
+        // BB using past N_bb closes ending at t-1 (exclusive of t)
+        Bands bb = src.bands(t);
 
-        double bb_mid = m;
-        double bb_up  = m + k * sd;
-        double bb_lo  = m - k * sd;
+        double bb_up  = bb.up;
+        double bb_lo  = bb.lo;
 
         // last closed bar price
         double P = close[t-1];
 
         // --- Risk management: recompute SL/TP from entry at each step
-        if (useSLTP && pos != PosState::FLAT) {
+        if (p.useSLTP && pos != PosState::FLAT) {
             int s = static_cast<int>(pos); // +1 long, -1 short
 
             // SL = P0 * (1 - s * alphaSL)
             // TP = P0 * (1 + s * alphaTP)
-            double SL = entry * (1.0 - s * alphaSL);
-            double TP = entry * (1.0 + s * alphaTP);
+            double SL = entry * (1.0 - s * p.alphaSL);
+            double TP = entry * (1.0 + s * p.alphaTP);
 
             bool hitSL = (s == +1) ? (P <= SL) : (P >= SL);
             bool hitTP = (s == +1) ? (P >= TP) : (P <= TP);
@@ -149,6 +208,181 @@ int main() {
     if (pos != PosState::FLAT) {
         close_trade(T-1, close[T-1], "EOD");
     }
+}
+
+template <class BandSource>
+static std::vector<Trade> run_strategy(const std::vector<double>& close, const Params& p, BandSource&& src) {
+    std::vector<Trade> trades;
+    trades.reserve(256);
+    run_strategy(close, p, src, trades);
+    return trades;
+}
+
+// --- Monte Carlo ensemble
+// Path k is the synthetic series of seed `seed + k` (path 0 is the default run).
+// Wins count trades with pnl >= 0, as in the run report; drawdown is measured
+// on the closed-trade equity curve.
+
+struct EnsembleState {
+    std::vector<double> close;
+    std::vector<Trade> trades;
+};
+
+static ens::Path ensemble_path(EnsembleState& st, const Params& p, double S0, double mu, double sigma,
+                               uint32_t seed) {
+    fill_close(st.close, S0, mu, sigma, seed, 1);
+    run_strategy(st.close, p, RollingBands(st.close, p), st.trades);
+    ens::Path r;
+    double equity = 0.0, peak = 0.0;
+    for (const auto& tr : st.trades) {
+        r.pnl += tr.pnl;
+        equity += tr.pnl;
+        peak = std::max(peak, equity);
+        r.max_dd = std::max(r.max_dd, peak - equity);
+        if (tr.pnl >= 0) r.wins++;
+    }
+    r.trades = (int)st.trades.size();
+    return r;
+}
+
+static ens::Distribution run_paths(const Params& p, int T, double S0, double mu, double sigma, uint32_t seed,
+                                   uint64_t n_paths, int n_threads) {
+    return ens::run(n_paths, n_threads,
+        [&]() { EnsembleState st; st.close.resize(T); st.trades.reserve(256); return st; },
+        [&](EnsembleState& st, uint64_t k) { return ensemble_path(st, p, S0, mu, sigma, seed + (uint32_t)k); });
+}
+
+// Drift check: rolling bands vs. exact two-pass bands on long series, plus
+// trade-for-trade comparison of the two engines.
+static int run_check() {
+    const int T = 1000000;
+    const int windows[] = {20, 100, 500};
+    const double tol = 1e-9; // relative
+    int failures = 0;
+
+    std::cout << std::scientific << std::setprecision(3);
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+        std::vector<double> close = generate_close(T, 100.0, 0.0, 0.01, seed);
+        for (int w : windows) {
+            Params p;
+            p.N_bb = w;
+
+            TwoPassBands ref{close, p};
+            RollingBands fast(close, p);
+
+            double max_mid = 0.0, max_sd = 0.0;
+            for (int t = p.N_bb + 1; t < T; ++t) {
+                Bands a = ref.bands(t);
+                Bands b = fast.bands(t);
+                double sd_a = (a.up - a.mid) / p.k;
+                double sd_b = (b.up - b.mid) / p.k;
+                max_mid = std::max(max_mid, std::fabs(a.mid - b.mid) / std::fabs(a.mid));
+                max_sd  = std::max(max_sd,  std::fabs(sd_a - sd_b) / std::max(sd_a, 1e-300));
+            }
+
+            auto t_ref = run_strategy(close, p, TwoPassBands{close, p});
+            auto t_new = run_strategy(close, p, RollingBands(close, p));
+            bool same = (t_ref.size() == t_new.size());
+            for (size_t i = 0; same && i < t_ref.size(); ++i) {
+                same = t_ref[i].entry_idx == t_new[i].entry_idx && t_ref[i].exit_idx == t_new[i].exit_idx &&
+                       t_ref[i].side == t_new[i].side && t_ref[i].pnl == t_new[i].pnl;
+            }
+
+            bool ok = max_mid < tol && max_sd < tol && same;
+            if (!ok) failures++;
+            std::cout << "seed=" << seed << " N_bb=" << w
+                      << " max rel drift mid=" << max_mid << " sd=" << max_sd
+                      << " trades=" << t_ref.size() << (same ? " (match)" : " (MISMATCH)")
+                      << (ok ? "" : "  FAILED") << "\n";
+        }
+    }
+
+    std::cout << "Rolling vs two-pass Bollinger check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+
+    // Generator: the same series whatever the thread count.
+    const std::vector<double> one = generate_close(100003, 100.0, 0.0, 0.01, 42, 1);
+    bool same = true;
+    for (int th : {2, 3, 8}) same = same && generate_close(100003, 100.0, 0.0, 0.01, 42, th) == one;
+    std::cout << "Generator across thread counts: " << (same ? "OK" : "FAILED") << "\n";
+    if (!same) failures++;
+
+    // Ensemble: path 0 is the single run of the base seed, and the distributions
+    // do not depend on the thread count.
+    Params p;
+    const std::vector<double> close42 = generate_close(4000, 100.0, 0.0, 0.01, 42);
+    double pnl42 = 0.0;
+    for (const auto& tr : run_strategy(close42, p, RollingBands(close42, p))) pnl42 += tr.pnl;
+    const ens::Distribution d1 = run_paths(p, 4000, 100.0, 0.0, 0.01, 42, 1, 1);
+    const ens::Distribution e1 = run_paths(p, 4000, 100.0, 0.0, 0.01, 42, 500, 1);
+    bool ens_ok = d1.pnl.sum.value() == pnl42;
+    for (int th : {2, 3}) ens_ok = ens_ok && ens::same_distribution(e1, run_paths(p, 4000, 100.0, 0.0, 0.01, 42, 500, th));
+    std::cout << "Ensemble path 0 vs single run, thread counts: " << (ens_ok ? "OK" : "FAILED") << "\n";
+    if (!ens_ok) failures++;
+    return failures == 0 ? 0 : 1;
+}
+
+// Distribution of PnL, win rate and drawdown over many independent paths.
+static int run_ensemble(int argc, char** argv, const Params& p, int T, double S0, double mu, double sigma,
+                        uint32_t seed) {
+    // paths stay below 2^32: seeds are 32-bit
+    uint64_t n_paths, n, threads;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "paths", 10000, 1, UINT32_MAX, n_paths, err) ||
+        !util::arg_count_in(argc, argv, "n", T, p.N_bb + 2, INT_MAX, n, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = (int)threads;
+    T = (int)n;
+    seed = (uint32_t)util::arg_u64(argc, argv, "seed", seed);
+
+    auto t0 = std::chrono::steady_clock::now();
+    ens::Distribution d = run_paths(p, T, S0, mu, sigma, seed, n_paths, n_threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Bollinger Bands Reversion ensemble: " << n_paths << " paths x " << T << " bars, seeds "
+              << seed << ".." << seed + (uint32_t)(n_paths - 1) << ", N_bb=" << p.N_bb << " k=" << p.k << "\n";
+    std::cout << "threads=" << ctr::thread_count(n_threads) << " time=" << secs << "s ("
+              << std::setprecision(0) << n_paths / secs << " paths/s)\n\n";
+    ens::print(std::cout, d);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "check") return run_check();
+
+    // --- Synthetic price generation (GBM-like random walk)
+    const int    T = 4000;        // number of bars
+    const double S0 = 100.0;
+    const double mu = 0.00;       // drift per step
+    const double sigma = 0.01;    // vol per step
+    const uint32_t seed = 42;
+
+    Params p;
+    // --- Bollinger parameters
+    p.N_bb = 20;
+    p.k    = 2.0;
+
+    // --- Risk parameters (percent of entry price)
+    p.useSLTP = true;
+    p.alphaSL = 0.01; // 1%
+    p.alphaTP = 0.01; // 1%
+
+    if (argc > 1 && std::string(argv[1]) == "ensemble") return run_ensemble(argc, argv, p, T, S0, mu, sigma, seed);
+
+    // data=FILE replays an MT5 bar export instead
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    std::vector<double> close;
+    std::string err;
+    if (path.empty()) close = generate_close(T, S0, mu, sigma, seed);
+    else if (!mt5::load_close(path, close, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+
+    std::vector<Trade> trades = run_strategy(close, p, RollingBands(close, p));
 
     // --- Reporting
     double total_pnl = 0.0;
@@ -159,6 +393,7 @@ int main() {
     }
 
     std::cout << "Bollinger Bands Reversion (standalone C++)\n";
+    if (!path.empty()) std::cout << "Data: " << path << " (" << close.size() << " bars)\n";
     std::cout << "Trades: " << trades.size()
               << " | Wins: " << wins
               << " | Losses: " << losses
@@ -1,9 +1,20 @@
 #include <iostream>
 #include <vector>
-#include <random>
 #include <cmath>
 #include <iomanip>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+#include <variant>
+
+#include "../Common/ctr_rng.hpp"
+#include "../Common/ensemble.hpp"
+#include "../Common/mt5_csv.hpp"
+#include "../Common/util.hpp"
 
 struct Trade {
     int side; // +1 long, -1 short
@@ -11,62 +22,285 @@ struct Trade {
     double entry, exit, pnl;
 };
 
+enum class MaMethod { SMA, EMA }; // mirrors ENUM_MA_METHOD in the MQ5 version
+
+struct Params {
+    int fastN = 20;
+    int slowN = 50;
+    MaMethod method = MaMethod::SMA;
+
+    bool useSLTP = true;
+    double stopLossPct   = 0.01; // 1%
+    double takeProfitPct = 0.02; // 2%
+};
+
+struct Summary {
+    int trades = 0;
+    int wins = 0;
+    double totalPnL = 0.0;
+    double maxDD = 0.0;
+};
+
+// Reference SMA: full window rescan, O(window) per call.
 static double sma(const std::vector<double>& x, int end_idx, int window) {
     double s = 0.0;
     for (int i = end_idx - window + 1; i <= end_idx; ++i) s += x[i];
     return s / window;
 }
 
-// Generate synthetic close prices (GBM-like)
-static std::vector<double> generate_prices(int n, double s0, double mu, double sigma, unsigned seed=42) {
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> z(0.0, 1.0);
+// --- Streaming indicators: one update per bar, O(1) per update
 
-    std::vector<double> close(n);
-    close[0] = s0;
+// Rolling SMA over a ring buffer of the last `window` inputs.
+class RollingSMA {
+public:
+    explicit RollingSMA(int window) : buf_(window, 0.0), window_(window) {}
 
-    // dt = 1 per step
-    for (int t = 1; t < n; ++t) {
-        double eps = z(rng);
-        double log_ret = (mu - 0.5 * sigma * sigma) + sigma * eps;
-        close[t] = close[t-1] * std::exp(log_ret);
+    double update(double x) {
+        if (count_ == window_) s_.add(-buf_[head_]);
+        else ++count_;
+        buf_[head_] = x;
+        s_.add(x);
+        if (++head_ == window_) head_ = 0;
+        return value();
     }
-    return close;
+
+    bool ready() const { return count_ == window_; }
+    double value() const { return s_.value() / window_; }
+
+private:
+    std::vector<double> buf_;
+    int window_;
+    int head_ = 0;
+    int count_ = 0;
+    util::CompensatedSum s_;
+};
+
+// EMA seeded with the SMA of the first `window` inputs (same convention as MT5 iMA MODE_EMA).
+class RollingEMA {
+public:
+    explicit RollingEMA(int window) : alpha_(2.0 / (window + 1.0)), window_(window) {}
+
+    double update(double x) {
+        if (count_ < window_) {
+            seed_.add(x);
+            ema_ = seed_.value() / ++count_;
+        } else {
+            ema_ += alpha_ * (x - ema_);
+        }
+        return ema_;
+    }
+
+    bool ready() const { return count_ == window_; }
+    double value() const { return ema_; }
+
+private:
+    double alpha_;
+    int window_;
+    int count_ = 0;
+    double ema_ = 0.0;
+    util::CompensatedSum seed_;
+};
+
+// Reference EMA: the recursion replayed from bar 0, O(end_idx) per call.
+static double ema(const std::vector<double>& x, int end_idx, int window) {
+    RollingEMA e(window);
+    for (int i = 0; i <= end_idx; ++i) e.update(x[i]);
+    return e.value();
 }
 
-int main() {
-    // --- Parameters (mirror MQ5 intent) ---
-    const int fastN = 20;
-    const int slowN = 50;
+// Moving average of the selected method (only that indicator is built), updated
+// once per bar; caches the previous value so a crossover test between two
+// consecutive bars needs no recompute.
+class StreamingMA {
+public:
+    StreamingMA(MaMethod m, int window)
+        : ma_(m == MaMethod::SMA ? Indicator(std::in_place_type<RollingSMA>, window)
+                                 : Indicator(std::in_place_type<RollingEMA>, window)) {}
 
-    const bool useSLTP = true;
-    const double stopLossPct  = 0.01; // 1%
-    const double takeProfitPct= 0.02; // 2%
+    void update(double x) {
+        prev_ = cur_;
+        cur_ = std::visit([x](auto& ma) { return ma.update(x); }, ma_);
+    }
 
-    // Synthetic data config (internal data, no files)
-    const int N = 2000;
-    const double S0 = 100.0;
-    const double mu = 0.0002;   // drift per step
-    const double sigma = 0.01;  // vol per step
-    const unsigned seed = 7;
+    double prev() const { return prev_; }
+    double cur()  const { return cur_; }
 
-    if (!(0 < fastN && fastN < slowN)) {
-        std::cerr << "Invalid MA windows: need 0 < fast < slow\n";
-        return 1;
+private:
+    using Indicator = std::variant<RollingSMA, RollingEMA>;
+    Indicator ma_;
+    double prev_ = 0.0;
+    double cur_ = 0.0;
+};
+
+// Crossover on CLOSED points: compare (i-2) and (i-1).
+// +1 bullish, -1 bearish, 0 none.
+static int cross_signal(double fast_a, double slow_a, double fast_b, double slow_b) {
+    bool bullishCross = (fast_a <= slow_a) && (fast_b > slow_b);
+    bool bearishCross = (fast_a >= slow_a) && (fast_b < slow_b);
+    return bullishCross ? +1 : (bearishCross ? -1 : 0);
+}
+
+// Signal sources: cross(i) gives the crossover signal acted on at bar i.
+// run_strategy() calls cross(i) for consecutive i only.
+
+// Reference source: four full rescans per bar (original implementation for SMA).
+struct RescanSignals {
+    const std::vector<double>& close;
+    int fastN, slowN;
+    MaMethod method = MaMethod::SMA;
+
+    double ma(int end_idx, int window) const {
+        return method == MaMethod::SMA ? sma(close, end_idx, window) : ema(close, end_idx, window);
     }
-    if (N < slowN + 3) {
-        std::cerr << "Not enough points.\n";
-        return 1;
+
+    int cross(int i) {
+        int a = i - 2;
+        int b = i - 1;
+        return cross_signal(ma(a, fastN), ma(a, slowN), ma(b, fastN), ma(b, slowN));
+    }
+};
+
+// Streaming source: one O(1) update per indicator per bar.
+class StreamingSignals {
+public:
+    StreamingSignals(const std::vector<double>& close, const Params& p)
+        : close_(close), fast_(p.method, p.fastN), slow_(p.method, p.slowN) {}
+
+    int cross(int i) {
+        // feed every closed bar up to b = i-1 (first call warms up on [0, i-1))
+        while (next_ <= i - 1) {
+            fast_.update(close_[next_]);
+            slow_.update(close_[next_]);
+            ++next_;
+        }
+        return cross_signal(fast_.prev(), slow_.prev(), fast_.cur(), slow_.cur());
+    }
+
+private:
+    const std::vector<double>& close_;
+    StreamingMA fast_, slow_;
+    int next_ = 0;
+};
+
+// Compensated prefix sums over (close - ref): any window sum in O(1),
+// shared read-only by every (fast, slow) combination of a sweep.
+struct PrefixSums {
+    double ref = 0.0;
+    std::vector<double> hi, lo; // hi[k] + lo[k] = sum of (close[j] - ref), j < k
+
+    explicit PrefixSums(const std::vector<double>& close)
+        : ref(close.empty() ? 0.0 : close[0]), hi(close.size() + 1, 0.0), lo(close.size() + 1, 0.0) {
+        util::CompensatedSum s;
+        for (size_t k = 0; k < close.size(); ++k) {
+            s.add(close[k] - ref);
+            hi[k+1] = s.sum;
+            lo[k+1] = s.comp;
+        }
     }
 
-    std::vector<double> close = generate_prices(N, S0, mu, sigma, seed);
+    // SMA over x[end_idx-window+1 .. end_idx]
+    double sma(int end_idx, int window) const {
+        int e = end_idx + 1, b = e - window;
+        return ref + ((hi[e] - hi[b]) + (lo[e] - lo[b])) / window;
+    }
+};
+
+// Precomputed source: crossover signals for one (fast, slow) pair, built once
+// from the prefix sums and replayed for every SL/TP combination.
+struct SeriesSignals {
+    std::vector<signed char> sig;
+
+    void build(const PrefixSums& ps, int N, int fastN, int slowN) {
+        sig.assign(N, 0);
+        if (N < slowN + 3) return;
+        double fast_a = ps.sma(slowN, fastN);
+        double slow_a = ps.sma(slowN, slowN);
+        for (int i = slowN + 2; i < N; ++i) {
+            double fast_b = ps.sma(i - 1, fastN);
+            double slow_b = ps.sma(i - 1, slowN);
+            sig[i] = (signed char)cross_signal(fast_a, slow_a, fast_b, slow_b);
+            fast_a = fast_b;
+            slow_a = slow_b;
+        }
+    }
+
+    // Same series from the streaming indicators (EMA, which has no prefix form).
+    void build(const std::vector<double>& close, const Params& p) {
+        const int N = (int)close.size();
+        sig.assign(N, 0);
+        if (N < p.slowN + 3) return;
+        StreamingSignals src(close, p);
+        for (int i = p.slowN + 2; i < N; ++i) sig[i] = (signed char)src.cross(i);
+    }
+
+    int cross(int i) const { return sig[i]; }
+};
+
+// Generate synthetic close prices (GBM-like)
+// Step t draws from block t / kStepBlock of path 0 (Common/ctr_rng.hpp); blocks
+// fill their exp factors on n_threads threads (batch normals, then one exp over
+// the block), then one pass chains them, so the series is the same for any
+// thread count.
+static void fill_prices(std::vector<double>& close, double s0, double mu, double sigma, unsigned seed,
+                        int n_threads) {
+    const int n = (int)close.size();
+    ctr::for_blocks(n, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        double* x = &close[t0];
+        const size_t len = t1 - t0;
+        ctr::Stream(seed, 0, b).normals(x, len);
+        for (size_t i = 0; i < len; ++i) x[i] = (mu - 0.5 * sigma * sigma) + sigma * x[i];   // log return
+        ctr::exp_batch(x, len);
+    });
+    if (n == 0) return;
+
+    // dt = 1 per step
+    close[0] = s0;
+    for (int t = 1; t < n; ++t) close[t] *= close[t-1];
+}
+
+// Driftless mean-reverting series for long sweeps: log(close / s0) follows
+// x_t = (1 - kappa) x_{t-1} + sigma z_t (stationary sd sigma / sqrt(2 kappa)),
+// so prices stay in a band around s0 at any length, with trends on time scales
+// of about 1 / kappa bars. Same draws as fill_prices (block t / kStepBlock of
+// path 0); the recursion is one sequential pass between two parallel ones.
+static void fill_reverting_prices(std::vector<double>& close, double s0, double kappa, double sigma,
+                                  unsigned seed, int n_threads) {
+    const int n = (int)close.size();
+    ctr::for_blocks(n, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        ctr::Stream(seed, 0, b).normals(&close[t0], t1 - t0);
+    });
+    if (n == 0) return;
+
+    double x = 0.0;
+    close[0] = 0.0;
+    for (int t = 1; t < n; ++t) {
+        x = (1.0 - kappa) * x + sigma * close[t];
+        close[t] = x;
+    }
+    ctr::for_blocks(n, n_threads, [&](uint32_t, size_t t0, size_t t1) {
+        ctr::exp_batch(&close[t0], t1 - t0);
+        for (size_t t = t0; t < t1; ++t) close[t] *= s0;
+    });
+}
+
+static std::vector<double> generate_prices(int n, double s0, double mu, double sigma, unsigned seed=42,
+                                           int n_threads=0) {
+    std::vector<double> close(n);
+    fill_prices(close, s0, mu, sigma, seed, n_threads);
+    return close;
+}
+
+// Fills `trades` (cleared first, capacity kept) with the trades of one run.
+template <class Signals>
+static void run_strategy(const std::vector<double>& close, const Params& p, Signals&& sig,
+                         std::vector<Trade>& trades) {
+    const int N = (int)close.size();
 
     int pos = 0; // 0 flat, +1 long, -1 short
     double entry = 0.0;
     int entry_idx = -1;
 
-    std::vector<Trade> trades;
-    trades.reserve(200);
+    trades.clear();
 
     auto close_pos = [&](int i, double exit_price) {
         Trade t;
@@ -83,23 +317,16 @@ int main() {
         entry_idx = -1;
     };
 
-    for (int i = slowN + 2; i < N; ++i) {
+    for (int i = p.slowN + 2; i < N; ++i) {
         // Crossover on CLOSED points: compare (i-2) and (i-1)
-        int a = i - 2;
-        int b = i - 1;
-
-        double fast_a = sma(close, a, fastN);
-        double slow_a = sma(close, a, slowN);
-        double fast_b = sma(close, b, fastN);
-        double slow_b = sma(close, b, slowN);
-
-        bool bullishCross = (fast_a <= slow_a) && (fast_b > slow_b);
-        bool bearishCross = (fast_a >= slow_a) && (fast_b < slow_b);
+        int cross = sig.cross(i);
+        bool bullishCross = (cross == +1);
+        bool bearishCross = (cross == -1);
 
         // Risk check using close as proxy (demo purpose)
-        if (pos != 0 && useSLTP) {
-            double sl = entry * (1.0 - stopLossPct * (double)pos);
-            double tp = entry * (1.0 + takeProfitPct * (double)pos);
+        if (pos != 0 && p.useSLTP) {
+            double sl = entry * (1.0 - p.stopLossPct * (double)pos);
+            double tp = entry * (1.0 + p.takeProfitPct * (double)pos);
 
             double px = close[i];
 
@@ -122,31 +349,405 @@ int main() {
     }
 
     if (pos != 0) close_pos(N-1, close.back());
+}
 
-    // Summary
-    double totalPnL = 0.0;
-    int wins = 0;
-    double maxDD = 0.0;
+template <class Signals>
+static std::vector<Trade> run_strategy(const std::vector<double>& close, const Params& p, Signals&& sig) {
+    std::vector<Trade> trades;
+    trades.reserve(200);
+    run_strategy(close, p, sig, trades);
+    return trades;
+}
+
+static Summary summarize(const std::vector<Trade>& trades) {
+    Summary s;
     double equity = 0.0;
     double peak = 0.0;
 
     for (auto &t : trades) {
-        totalPnL += t.pnl;
+        s.totalPnL += t.pnl;
         equity += t.pnl;
         peak = std::max(peak, equity);
-        maxDD = std::max(maxDD, peak - equity);
-        if (t.pnl > 0) wins++;
+        s.maxDD = std::max(s.maxDD, peak - equity);
+        if (t.pnl > 0) s.wins++;
     }
+    s.trades = (int)trades.size();
+    return s;
+}
+
+static bool same_trades(const std::vector<Trade>& x, const std::vector<Trade>& y) {
+    if (x.size() != y.size()) return false;
+    for (size_t k = 0; k < x.size(); ++k) {
+        const Trade& u = x[k];
+        const Trade& v = y[k];
+        if (u.side != v.side || u.entry_idx != v.entry_idx || u.exit_idx != v.exit_idx ||
+            u.entry != v.entry || u.exit != v.exit || u.pnl != v.pnl) return false;
+    }
+    return true;
+}
+
+// --- Monte Carlo ensemble
+
+// One path of an ensemble: path k is the synthetic series of seed `seed + k`.
+struct EnsembleState {
+    std::vector<double> close;
+    std::vector<Trade> trades;
+};
+
+static ens::Path ensemble_path(EnsembleState& st, const Params& p, double S0, double mu, double sigma,
+                               unsigned seed) {
+    fill_prices(st.close, S0, mu, sigma, seed, 1);
+    run_strategy(st.close, p, StreamingSignals(st.close, p), st.trades);
+    Summary s = summarize(st.trades);
+    return {s.totalPnL, s.maxDD, s.trades, s.wins};
+}
+
+static ens::Distribution run_paths(const Params& p, double S0, double mu, double sigma, int N, unsigned seed,
+                                   uint64_t n_paths, int n_threads) {
+    return ens::run(n_paths, n_threads,
+        [&]() { EnsembleState st; st.close.resize(N); st.trades.reserve(200); return st; },
+        [&](EnsembleState& st, uint64_t k) { return ensemble_path(st, p, S0, mu, sigma, seed + (unsigned)k); });
+}
+
+// Regression check: the streaming and prefix-sum engines must reproduce the
+// rescan engine's trades exactly, over several seeds and window pairs.
+static int run_check(double S0, double mu, double sigma) {
+    const int N = 20000;
+    const int windows[][2] = { {20, 50}, {5, 200}, {10, 30}, {50, 300} };
+    int failures = 0;
+
+    for (unsigned seed = 1; seed <= 8; ++seed) {
+        std::vector<double> close = generate_prices(N, S0, mu, sigma, seed);
+        PrefixSums ps(close);
+        for (const auto& w : windows) {
+            Params p;
+            p.fastN = w[0];
+            p.slowN = w[1];
+
+            RescanSignals ref{close, p.fastN, p.slowN};
+            StreamingSignals fast(close, p);
+            SeriesSignals series;
+            series.build(ps, N, p.fastN, p.slowN);
+            auto t_ref = run_strategy(close, p, ref);
+            auto t_new = run_strategy(close, p, fast);
+            auto t_pre = run_strategy(close, p, series);
+
+            if (!same_trades(t_ref, t_new) || !same_trades(t_ref, t_pre)) {
+                failures++;
+                std::cout << "MISMATCH seed=" << seed << " fast=" << p.fastN << " slow=" << p.slowN
+                          << " trades " << t_ref.size() << " vs " << t_new.size()
+                          << " / " << t_pre.size() << "\n";
+            }
+        }
+    }
+
+    std::cout << "Streaming/prefix-sum vs rescan regression: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+
+    // EMA: streaming (single run and sweep series) vs the recursion replayed
+    // from bar 0 for every value (O(N^2), hence the shorter series).
+    int ema_failures = 0;
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        std::vector<double> close = generate_prices(3000, S0, mu, sigma, seed);
+        for (const auto& w : windows) {
+            Params p;
+            p.fastN = w[0];
+            p.slowN = w[1];
+            p.method = MaMethod::EMA;
+
+            RescanSignals ref{close, p.fastN, p.slowN, MaMethod::EMA};
+            SeriesSignals series;
+            series.build(close, p);
+            auto t_ref = run_strategy(close, p, ref);
+            auto t_new = run_strategy(close, p, StreamingSignals(close, p));
+            auto t_pre = run_strategy(close, p, series);
+            if (t_ref.empty() || !same_trades(t_ref, t_new) || !same_trades(t_ref, t_pre)) {
+                ema_failures++;
+                std::cout << "EMA MISMATCH seed=" << seed << " fast=" << p.fastN << " slow=" << p.slowN
+                          << " trades " << t_ref.size() << " vs " << t_new.size() << " / " << t_pre.size() << "\n";
+            }
+        }
+    }
+    std::cout << "EMA streaming vs rescan regression: " << (ema_failures == 0 ? "OK" : "FAILED") << "\n";
+    failures += ema_failures;
+
+    // Generator: the same series whatever the thread count.
+    const std::vector<double> one = generate_prices(100003, S0, mu, sigma, 42, 1);
+    bool same = true;
+    for (int th : {2, 3, 8}) same = same && generate_prices(100003, S0, mu, sigma, 42, th) == one;
+    std::cout << "Generator across thread counts: " << (same ? "OK" : "FAILED") << "\n";
+    if (!same) failures++;
+
+    // Ensemble: path 0 is the single run of the base seed, and the distributions
+    // do not depend on the thread count.
+    Params p;
+    std::vector<Trade> single;
+    const std::vector<double> close7 = generate_prices(2000, S0, mu, sigma, 7);
+    run_strategy(close7, p, StreamingSignals(close7, p), single);
+    const Summary s7 = summarize(single);
+    const ens::Distribution d1 = run_paths(p, S0, mu, sigma, 2000, 7, 1, 1);
+    const ens::Distribution e1 = run_paths(p, S0, mu, sigma, 2000, 7, 500, 1);
+    bool ens_ok = d1.pnl.sum.value() == s7.totalPnL && d1.trades.sum.value() == s7.trades;
+    for (int th : {2, 3}) ens_ok = ens_ok && ens::same_distribution(e1, run_paths(p, S0, mu, sigma, 2000, 7, 500, th));
+    std::cout << "Ensemble path 0 vs single run, thread counts: " << (ens_ok ? "OK" : "FAILED") << "\n";
+    if (!ens_ok) failures++;
+    return failures == 0 ? 0 : 1;
+}
+
+// --- Parameter sweep
+
+struct SweepRow {
+    Params p;
+    Summary s;
+};
+
+// Grid search over fast/slow/SL/TP. One prefix-sum array over close serves every
+// (fast, slow) SMA pair (EMA pairs stream their indicators once per pair); each pair is a job on the worker pool, which builds its
+// crossover series once and replays it for every SL/TP combination. Each row is
+// produced by run_strategy(), so it is identical to a single run with those params.
+static int run_sweep(int argc, char** argv, const Params& base, double S0, double mu, double sigma,
+                     int N, unsigned seed) {
+    util::Range fastR{5, 50, 5}, slowR{20, 200, 10}, slR{0.005, 0.02, 0.005}, tpR{0.01, 0.04, 0.01};
+
+    for (int a = 2; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (util::parse_range(arg, "fast", fastR) || util::parse_range(arg, "slow", slowR) ||
+            util::parse_range(arg, "sl", slR) || util::parse_range(arg, "tp", tpR)) continue;
+        bool scalar = false;   // read below / by main
+        for (const char* key : {"n", "threads", "top", "kappa", "ma", "data"}) scalar = scalar || util::arg_has_key(arg, key);
+        if (scalar) continue;
+        std::cerr << "Unknown sweep argument: " << arg
+                  << " (expected fast=, slow=, sl=, tp= as lo:hi:step, or n=, threads=, top=, kappa=, ma=, data=FILE)\n";
+        return 1;
+    }
+    for (const auto& axis : {std::make_pair("fast", &fastR), std::make_pair("slow", &slowR),
+                             std::make_pair("sl", &slR), std::make_pair("tp", &tpR)})
+        if (!axis.second->ok) {
+            std::cerr << util::range_error(axis.first) << "\n";
+            return 1;
+        }
+    if (util::grid_count({&fastR, &slowR, &slR, &tpR}) == 0) {
+        std::cerr << "The grid has more than " << util::Range::kMaxCount << " combinations.\n";
+        return 1;
+    }
+
+    uint64_t n, threads, top_n;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "n", N, 1, INT_MAX, n, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err) ||
+        !util::arg_count_in(argc, argv, "top", 20, 1, INT_MAX, top_n, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = ctr::thread_count((int)threads);
+    const int top = (int)top_n;
+    const double kappa = std::max(0.0, util::arg_value(argc, argv, "kappa", 0.0));   // 0: the same GBM path as a single run
+
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    std::vector<double> close;
+    if (!path.empty() && !mt5::load_close(path, close, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    N = path.empty() ? (int)n : (int)close.size();
+    // kappa=0 (default): the drifting GBM path of a single run, so the row of the
+    // default (fast, slow, SL, TP) is the single run; its log price must stay
+    // representable (8 sd of margin) or the PnL column is meaningless.
+    if (path.empty() && kappa == 0.0 &&
+        std::fabs(mu - 0.5 * sigma * sigma) * N + 8.0 * sigma * std::sqrt((double)N) > 700.0) {
+        std::cerr << "n=" << N << " is too long for the drifting GBM path (prices overflow); "
+                  << "use kappa > 0 (mean-reverting path), e.g. kappa=1e-4.\n";
+        return 1;
+    }
+
+    // valid (fast, slow) pairs
+    std::vector<std::pair<int,int>> windows;
+    for (int i = 0; i < fastR.count(); ++i)
+        for (int j = 0; j < slowR.count(); ++j) {
+            int f = (int)std::lround(fastR.at(i));
+            int sN = (int)std::lround(slowR.at(j));
+            if (0 < f && f < sN && N >= sN + 3) windows.push_back({f, sN});
+        }
+    const int n_risk = slR.count() * tpR.count();
+    if (windows.empty()) {
+        std::cerr << "No valid (fast, slow) pair in the grid.\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    if (path.empty() && kappa == 0.0) close = generate_prices(N, S0, mu, sigma, seed);
+    else if (path.empty()) {
+        close.resize(N);
+        fill_reverting_prices(close, S0, kappa, sigma, seed, n_threads);
+    }
+    PrefixSums ps(close);
+
+    std::vector<SweepRow> rows(windows.size() * n_risk);
+    std::atomic<int> next{0};
+
+    auto worker = [&]() {
+        SeriesSignals series; // per-thread scratch, reused across jobs
+        for (int job; (job = next.fetch_add(1)) < (int)windows.size(); ) {
+            Params p = base;
+            p.fastN = windows[job].first;
+            p.slowN = windows[job].second;
+            if (p.method == MaMethod::SMA) series.build(ps, N, p.fastN, p.slowN);
+            else series.build(close, p);
+
+            for (int r = 0; r < n_risk; ++r) {
+                p.stopLossPct   = slR.at(r / tpR.count());
+                p.takeProfitPct = tpR.at(r % tpR.count());
+                rows[(size_t)job * n_risk + r] = {p, summarize(run_strategy(close, p, series))};
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int k = 1; k < n_threads; ++k) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // rank by PnL, ties broken by the grid order (deterministic for any thread count)
+    std::stable_sort(rows.begin(), rows.end(), [](const SweepRow& x, const SweepRow& y) {
+        return x.s.totalPnL > y.s.totalPnL;
+    });
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "MA Crossover parameter sweep (";
+    if (!path.empty()) std::cout << path;
+    else if (kappa > 0.0) std::cout << "synthetic mean-reverting data, kappa=" << kappa;
+    else std::cout << "synthetic data";
+    std::cout << (base.method == MaMethod::EMA ? ", EMA" : "") << ")\n";
+    std::cout << "N=" << N << " combinations=" << rows.size()
+              << " threads=" << n_threads << " time=" << secs << "s\n\n";
+    std::cout << std::setw(5) << "fast" << std::setw(6) << "slow"
+              << std::setw(8) << "SL%" << std::setw(8) << "TP%"
+              << std::setw(8) << "trades" << std::setw(10) << "win%"
+              << std::setw(12) << "PnL" << std::setw(12) << "maxDD" << "\n";
+
+    for (int k = 0; k < std::min(top, (int)rows.size()); ++k) {
+        const auto& r = rows[k];
+        double wr = r.s.trades > 0 ? 100.0 * r.s.wins / (double)r.s.trades : 0.0;
+        std::cout << std::setw(5) << r.p.fastN << std::setw(6) << r.p.slowN
+                  << std::setw(8) << 100.0 * r.p.stopLossPct << std::setw(8) << 100.0 * r.p.takeProfitPct
+                  << std::setw(8) << r.s.trades << std::setw(10) << wr
+                  << std::setw(12) << r.s.totalPnL << std::setw(12) << r.s.maxDD << "\n";
+    }
+    return 0;
+}
+
+// --- Ensemble mode
+
+// Distribution of PnL, win rate and drawdown over many independent paths; each
+// path is a single run on its own seed (path 0 is the default run).
+static int run_ensemble(int argc, char** argv, const Params& p, double S0, double mu, double sigma,
+                        int N, unsigned seed) {
+    // paths stay below 2^32: seeds are 32-bit
+    uint64_t n_paths, n, threads;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "paths", 10000, 1, UINT32_MAX, n_paths, err) ||
+        !util::arg_count_in(argc, argv, "n", N, p.slowN + 3, INT_MAX, n, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = (int)threads;
+    N = (int)n;
+    seed = (unsigned)util::arg_u64(argc, argv, "seed", seed);
+
+    auto t0 = std::chrono::steady_clock::now();
+    ens::Distribution d = run_paths(p, S0, mu, sigma, N, seed, n_paths, n_threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "MA Crossover ensemble: " << n_paths << " paths x " << N << " bars, seeds " << seed << ".."
+              << seed + (unsigned)(n_paths - 1) << ", fast=" << p.fastN << " slow=" << p.slowN
+              << (p.method == MaMethod::EMA ? " ma=EMA" : "") << "\n";
+    std::cout << "threads=" << ctr::thread_count(n_threads) << " time=" << secs << "s ("
+              << std::setprecision(0) << n_paths / secs << " paths/s)\n\n";
+    ens::print(std::cout, d);
+    return 0;
+}
+
+static int usage() {
+    std::cerr << "Usage: MA_Crossover [run] [data=FILE] [ma=sma|ema]\n"
+                 "       MA_Crossover ensemble [paths=10000] [n=2000] [seed=7] [threads=N]\n"
+                 "       MA_Crossover sweep [fast=lo:hi:step] [slow=...] [sl=...] [tp=...] [n=N] [threads=K] [top=K] [kappa=0] [data=FILE]\n"
+                 "       MA_Crossover check\n";
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    // --- Parameters (mirror MQ5 intent)
+    Params p;
+    p.fastN = 20;
+    p.slowN = 50;
+    p.method = MaMethod::SMA;
+
+    p.useSLTP = true;
+    p.stopLossPct   = 0.01; // 1%
+    p.takeProfitPct = 0.02; // 2%
+
+    // Synthetic data config (internal data), unless data=FILE points to an MT5 bar export
+    int N = 2000;
+    const double S0 = 100.0;
+    const double mu = 0.0002;   // drift per step
+    const double sigma = 0.01;  // vol per step
+    const unsigned seed = 7;
+
+    const std::string ma = util::arg_string(argc, argv, "ma", "sma");
+    if (ma == "ema") p.method = MaMethod::EMA;
+    else if (ma != "sma") {
+        std::cerr << "Unknown ma=" << ma << " (sma or ema)\n";
+        return 1;
+    }
+
+    // a key=value first means the default mode
+    std::string mode = (argc > 1) ? argv[1] : "run";
+    if (mode.find('=') != std::string::npos) mode = "run";
+    if (mode == "check") return run_check(S0, mu, sigma);
+    if (mode == "sweep") return run_sweep(argc, argv, p, S0, mu, sigma, N, seed);
+    if (mode == "ensemble") return run_ensemble(argc, argv, p, S0, mu, sigma, N, seed);
+    if (mode != "run") return usage();
+
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    std::vector<double> close;
+    if (!path.empty()) {
+        std::string err;
+        if (!mt5::load_close(path, close, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        N = (int)close.size();
+    }
+
+    if (!(0 < p.fastN && p.fastN < p.slowN)) {
+        std::cerr << "Invalid MA windows: need 0 < fast < slow\n";
+        return 1;
+    }
+    if (N < p.slowN + 3) {
+        std::cerr << "Not enough points.\n";
+        return 1;
+    }
+
+    if (path.empty()) close = generate_prices(N, S0, mu, sigma, seed);
+
+    StreamingSignals sig(close, p);
+    std::vector<Trade> trades = run_strategy(close, p, sig);
+    Summary s = summarize(trades);
 
     std::cout << std::fixed << std::setprecision(4);
-    std::cout << "Standalone C++ MA Crossover (synthetic data)\n";
-    std::cout << "N=" << N << " fast=" << fastN << " slow=" << slowN << "\n";
-    std::cout << "Trades: " << trades.size() << "\n";
-    if (!trades.empty()) {
-        std::cout << "Win rate: " << (100.0 * wins / (double)trades.size()) << "%\n";
-    }
-    std::cout << "Total PnL (price units): " << totalPnL << "\n";
-    std::cout << "Max Drawdown (PnL units): " << maxDD << "\n";
+    std::cout << "Standalone C++ MA Crossover (" << (path.empty() ? "synthetic data" : path) << ")\n";
+    std::cout << "N=" << N << " fast=" << p.fastN << " slow=" << p.slowN
+              << (p.method == MaMethod::EMA ? " ma=EMA" : "") << "\n";
+    std::cout << "Trades: " << s.trades << "\n";
+    if (s.trades > 0) {
+        std::cout << "Win rate: " << (100.0 * s.wins / (double)s.trades) << "%\n";
+    }
+    std::cout << "Total PnL (price units): " << s.totalPnL << "\n";
+    std::cout << "Max Drawdown (PnL units): " << s.maxDD << "\n";
 
     return 0;
 }
@@ -1,12 +1,22 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <random>
 #include <vector>
 #include <iomanip>
 #include <string>
+#include <utility>
+
+#include "../Common/columnar.hpp"
+#include "../Common/ctr_rng.hpp"
+#include "../Common/event_calendar.hpp"
+#include "../Common/util.hpp"
 
 enum class Regime { RISK_ON, RISK_OFF };
-enum class EventType { NONE, MACRO, CENTRAL_BANK };
 enum class PosState { FLAT, LONG, SHORT };
 
 struct Tick {
@@ -14,21 +24,45 @@ struct Tick {
     double price;
     double ret;
     Regime regime;
-    EventType event_type;
+    news::EventType event_type;
     double surprise;
 };
 
 static std::string to_string(Regime r){
     return (r == Regime::RISK_ON) ? "RISK_ON" : "RISK_OFF";
 }
-static std::string to_string(EventType e){
-    if(e == EventType::MACRO) return "MACRO";
-    if(e == EventType::CENTRAL_BANK) return "CENTRAL_BANK";
+static std::string to_string(news::EventType e){
+    if(e == news::EventType::MACRO) return "MACRO";
+    if(e == news::EventType::CENTRAL_BANK) return "CENTRAL_BANK";
     return "NONE";
 }
 
+// Realistic-size calendar: n_events releases spread over n_countries, with
+// country importance folded into the priority.
+static news::EventCalendar dense_calendar(int T, int n_events, int n_countries, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> Ut(1, std::max(1, T - 1));
+    std::uniform_real_distribution<double> U(0.0, 1.0);
+    news::EventCalendar cal;
+    for(int i = 0; i < n_events; ++i){
+        int country = i % n_countries;
+        bool cb = U(rng) < 0.1;
+        int importance = n_countries - country;
+        cal.add({Ut(rng), cb ? news::EventType::CENTRAL_BANK : news::EventType::MACRO,
+                 (cb ? 2 : 1) * 1000 + importance, country, cb ? "CB" : "MACRO"});
+    }
+    cal.sort();
+    return cal;
+}
+
 // Build the same synthetic world internally (standalone, no external files)
-static std::vector<Tick> generate_world(int T, unsigned seed = 7){
+// event_at(t) returns the event type at t; it is called once per tick, in order.
+// Tick t draws (switch uniform, surprise, return shock) from block t / kStepBlock
+// of path 0 (Common/ctr_rng.hpp). The draws are filled block by block on n_threads
+// threads; regimes, events and prices then follow in one pass, so the world does
+// not depend on the thread count.
+template <class EventLookup>
+static std::vector<Tick> generate_world(int T, EventLookup&& event_at, unsigned seed = 7, int n_threads = 0){
     const double sigma_base = 0.005;
     const double sigma_event_macro = 0.020;
     const double sigma_event_cb    = 0.030;
@@ -38,14 +72,15 @@ static std::vector<Tick> generate_world(int T, unsigned seed = 7){
 
     const double p_switch = 0.002;
 
-    std::vector<int> macro_events;
-    std::vector<int> cb_events;
-    for(int t = 400; t < T; t += 400) macro_events.push_back(t);
-    for(int t = 800; t < T; t += 800) cb_events.push_back(t);
-
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
-    std::uniform_real_distribution<double> U(0.0, 1.0);
+    std::vector<double> u(T), z_surprise(T), z_ret(T);
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1){
+        ctr::Stream rng(seed, 0, b);
+        for(size_t t = t0; t < t1; ++t){
+            u[t] = rng.uniform();
+            z_surprise[t] = rng.normal();
+            z_ret[t] = rng.normal();
+        }
+    });
 
     double price = 100.0;
     Regime regime = Regime::RISK_ON;
@@ -54,30 +89,26 @@ static std::vector<Tick> generate_world(int T, unsigned seed = 7){
     out.reserve(T);
 
     for(int t=0;t<T;++t){
-        if(U(rng) < p_switch){
+        if(u[t] < p_switch){
             regime = (regime == Regime::RISK_ON) ? Regime::RISK_OFF : Regime::RISK_ON;
         }
 
-        EventType et = EventType::NONE;
-        for(int e: cb_events){ if(t == e){ et = EventType::CENTRAL_BANK; break; } }
-        if(et == EventType::NONE){
-            for(int e: macro_events){ if(t == e){ et = EventType::MACRO; break; } }
-        }
+        news::EventType et = event_at(t);
 
         double surprise = 0.0;
-        if(et != EventType::NONE) surprise = N(rng);
+        if(et != news::EventType::NONE) surprise = z_surprise[t];
 
         double calendar_drift = ((t % 1000) > 950) ? 0.0005 : 0.0;
         double regime_drift = (regime == Regime::RISK_ON) ? 0.0002 : -0.0002;
 
         double sigma = sigma_base;
-        if(et == EventType::MACRO) sigma = sigma_event_macro;
-        if(et == EventType::CENTRAL_BANK) sigma = sigma_event_cb;
+        if(et == news::EventType::MACRO) sigma = sigma_event_macro;
+        if(et == news::EventType::CENTRAL_BANK) sigma = sigma_event_cb;
 
-        double ret = regime_drift + calendar_drift + sigma * N(rng);
+        double ret = regime_drift + calendar_drift + sigma * z_ret[t];
 
-        if(et == EventType::MACRO)        ret += jump_scale_macro * surprise;
-        else if(et == EventType::CENTRAL_BANK) ret += jump_scale_cb * surprise;
+        if(et == news::EventType::MACRO)        ret += jump_scale_macro * surprise;
+        else if(et == news::EventType::CENTRAL_BANK) ret += jump_scale_cb * surprise;
 
         price *= std::exp(ret);
 
@@ -86,26 +117,112 @@ static std::vector<Tick> generate_world(int T, unsigned seed = 7){
     return out;
 }
 
-int main(){
-    const int T = 5000;
-    auto data = generate_world(T);
+static std::vector<Tick> generate_world(int T, const news::EventCalendar& cal, unsigned seed = 7, int n_threads = 0){
+    news::EventCalendar::Cursor cursor(cal);
+    return generate_world(T, [&](int t){
+        const news::CalendarEvent* e = cursor.top(t);
+        return e ? e->type : news::EventType::NONE;
+    }, seed, n_threads);
+}
+
+// Reference lookup: scan the whole calendar on every tick (original behaviour).
+static std::vector<Tick> generate_world_scan(int T, const news::EventCalendar& cal, unsigned seed = 7){
+    return generate_world(T, [&](int t){
+        const news::CalendarEvent* best = nullptr;
+        for(const auto& e : cal.events()){
+            if(e.t == t && (!best || e.priority > best->priority)) best = &e;
+        }
+        return best ? best->type : news::EventType::NONE;
+    }, seed);
+}
+
+// --- Recorded world: the columns of event_study write FILE (t, price, ret,
+// regime, event_type, surprise), read in place. The engines take any series
+// with size() and operator[](t) -> Tick, so they run on it unchanged.
+struct TickColumns {
+    col::View<int32_t> t;
+    col::View<double> price, ret, surprise;
+    col::View<uint8_t> regime, event_type;
+
+    size_t size() const { return t.size; }
+    Tick operator[](size_t i) const {
+        return {t[i], price[i], ret[i], static_cast<Regime>(regime[i]),
+                static_cast<news::EventType>(event_type[i]), surprise[i]};
+    }
+};
+
+// Maps the file and rebuilds its calendar from the event_type column (one
+// event per event tick, with the priorities of the default calendar).
+static bool load_world(const std::string& path, col::Reader& r, TickColumns& data, news::EventCalendar& cal){
+    if(!r.open(path)){
+        std::cerr << r.error() << "\n";
+        return false;
+    }
+    data.t = r.column<int32_t>("t");
+    data.price = r.column<double>("price");
+    data.ret = r.column<double>("ret");
+    data.surprise = r.column<double>("surprise");
+    data.regime = r.column<uint8_t>("regime");
+    data.event_type = r.column<uint8_t>("event_type");
+    if(!data.t || !data.price || !data.ret || !data.surprise || !data.regime || !data.event_type){
+        std::cerr << path << ": need columns t (i32), price, ret, surprise (f64), regime, event_type (u8)"
+                  << " as written by event_study write FILE\n";
+        return false;
+    }
+    for(size_t i = 0; i < data.size(); ++i){
+        const auto type = static_cast<news::EventType>(data.event_type[i]);
+        if(type == news::EventType::MACRO) cal.add({(int)i, type, 1, 0, "MACRO"});
+        else if(type == news::EventType::CENTRAL_BANK) cal.add({(int)i, type, 2, 0, "CB"});
+    }
+    cal.sort();
+    return true;
+}
 
+struct Params {
     // --- Strategy parameters
-    const double k_surprise = 0.75;      // entry threshold on |surprise|
-    const int hold_horizon = 30;         // fixed time exit (news effect decays)
-    const double stop_pct = 0.020;       // stop-like bound (toy)
-    const double take_pct = 0.030;       // take-like bound (toy)
+    double k_surprise = 0.75;      // entry threshold on |surprise|
+    int hold_horizon = 30;         // fixed time exit (news effect decays)
+    double stop_pct = 0.020;       // stop-like bound (toy)
+    double take_pct = 0.030;       // take-like bound (toy)
 
     // Regime filter: scale exposure by regime
-    const double size_risk_on  = 1.0;
-    const double size_risk_off = 0.6;
+    double size_risk_on  = 1.0;
+    double size_risk_off = 0.6;
 
     // Central bank day bias: bigger risk on CB events
-    const double cb_size_multiplier = 1.3;
+    double cb_size_multiplier = 1.3;
 
     // Calendar effects: periodic flow days get size bump
     // (here: last ~50 steps of each 1000-block)
-    const double cal_size_multiplier = 1.2;
+    double cal_size_multiplier = 1.2;
+};
+
+struct RunResult {
+    double pnl = 0.0;
+    int opened = 0;
+    int closed = 0;
+};
+
+static double entry_size(const Tick& cur, news::EventType type, const Params& p){
+    // Base sizing from regime
+    double base_size = (cur.regime == Regime::RISK_ON) ? p.size_risk_on : p.size_risk_off;
+
+    // Calendar sizing bump
+    bool flow_day = ((cur.t % 1000) > 950);
+    double cal_mult = flow_day ? p.cal_size_multiplier : 1.0;
+
+    // CB sizing bump
+    double cb_mult = (type == news::EventType::CENTRAL_BANK) ? p.cb_size_multiplier : 1.0;
+
+    return base_size * cal_mult * cb_mult;
+}
+
+// Tick-by-tick engine: mark-to-market on every tick (reference).
+// log_every > 0 prints a progress line every log_every ticks.
+template <class Series>
+static RunResult run_dense(const Series& data, const news::EventCalendar& cal, const Params& p,
+                           int log_every = 0){
+    const int T = (int)data.size();
 
     // --- Trading state
     PosState pos = PosState::FLAT;
@@ -119,8 +236,10 @@ int main(){
     int trades_closed = 0;
     int trades_opened = 0;
 
+    news::EventCalendar::Cursor events(cal);
     for(int t=1; t<T; ++t){
         const auto& cur = data[t];
+        const news::CalendarEvent* ev = events.top(t);
 
         // If in position, update PnL mark-to-market on returns
         if(pos != PosState::FLAT){
@@ -145,39 +264,29 @@ int main(){
         }
 
         // Time exit
-        if(pos != PosState::FLAT && (t - entry_t >= hold_horizon)){
+        if(pos != PosState::FLAT && (t - entry_t >= p.hold_horizon)){
             pos = PosState::FLAT;
             trades_closed++;
         }
 
         // Entry only at event timestamps AND only if flat
-        if(pos == PosState::FLAT && cur.event_type != EventType::NONE){
-            if(std::fabs(cur.surprise) >= k_surprise){
-                // Base sizing from regime
-                double base_size = (cur.regime == Regime::RISK_ON) ? size_risk_on : size_risk_off;
-
-                // Calendar sizing bump
-                bool flow_day = ((cur.t % 1000) > 950);
-                double cal_mult = flow_day ? cal_size_multiplier : 1.0;
-
-                // CB sizing bump
-                double cb_mult = (cur.event_type == EventType::CENTRAL_BANK) ? cb_size_multiplier : 1.0;
-
-                size = base_size * cal_mult * cb_mult;
+        if(pos == PosState::FLAT && ev){
+            if(std::fabs(cur.surprise) >= p.k_surprise){
+                size = entry_size(cur, ev->type, p);
 
                 // Direction = sign(surprise)  (news breakout abstraction)
                 if(cur.surprise > 0){
                     pos = PosState::LONG;
                     entry_t = t;
                     entry_price = cur.price;
-                    stop = entry_price * (1.0 - stop_pct);
-                    take = entry_price * (1.0 + take_pct);
+                    stop = entry_price * (1.0 - p.stop_pct);
+                    take = entry_price * (1.0 + p.take_pct);
                 } else {
                     pos = PosState::SHORT;
                     entry_t = t;
                     entry_price = cur.price;
-                    stop = entry_price * (1.0 + stop_pct);
-                    take = entry_price * (1.0 - take_pct);
+                    stop = entry_price * (1.0 + p.stop_pct);
+                    take = entry_price * (1.0 - p.take_pct);
                 }
 
                 trades_opened++;
@@ -185,7 +294,7 @@ int main(){
         }
 
         // periodic log
-        if(t % 1000 == 0){
+        if(log_every > 0 && t % log_every == 0){
             std::cout << "t=" << t
                       << " pnl=" << std::fixed << std::setprecision(4) << pnl
                       << " opened=" << trades_opened
@@ -194,10 +303,275 @@ int main(){
         }
     }
 
+    return {pnl, trades_opened, trades_closed};
+}
+
+// Event-skipping engine: jumps from one event to the next and only walks ticks
+// while a position is open. A trade's mark-to-market PnL telescopes to
+// size * sign * (price[exit] - price[entry]), settled once from the price path;
+// a position still open at the end is marked to the last tick, as in run_dense.
+// Cost is O(events * hold_horizon) instead of O(T). PnL matches run_dense up to
+// summation order (relative ~1e-12); trade counts match exactly.
+template <class Series>
+static RunResult run_sparse(const Series& data, const news::EventCalendar& cal, const Params& p){
+    const int T = (int)data.size();
+    const int horizon = std::max(p.hold_horizon, 1);
+    RunResult r;
+
+    int free_from = 1;   // first tick at which the book is flat again
+    const auto& ev = cal.events();
+    for(size_t i = 0; i < ev.size(); ++i){
+        const int t = ev[i].t;
+        if(i > 0 && ev[i-1].t == t) continue;        // lower-priority event at the same tick
+        if(t < free_from || t >= T) continue;
+
+        const Tick& cur = data[t];
+        if(std::fabs(cur.surprise) < p.k_surprise) continue;
+
+        const double size = entry_size(cur, ev[i].type, p);
+        const double s = (cur.surprise > 0) ? 1.0 : -1.0;
+        const double entry_price = cur.price;
+        const double stop = entry_price * (1.0 - s * p.stop_pct);
+        const double take = entry_price * (1.0 + s * p.take_pct);
+        r.opened++;
+
+        // walk the holding period: stop/take first, then time exit
+        int exit_t = -1;
+        const int last = std::min(t + horizon, T - 1);
+        for(int u = t + 1; u <= last; ++u){
+            double px = data[u].price;
+            bool hit = (s > 0) ? (px <= stop || px >= take) : (px >= stop || px <= take);
+            if(hit || u - t >= p.hold_horizon){ exit_t = u; break; }
+        }
+
+        if(exit_t < 0){
+            // still open at the end of the data: mark to the last tick
+            r.pnl += size * s * (data[T-1].price - entry_price);
+            break;
+        }
+        r.pnl += size * s * (data[exit_t].price - entry_price);
+        r.closed++;
+        free_from = exit_t;   // exit happens before entry on the same tick
+    }
+    return r;
+}
+
+// --- Parameter sweep on the event-skipping engine
+
+static int run_sweep(int argc, char** argv){
+    util::Range k{0.25, 2.0, 0.25}, hold{10, 60, 10}, stop{0.01, 0.04, 0.01}, take{0.01, 0.05, 0.01};
+
+    for(int a = 2; a < argc; ++a){
+        std::string arg = argv[a];
+        if(util::parse_range(arg, "k", k) || util::parse_range(arg, "hold", hold) || util::parse_range(arg, "stop", stop) ||
+           util::parse_range(arg, "take", take) || util::arg_has_key(arg, "n") || util::arg_has_key(arg, "top")) continue;
+        std::cerr << "Unknown sweep argument: " << arg
+                  << " (expected k=, hold=, stop=, take= as lo:hi:step, or n=, top=)\n";
+        return 1;
+    }
+    for(const auto& axis : {std::make_pair("k", &k), std::make_pair("hold", &hold),
+                            std::make_pair("stop", &stop), std::make_pair("take", &take)})
+        if(!axis.second->ok){
+            std::cerr << util::range_error(axis.first) << "\n";
+            return 1;
+        }
+    if(util::grid_count({&k, &hold, &stop, &take}) == 0){
+        std::cerr << "The grid has more than " << util::Range::kMaxCount << " combinations.\n";
+        return 1;
+    }
+
+    uint64_t n, top_n;
+    std::string err;
+    if(!util::arg_count_in(argc, argv, "n", 100000, 1, INT_MAX, n, err) ||
+       !util::arg_count_in(argc, argv, "top", 20, 1, INT_MAX, top_n, err)){
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int T = (int)n;
+    const int top = (int)top_n;
+    const news::EventCalendar cal = news::default_calendar(T);
+    auto data = generate_world(T, cal);
+
+    struct Row { Params p; RunResult r; };
+    std::vector<Row> rows;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int a = 0; a < k.count(); ++a)
+        for(int b = 0; b < hold.count(); ++b)
+            for(int c = 0; c < stop.count(); ++c)
+                for(int d = 0; d < take.count(); ++d){
+                    Params p;
+                    p.k_surprise = k.at(a);
+                    p.hold_horizon = (int)std::lround(hold.at(b));
+                    p.stop_pct = stop.at(c);
+                    p.take_pct = take.at(d);
+                    rows.push_back({p, run_sparse(data, cal, p)});
+                }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // rank by PnL, ties broken by grid order
+    std::stable_sort(rows.begin(), rows.end(), [](const Row& x, const Row& y){ return x.r.pnl > y.r.pnl; });
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Macro Surprise Breakout sweep (event-skipping engine)\n";
+    std::cout << "Ticks: " << T << " | Events: " << cal.size() << " | Combinations: " << rows.size()
+              << " | Time: " << secs << "s\n\n";
+    std::cout << std::setw(7) << "k" << std::setw(6) << "hold" << std::setw(8) << "stop%" << std::setw(8) << "take%"
+              << std::setw(8) << "opened" << std::setw(8) << "closed" << std::setw(12) << "PnL" << "\n";
+    for(int i = 0; i < std::min(top, (int)rows.size()); ++i){
+        const auto& r = rows[i];
+        std::cout << std::setw(7) << std::setprecision(2) << r.p.k_surprise << std::setw(6) << r.p.hold_horizon
+                  << std::setw(8) << 100.0 * r.p.stop_pct << std::setw(8) << 100.0 * r.p.take_pct
+                  << std::setw(8) << r.r.opened << std::setw(8) << r.r.closed
+                  << std::setw(12) << std::setprecision(4) << r.r.pnl << "\n";
+    }
+    return 0;
+}
+
+// Calendar cursor vs. full scan: identical worlds on the default and on a dense
+// multi-country calendar. Event-skipping vs. tick-by-tick engine: same trade
+// counts and PnL (relative 1e-9) over a parameter grid, plus timings. A world
+// written in event_study's layout and read back trades the same.
+static int run_check(){
+    int failures = 0;
+    auto same = [](const std::vector<Tick>& a, const std::vector<Tick>& b){
+        if(a.size() != b.size()) return false;
+        for(size_t i = 0; i < a.size(); ++i){
+            if(a[i].price != b[i].price || a[i].ret != b[i].ret || a[i].regime != b[i].regime ||
+               a[i].event_type != b[i].event_type || a[i].surprise != b[i].surprise) return false;
+        }
+        return true;
+    };
+
+    struct Case { const char* name; int T; news::EventCalendar cal; };
+    const int T_dense = 200000;
+    Case cases[] = {
+        {"default", 5000, news::default_calendar(5000)},
+        {"dense", T_dense, dense_calendar(T_dense, 20000, 25, 3)},
+    };
+
+    std::cout << std::fixed << std::setprecision(4);
+    for(const auto& c : cases){
+        auto t0 = std::chrono::steady_clock::now();
+        auto fast = generate_world(c.T, c.cal);
+        double t_fast = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        t0 = std::chrono::steady_clock::now();
+        auto ref = generate_world_scan(c.T, c.cal);
+        double t_scan = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        bool ok = same(fast, ref);
+        if(!ok) failures++;
+        std::cout << c.name << ": T=" << c.T << " events=" << c.cal.size()
+                  << " cursor " << t_fast << "s | scan " << t_scan << "s | "
+                  << (ok ? "match" : "MISMATCH") << "\n";
+
+        // generator: the same world whatever the thread count
+        bool same_thr = true;
+        for(int th : {1, 3, 8}) same_thr = same_thr && same(generate_world(c.T, c.cal, 7, th), fast);
+        if(!same_thr) failures++;
+        std::cout << "  generator across thread counts: " << (same_thr ? "match" : "MISMATCH") << "\n";
+
+        // sparse vs. dense engine on a small grid (including horizons past the end of data)
+        int bad = 0, runs = 0;
+        double max_rel = 0.0;
+        double t_dense = 0.0, t_sparse = 0.0;
+        for(double k : {0.0, 0.75, 1.5})
+            for(int hold : {0, 1, 30, 200})
+                for(double stop : {0.005, 0.02}){
+                    Params p;
+                    p.k_surprise = k;
+                    p.hold_horizon = hold;
+                    p.stop_pct = stop;
+                    t0 = std::chrono::steady_clock::now();
+                    RunResult d = run_dense(fast, c.cal, p);
+                    t_dense += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                    t0 = std::chrono::steady_clock::now();
+                    RunResult s = run_sparse(fast, c.cal, p);
+                    t_sparse += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+                    double rel = std::fabs(d.pnl - s.pnl) / std::max(1.0, std::fabs(d.pnl));
+                    max_rel = std::max(max_rel, rel);
+                    if(d.opened != s.opened || d.closed != s.closed || rel > 1e-9) bad++;
+                    runs++;
+                }
+        if(bad) failures++;
+        std::cout << std::setprecision(4) << "  sparse vs dense: " << runs << " runs, " << bad << " mismatches, max rel PnL diff "
+                  << std::scientific << std::setprecision(2) << max_rel << std::fixed << std::setprecision(4)
+                  << " | dense " << t_dense << "s | sparse " << t_sparse << "s\n";
+    }
+
+    // recorded world: event_study's column layout read back through TickColumns
+    // and the rebuilt calendar gives the same trades as the in-memory world
+    {
+        const int T = 5000;
+        const news::EventCalendar cal = news::default_calendar(T);
+        auto world = generate_world(T, cal, 42);
+        const std::string path = "macro_news_check.col";
+        col::Writer w;
+        if(w.open(path, {{"t", col::Type::I32}, {"price", col::Type::F64}, {"ret", col::Type::F64},
+                         {"regime", col::Type::U8}, {"event_type", col::Type::U8}, {"surprise", col::Type::F64}}, T)){
+            for(const Tick& k : world)
+                w.append(k.t, k.price, k.ret, static_cast<uint8_t>(k.regime),
+                         static_cast<uint8_t>(k.event_type), k.surprise);
+        }
+        bool ok = w.close();
+        if(ok){
+            col::Reader reader;
+            TickColumns data;
+            news::EventCalendar rec;
+            ok = load_world(path, reader, data, rec);
+            for(double k : {0.0, 0.75}){
+                Params p;
+                p.k_surprise = k;
+                RunResult a = run_dense(world, cal, p), b = run_dense(data, rec, p), c = run_sparse(data, rec, p);
+                ok = ok && a.opened == b.opened && a.closed == b.closed && a.pnl == b.pnl &&
+                     a.opened == c.opened && std::fabs(a.pnl - c.pnl) <= 1e-9 * std::max(1.0, std::fabs(a.pnl));
+            }
+        }
+        std::remove(path.c_str());
+        if(!ok) failures++;
+        std::cout << "recorded world (event_study write layout): " << (ok ? "match" : "MISMATCH") << "\n";
+    }
+
+    std::cout << "Calendar / event-skipping check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+static int usage(){
+    std::cerr << "Usage: macro_news_breakout [run|sparse] [data=FILE]\n"
+                 "       macro_news_breakout sweep [k=lo:hi:step] [hold=...] [stop=...] [take=...] [n=N] [top=K]\n"
+                 "       macro_news_breakout check\n";
+    return 1;
+}
+
+int main(int argc, char** argv){
+    std::string mode = (argc > 1) ? argv[1] : "run";
+    // a key=value first means the default mode
+    if(mode.find('=') != std::string::npos) mode = "run";
+    if(mode == "check") return run_check();
+    if(mode == "sweep") return run_sweep(argc, argv);
+    if(mode != "run" && mode != "sparse") return usage();
+
+    Params p;
+    RunResult r;
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    if(path.empty()){
+        const int T = 5000;
+        const news::EventCalendar cal = news::default_calendar(T);
+        auto data = generate_world(T, cal);
+        r = (mode == "sparse") ? run_sparse(data, cal, p) : run_dense(data, cal, p, 1000);
+    } else {
+        // data=FILE replays a world recorded by event_study write FILE
+        col::Reader reader;
+        TickColumns data;
+        news::EventCalendar cal;
+        if(!load_world(path, reader, data, cal)) return 1;
+        r = (mode == "sparse") ? run_sparse(data, cal, p) : run_dense(data, cal, p, 1000);
+    }
+
     std::cout << "\nEvent/Macro/News-Driven: Macro Surprise Breakout (standalone C++)\n";
-    std::cout << "Trades opened: " << trades_opened << "\n";
-    std::cout << "Trades closed: " << trades_closed << "\n";
-    std::cout << "Total PnL (synthetic units): " << std::fixed << std::setprecision(4) << pnl << "\n";
+    std::cout << "Trades opened: " << r.opened << "\n";
+    std::cout << "Trades closed: " << r.closed << "\n";
+    std::cout << "Total PnL (synthetic units): " << std::fixed << std::setprecision(4) << r.pnl << "\n";
 
     return 0;
 }
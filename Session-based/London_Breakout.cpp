@@ -1,11 +1,22 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "../Common/ctr_rng.hpp"
+#include "../Common/mt5_csv.hpp"
+#include "../Common/util.hpp"
+
 enum class PosState { FLAT=0, LONG=1, SHORT=-1 };
 
 struct Trade {
@@ -23,64 +34,228 @@ struct Bar {
     double open=0, high=0, low=0, close=0;
 };
 
-int main() {
-    // --- Intraday simulation setup
-    const int days = 120;
-    const int bars_per_day = 24 * 12;          // 5-min bars
-    const int T = days * bars_per_day;
+struct Params {
+    int bars_per_day = 24 * 12;          // 5-min bars
 
     // Session times (in "day minutes", consistent with 5-min bars)
     // Asia: 00:00 -> 08:00, London: 09:00 -> 18:00 (same convention as README)
-    const int asia_start_bar   = 0 * 12;       // 00:00
-    const int asia_end_bar     = 8 * 12;       // 08:00 (exclusive)
-    const int london_open_bar  = 9 * 12;       // 09:00
-    const int london_close_bar = 18 * 12;      // 18:00 (exclusive)
+    int asia_start_bar   = 0 * 12;       // 00:00
+    int asia_end_bar     = 8 * 12;       // 08:00 (exclusive)
+    int london_open_bar  = 9 * 12;       // 09:00
+    int london_close_bar = 18 * 12;      // 18:00 (exclusive)
 
     // Breakout buffer (in price units, synthetic)
-    const double buffer = 0.00;
+    double buffer = 0.00;
 
     // Risk parameters (percent of entry price)
-    const bool   useSLTP = true;
-    const double alphaSL = 0.006;  // 0.6%
-    const double alphaTP = 0.012;  // 1.2%
+    bool   useSLTP = true;
+    double alphaSL = 0.006;  // 0.6%
+    double alphaTP = 0.012;  // 1.2%
+};
 
-    // --- Synthetic price process with time-of-day volatility pattern
-    const double S0 = 100.0;
-    const uint32_t seed = 7;
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
+// --- Synthetic price process with time-of-day volatility pattern
+// Counter-based draws (Common/ctr_rng.hpp): bar t uses block t / kStepBlock of
+// path 0. Blocks store their close / high / low factors on n_threads threads (3
+// batch normals per bar, one exp over the block), then one pass chains the
+// closes, so the bars do not depend on the thread count.
+static std::vector<Bar> generate_bars(int days, const Params& p, double S0, uint32_t seed, int n_threads = 0) {
+    const int T = days * p.bars_per_day;
 
     // vol schedule: low in Asia, higher around London
     auto vol_for_bar = [&](int bar_in_day) {
-        if (bar_in_day >= asia_start_bar && bar_in_day < asia_end_bar) return 0.0006;
-        if (bar_in_day >= london_open_bar && bar_in_day < london_open_bar + 6) return 0.0022; // burst
-        if (bar_in_day >= london_open_bar && bar_in_day < london_close_bar) return 0.0012;
+        if (bar_in_day >= p.asia_start_bar && bar_in_day < p.asia_end_bar) return 0.0006;
+        if (bar_in_day >= p.london_open_bar && bar_in_day < p.london_open_bar + 6) return 0.0022; // burst
+        if (bar_in_day >= p.london_open_bar && bar_in_day < p.london_close_bar) return 0.0012;
         return 0.0008;
     };
 
     std::vector<Bar> bars(T);
-    double last = S0;
-
-    for (int t = 0; t < T; ++t) {
-        int bar_in_day = t % bars_per_day;
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        const size_t len = t1 - t0;
+        double z[3 * ctr::kStepBlock];   // per-thread scratch on the stack, no allocation per block
+        ctr::Stream(seed, 0, b).normals(z, 3 * len);
+        for (size_t i = 0; i < len; ++i) {
+            double sigma = vol_for_bar((int)((t0 + i) % p.bars_per_day));
+            z[3*i]   = -0.5*sigma*sigma + sigma*z[3*i];
+            z[3*i+1] = std::fabs(sigma*z[3*i+1]);
+            z[3*i+2] = std::fabs(sigma*z[3*i+2]);
+        }
+        ctr::exp_batch(z, 3 * len);
 
-        double sigma = vol_for_bar(bar_in_day);
-        double z1 = N(rng);
-        double z2 = N(rng);
-        double z3 = N(rng);
+        // close / high / low factors, chained below
+        for (size_t i = 0; i < len; ++i) {
+            bars[t0 + i].close = z[3*i];
+            bars[t0 + i].high  = z[3*i+1];
+            bars[t0 + i].low   = z[3*i+2];
+        }
+    });
 
+    double last = S0;
+    for (int t = 0; t < T; ++t) {
         // build a simple OHLC around a random walk close
         double open = last;
-        double close = open * std::exp(-0.5*sigma*sigma + sigma*z1);
+        double close = open * bars[t].close;
 
         // intrabar high/low approximations
-        double h = std::max(open, close) * std::exp(std::fabs(sigma*z2));
-        double l = std::min(open, close) / std::exp(std::fabs(sigma*z3));
+        double h = std::max(open, close) * bars[t].high;
+        double l = std::min(open, close) / bars[t].low;
 
         bars[t] = {open, h, l, close};
         last = close;
     }
+    return bars;
+}
+
+// days= as a count of whole synthetic days; bar indices are int.
+static bool read_days(int argc, char** argv, int def, const Params& p, int& days, std::string& err) {
+    uint64_t n = 0;
+    if (!util::arg_count_in(argc, argv, "days", def, 1, INT_MAX / p.bars_per_day, n, err)) return false;
+    days = (int)n;
+    return true;
+}
+
+// --- MT5 history on the session grid (loading: Common/mt5_csv.hpp)
+// Bars are laid on the strategy's grid of bars_per_day slots per day by their time
+// of day; bars finer than the grid (M1 into M5) are merged into their slot. A slot
+// with no bar repeats the previous close as a flat bar, and days without any bar
+// (weekends, holidays) are dropped. Session hours apply to the export's server time.
+static bool load_session_bars(const std::string& path, const Params& p, std::vector<Bar>& bars, int& days) {
+    mt5::Bars in;
+    std::string err;
+    if (!mt5::load_bars(path, in, err)) {
+        std::cerr << err << "\n";
+        return false;
+    }
+    const int64_t slot_sec = 86400 / p.bars_per_day;
+    bars.clear();
+    days = 0;
+    std::vector<char> filled;
+    int64_t day = 0;
+
+    // flat bars at the previous close in the empty slots of the last day
+    auto fill_day = [&]() {
+        const size_t base = bars.size() - p.bars_per_day;
+        int first = 0;
+        while (!filled[first]) ++first;
+        double prev = base > 0 ? bars[base - 1].close : bars[base + first].open;
+        for (int k = 0; k < p.bars_per_day; ++k) {
+            if (!filled[k]) bars[base + k] = {prev, prev, prev, prev};
+            prev = bars[base + k].close;
+        }
+    };
+
+    for (size_t i = 0; i < in.size(); ++i) {
+        const int64_t t = in.time[i];
+        const int64_t d = (t >= 0 ? t : t - 86399) / 86400;
+        const int slot = (int)((t - d * 86400) / slot_sec);
+        if (days == 0 || d != day) {
+            if (days > 0 && d < day) {
+                std::cerr << path << ": bars are not in time order (line " << i + 2 << ")\n";
+                return false;
+            }
+            if (days > 0) fill_day();
+            bars.resize(bars.size() + p.bars_per_day);
+            filled.assign(p.bars_per_day, 0);
+            day = d;
+            ++days;
+        }
+        Bar& b = bars[bars.size() - p.bars_per_day + slot];
+        if (!filled[slot]) {
+            b = {in.open[i], in.high[i], in.low[i], in.close[i]};
+            filled[slot] = 1;
+        } else {
+            b.high = std::max(b.high, in.high[i]);
+            b.low = std::min(b.low, in.low[i]);
+            b.close = in.close[i];
+        }
+    }
+    if (days > 0) fill_day();
+    return true;
+}
+
+// --- Session range sources: range(l, r, hi, lo) sets the max high / min low over bars [l, r)
+
+// Reference source: linear scan over the session (original implementation).
+struct ScanRange {
+    const std::vector<Bar>& bars;
+
+    void operator()(int l, int r, double& hi, double& lo) const {
+        hi = -1e100;
+        lo =  1e100;
+        for (int i = l; i < r; ++i) {
+            hi = std::max(hi, bars[i].high);
+            lo = std::min(lo, bars[i].low);
+        }
+    }
+};
 
+// Sparse-table range max (high) / range min (low), built once over the bar series.
+// Level k holds the extremum of the 2^k bars starting at i, so any range of length
+// up to 2^(levels-1) is two overlapping lookups. Levels are capped to cover
+// `max_len` bars (sessions are at most a couple of days), which keeps memory at
+// O(T log max_len); longer ranges fall back to a walk over top-level blocks.
+class SessionRangeIndex {
+public:
+    SessionRangeIndex(const std::vector<Bar>& bars, int max_len) : n_((int)bars.size()) {
+        int levels = 1;
+        while ((1 << levels) <= std::min(std::max(max_len, 1), std::max(n_, 1))) ++levels;
+        hi_.resize(levels);
+        lo_.resize(levels);
+        hi_[0].resize(n_);
+        lo_[0].resize(n_);
+        for (int i = 0; i < n_; ++i) {
+            hi_[0][i] = bars[i].high;
+            lo_[0][i] = bars[i].low;
+        }
+        for (int k = 1; k < levels; ++k) {
+            const int half = 1 << (k - 1);
+            const int m = n_ - (1 << k) + 1;
+            hi_[k].resize(std::max(m, 0));
+            lo_[k].resize(std::max(m, 0));
+            for (int i = 0; i < m; ++i) {
+                hi_[k][i] = std::max(hi_[k-1][i], hi_[k-1][i + half]);
+                lo_[k][i] = std::min(lo_[k-1][i], lo_[k-1][i + half]);
+            }
+        }
+    }
+
+    void operator()(int l, int r, double& hi, double& lo) const {
+        hi = -1e100;
+        lo =  1e100;
+        if (r <= l) return;
+        const int len = r - l;
+        int k = std::min(floor_log2(len), (int)hi_.size() - 1);
+        const int w = 1 << k;
+        for (int i = l; i + w < r; i += w) {
+            hi = std::max(hi, hi_[k][i]);
+            lo = std::min(lo, lo_[k][i]);
+        }
+        hi = std::max(hi, hi_[k][r - w]);
+        lo = std::min(lo, lo_[k][r - w]);
+    }
+
+    size_t bytes() const {
+        size_t b = 0;
+        for (const auto& v : hi_) b += 2 * v.size() * sizeof(double);
+        return b;
+    }
+
+private:
+    static int floor_log2(int x) { return 31 - __builtin_clz((unsigned)x); }
+
+    int n_;
+    std::vector<std::vector<double>> hi_, lo_;
+};
+
+// One trading day: Asian range, two stop orders at London open, SL/TP during the
+// session, pending orders expired and position forced flat at London close.
+// Every day starts and ends flat, so days are independent given the bar series;
+// trades of day d are appended to `trades` in time order. A range window that
+// starts before the first bar (e.g. a Sydney session opening the previous
+// evening) makes the day untradeable.
+template <class RangeQuery>
+static void run_day(const std::vector<Bar>& bars, const Params& p, int d, std::vector<Trade>& trades,
+                    const RangeQuery& range) {
     // --- Strategy state
     PosState pos = PosState::FLAT;
     double entry = 0.0;
@@ -89,10 +264,7 @@ int main() {
     bool pending_buy = false, pending_sell = false;
     double buy_level = 0.0, sell_level = 0.0;
 
-    std::vector<Trade> trades;
-    trades.reserve(256);
-
-    auto open_pos = [&](int day, int idx, PosState side, double px) {
+    auto open_pos = [&](int idx, PosState side, double px) {
         pos = side;
         entry = px;
         entry_idx = idx;
@@ -120,72 +292,387 @@ int main() {
         entry_idx = -1;
     };
 
-    // --- Main loop day by day
-    for (int d = 0; d < days; ++d) {
-        int day_start = d * bars_per_day;
+    int day_start = d * p.bars_per_day;
+    if (day_start + p.asia_start_bar < 0) return;
+
+    // 1) compute Asian range from bars [asia_start, asia_end)
+    double asiaHigh, asiaLow;
+    range(day_start + p.asia_start_bar, day_start + p.asia_end_bar, asiaHigh, asiaLow);
+
+    // 2) at London open, place two stop orders (if flat)
+    if (pos == PosState::FLAT) {
+        pending_buy = true;
+        pending_sell = true;
+        buy_level  = asiaHigh + p.buffer;
+        sell_level = asiaLow  - p.buffer;
+    }
+
+    // 3) trade during London session only
+    for (int bi = p.london_open_bar; bi < p.london_close_bar; ++bi) {
+        int t = day_start + bi;
+        const auto& b = bars[t];
+
+        // --- If in position, check SL/TP first (evaluated independently of signals)
+        if (p.useSLTP && pos != PosState::FLAT) {
+            int s = static_cast<int>(pos);
+            double SL = entry * (1.0 - s * p.alphaSL);
+            double TP = entry * (1.0 + s * p.alphaTP);
+
+            bool hitSL = (s == +1) ? (b.low  <= SL) : (b.high >= SL);
+            bool hitTP = (s == +1) ? (b.high >= TP) : (b.low  <= TP);
 
-        // 1) compute Asian range from bars [asia_start, asia_end)
-        double asiaHigh = -1e100;
-        double asiaLow  =  1e100;
-        for (int i = day_start + asia_start_bar; i < day_start + asia_end_bar; ++i) {
-            asiaHigh = std::max(asiaHigh, bars[i].high);
-            asiaLow  = std::min(asiaLow,  bars[i].low);
+            if (hitSL) { close_pos(d, t, SL, "SL"); break; }
+            if (hitTP) { close_pos(d, t, TP, "TP"); break; }
         }
 
-        // 2) at London open, place two stop orders (if flat)
+        // --- If flat, check pending stops (breakout)
         if (pos == PosState::FLAT) {
-            pending_buy = true;
-            pending_sell = true;
-            buy_level  = asiaHigh + buffer;
-            sell_level = asiaLow  - buffer;
+            // approximate priority if both hit same bar:
+            // choose the level closer to open (very minor detail; still deterministic)
+            bool hitBuy  = pending_buy  && (b.high >= buy_level);
+            bool hitSell = pending_sell && (b.low  <= sell_level);
+
+            if (hitBuy && hitSell) {
+                double distBuy  = std::fabs(b.open - buy_level);
+                double distSell = std::fabs(b.open - sell_level);
+                if (distBuy <= distSell) open_pos(t, PosState::LONG,  buy_level);
+                else                     open_pos(t, PosState::SHORT, sell_level);
+                continue;
+            }
+
+            if (hitBuy)  { open_pos(t, PosState::LONG,  buy_level);  continue; }
+            if (hitSell) { open_pos(t, PosState::SHORT, sell_level); continue; }
         }
+    }
 
-        // 3) trade during London session only
-        for (int bi = london_open_bar; bi < london_close_bar; ++bi) {
-            int t = day_start + bi;
-            const auto& b = bars[t];
+    // 4) at London close: expire pending orders; optionally flat by session end
+    pending_buy = pending_sell = false;
 
-            // --- If in position, check SL/TP first (evaluated independently of signals)
-            if (useSLTP && pos != PosState::FLAT) {
-                int s = static_cast<int>(pos);
-                double SL = entry * (1.0 - s * alphaSL);
-                double TP = entry * (1.0 + s * alphaTP);
+    // optional: force exit at session end if still in position
+    int end_t = day_start + (p.london_close_bar - 1);
+    if (pos != PosState::FLAT) {
+        close_pos(d, end_t, bars[end_t].close, "SessionClose");
+    }
+}
 
-                bool hitSL = (s == +1) ? (b.low  <= SL) : (b.high >= SL);
-                bool hitTP = (s == +1) ? (b.high >= TP) : (b.low  <= TP);
+template <class RangeQuery>
+static std::vector<Trade> run_serial(const std::vector<Bar>& bars, const Params& p, int days,
+                                     const RangeQuery& range) {
+    std::vector<Trade> trades;
+    trades.reserve(256);
+    for (int d = 0; d < days; ++d) run_day(bars, p, d, trades, range);
+    return trades;
+}
 
-                if (hitSL) { close_pos(d, t, SL, "SL"); break; }
-                if (hitTP) { close_pos(d, t, TP, "TP"); break; }
-            }
+// Day-sharded run: days are cut into fixed blocks of `block_days`, workers claim
+// blocks from an atomic counter and fill the block's own trade vector. Blocks are
+// concatenated in day order, so the result is identical to run_serial for any
+// thread count or scheduling.
+template <class RangeQuery>
+static std::vector<Trade> run_parallel(const std::vector<Bar>& bars, const Params& p, int days,
+                                       const RangeQuery& range, int n_threads, int block_days = 32) {
+    block_days = std::max(1, block_days);
+    const int n_blocks = (days + block_days - 1) / block_days;
+    std::vector<std::vector<Trade>> shard(n_blocks);
+    std::atomic<int> next{0};
+
+    auto worker = [&]() {
+        for (int k; (k = next.fetch_add(1)) < n_blocks; ) {
+            int d_end = std::min(days, (k + 1) * block_days);
+            for (int d = k * block_days; d < d_end; ++d) run_day(bars, p, d, shard[k], range);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < std::min(std::max(1, n_threads), n_blocks); ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
 
-            // --- If flat, check pending stops (breakout)
-            if (pos == PosState::FLAT) {
-                // approximate priority if both hit same bar:
-                // choose the level closer to open (very minor detail; still deterministic)
-                bool hitBuy  = pending_buy  && (b.high >= buy_level);
-                bool hitSell = pending_sell && (b.low  <= sell_level);
-
-                if (hitBuy && hitSell) {
-                    double distBuy  = std::fabs(b.open - buy_level);
-                    double distSell = std::fabs(b.open - sell_level);
-                    if (distBuy <= distSell) open_pos(d, t, PosState::LONG,  buy_level);
-                    else                     open_pos(d, t, PosState::SHORT, sell_level);
-                    continue;
-                }
-
-                if (hitBuy)  { open_pos(d, t, PosState::LONG,  buy_level);  continue; }
-                if (hitSell) { open_pos(d, t, PosState::SHORT, sell_level); continue; }
+    size_t total = 0;
+    for (const auto& v : shard) total += v.size();
+    std::vector<Trade> trades;
+    trades.reserve(total);
+    for (auto& v : shard) trades.insert(trades.end(), std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+    return trades;
+}
+
+static bool same_trades(const std::vector<Trade>& a, const std::vector<Trade>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].day != b[i].day || a[i].entry_idx != b[i].entry_idx || a[i].exit_idx != b[i].exit_idx ||
+            a[i].side != b[i].side || a[i].entry_px != b[i].entry_px || a[i].exit_px != b[i].exit_px ||
+            a[i].reason != b[i].reason || a[i].pnl != b[i].pnl) return false;
+    }
+    return true;
+}
+
+// --- Session-config sweep
+
+struct Summary {
+    int trades = 0, wins = 0;
+    double pnl = 0.0, maxDD = 0.0;
+};
+
+static Summary summarize(const std::vector<Trade>& trades) {
+    Summary s;
+    double equity = 0.0, peak = 0.0;
+    for (const auto& tr : trades) {
+        s.pnl += tr.pnl;
+        equity += tr.pnl;
+        peak = std::max(peak, equity);
+        s.maxDD = std::max(s.maxDD, peak - equity);
+        if (tr.pnl >= 0) s.wins++;
+    }
+    s.trades = (int)trades.size();
+    return s;
+}
+
+// Range-session grid, in hours relative to the trading day (negative start =
+// previous evening, e.g. Sydney -2:00 -> 07:00). London hours stay fixed.
+struct SessionGrid {
+    util::Range start{-6, 2, 1}, end{5, 9, 1}, buffer{0.0, 0.2, 0.05};
+};
+
+struct SweepRow {
+    Params p;
+    Summary s;
+};
+
+// Every valid (start, end, buffer) combination, in grid order; each is one job
+// over all days, with every session range answered in O(1) by the shared index.
+template <class RangeQuery>
+static std::vector<SweepRow> sweep_rows(const std::vector<Bar>& bars, const Params& base, int days,
+                                        const SessionGrid& g, const RangeQuery& range, int n_threads) {
+    std::vector<SweepRow> rows;
+    for (int i = 0; i < g.start.count(); ++i)
+        for (int j = 0; j < g.end.count(); ++j)
+            for (int k = 0; k < g.buffer.count(); ++k) {
+                Params p = base;
+                p.asia_start_bar = (int)std::lround(g.start.at(i) * 12);
+                p.asia_end_bar   = (int)std::lround(g.end.at(j) * 12);
+                p.buffer         = g.buffer.at(k);
+                if (p.asia_start_bar < p.asia_end_bar && p.asia_end_bar <= p.london_open_bar)
+                    rows.push_back({p, Summary{}});
             }
+
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int job; (job = next.fetch_add(1)) < (int)rows.size(); )
+            rows[job].s = summarize(run_serial(bars, rows[job].p, days, range));
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < std::min(std::max(1, n_threads), (int)rows.size()); ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    return rows;
+}
+
+static int run_sweep(int argc, char** argv) {
+    SessionGrid g;
+
+    for (int a = 2; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (util::parse_range(arg, "start", g.start) || util::parse_range(arg, "end", g.end) ||
+            util::parse_range(arg, "buffer", g.buffer)) continue;
+        bool scalar = false;   // read below
+        for (const char* key : {"days", "threads", "top", "data"}) scalar = scalar || util::arg_has_key(arg, key);
+        if (scalar) continue;
+        std::cerr << "Unknown sweep argument: " << arg
+                  << " (expected start=, end= in hours and buffer= as lo:hi:step, or days=, threads=, top=, data=FILE)\n";
+        return 1;
+    }
+    for (const auto& axis : {std::make_pair("start", &g.start), std::make_pair("end", &g.end),
+                             std::make_pair("buffer", &g.buffer)})
+        if (!axis.second->ok) {
+            std::cerr << util::range_error(axis.first) << "\n";
+            return 1;
         }
+    if (util::grid_count({&g.start, &g.end, &g.buffer}) == 0) {
+        std::cerr << "The grid has more than " << util::Range::kMaxCount << " combinations.\n";
+        return 1;
+    }
 
-        // 4) at London close: expire pending orders; optionally flat by session end
-        pending_buy = pending_sell = false;
+    Params p;
+    int days = 0;
+    uint64_t threads, top_n;
+    std::string err;
+    if (!read_days(argc, argv, 120, p, days, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err) ||
+        !util::arg_count_in(argc, argv, "top", 20, 1, INT_MAX, top_n, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = ctr::thread_count((int)threads);
+    const int top = (int)top_n;
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    std::vector<Bar> bars;
+    if (path.empty()) bars = generate_bars(days, p, 100.0, 7);
+    else if (!load_session_bars(path, p, bars, days)) return 1;
+
+    auto t0 = std::chrono::steady_clock::now();
+    SessionRangeIndex index(bars, 2 * p.bars_per_day);
+    std::vector<SweepRow> rows = sweep_rows(bars, p, days, g, index, n_threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (rows.empty()) {
+        std::cerr << "No valid session window in the grid (need start < end <= London open).\n";
+        return 1;
+    }
 
-        // optional: force exit at session end if still in position
-        int end_t = day_start + (london_close_bar - 1);
-        if (pos != PosState::FLAT) {
-            close_pos(d, end_t, bars[end_t].close, "SessionClose");
+    // rank by PnL, ties broken by grid order
+    std::stable_sort(rows.begin(), rows.end(), [](const SweepRow& x, const SweepRow& y) {
+        return x.s.pnl > y.s.pnl;
+    });
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "London Breakout session sweep (standalone C++)\n";
+    std::cout << "Days: " << days << " | Configurations: " << rows.size()
+              << " | Index: " << index.bytes() / 1024 << " KiB | Time: " << secs << "s\n\n";
+    std::cout << std::setw(8) << "start" << std::setw(8) << "end" << std::setw(9) << "buffer"
+              << std::setw(8) << "trades" << std::setw(9) << "win%"
+              << std::setw(11) << "PnL" << std::setw(11) << "maxDD" << "\n";
+    for (int k = 0; k < std::min(top, (int)rows.size()); ++k) {
+        const auto& r = rows[k];
+        double wr = r.s.trades > 0 ? 100.0 * r.s.wins / r.s.trades : 0.0;
+        std::cout << std::setw(8) << std::setprecision(2) << r.p.asia_start_bar / 12.0
+                  << std::setw(8) << r.p.asia_end_bar / 12.0
+                  << std::setw(9) << r.p.buffer
+                  << std::setw(8) << r.s.trades << std::setw(9) << wr
+                  << std::setw(11) << std::setprecision(4) << r.s.pnl << std::setw(11) << r.s.maxDD << "\n";
+    }
+    return 0;
+}
+
+// Sparse-table ranges vs. linear scans, indexed vs. scanned runs, sweep rows vs.
+// scanned single runs, and serial vs. day-sharded runs (trade-for-trade equality
+// for several thread counts and block sizes, plus timing on a long series).
+static int run_check(int argc, char** argv) {
+    Params p;
+    int days = 0;
+    std::string err;
+    if (!read_days(argc, argv, 5000, p, days, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int hw = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Bar> bars = generate_bars(days, p, 100.0, 7);
+    const int T = (int)bars.size();
+    int failures = 0;
+
+    ScanRange scan{bars};
+    auto t0 = std::chrono::steady_clock::now();
+    SessionRangeIndex index(bars, 2 * p.bars_per_day);
+    double t_build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // random ranges, including lengths beyond the capped levels
+    {
+        std::mt19937 rng(11);
+        int bad = 0;
+        for (int q = 0; q < 200000; ++q) {
+            int len = 1 + (int)(rng() % (q % 10 == 0 ? 8 * p.bars_per_day : p.bars_per_day));
+            int l = (int)(rng() % (uint32_t)std::max(1, T - len));
+            double h1, l1, h2, l2;
+            scan(l, std::min(T, l + len), h1, l1);
+            index(l, std::min(T, l + len), h2, l2);
+            if (h1 != h2 || l1 != l2) bad++;
+        }
+        if (bad) failures++;
+        std::cout << "Range index vs scan (200000 random ranges): " << bad << " mismatches"
+                  << (bad ? "  FAILED" : "  OK") << "\n";
+    }
+
+    // generator: the same bars whatever the thread count
+    {
+        bool ok = true;
+        for (int n : {2, 3, 8}) {
+            std::vector<Bar> b = generate_bars(days, p, 100.0, 7, n);
+            for (int t = 0; ok && t < T; ++t)
+                ok = b[t].open == bars[t].open && b[t].high == bars[t].high && b[t].low == bars[t].low &&
+                     b[t].close == bars[t].close;
         }
+        if (!ok) failures++;
+        std::cout << "Generator across thread counts: " << (ok ? "match" : "MISMATCH") << "\n";
+    }
+
+    std::vector<Trade> ref = run_serial(bars, p, days, scan);
+    {
+        bool ok = same_trades(ref, run_serial(bars, p, days, index));
+        if (!ok) failures++;
+        std::cout << "Indexed vs scanned run: " << (ok ? "match" : "MISMATCH") << "\n";
+    }
+
+    {
+        const int sweep_days = std::min(days, 400);
+        SessionGrid g;
+        std::vector<SweepRow> rows = sweep_rows(bars, p, sweep_days, g, index, hw);
+        int bad = 0;
+        for (const auto& r : rows) {
+            Summary s1 = summarize(run_serial(bars, r.p, sweep_days, scan));
+            if (s1.trades != r.s.trades || s1.pnl != r.s.pnl || s1.maxDD != r.s.maxDD) bad++;
+        }
+        if (bad) failures++;
+        std::cout << "Sweep rows vs scanned single runs: " << rows.size() << " configurations, "
+                  << bad << " mismatches" << (bad ? "  FAILED" : "  OK") << "\n";
+    }
+
+    t0 = std::chrono::steady_clock::now();
+    ref = run_serial(bars, p, days, index);
+    double t_serial = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const int threads[] = {1, 2, 3, 8, hw};
+    const int blocks[] = {1, 7, 32};
+    for (int n : threads) {
+        for (int blk : blocks) {
+            bool ok = same_trades(ref, run_parallel(bars, p, days, index, n, blk));
+            if (!ok) failures++;
+            std::cout << "threads=" << n << " block=" << blk << ": " << (ok ? "match" : "MISMATCH") << "\n";
+        }
+    }
+
+    t0 = std::chrono::steady_clock::now();
+    std::vector<Trade> par = run_parallel(bars, p, days, index, hw);
+    double t_par = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(4)
+              << "Days: " << days << " | Trades: " << ref.size() << " | index build " << t_build
+              << "s | serial " << t_serial << "s | sharded (" << hw << " threads) " << t_par << "s\n";
+    std::cout << "London Breakout check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    // a key=value first means the default mode
+    std::string mode = (argc > 1) ? argv[1] : "run";
+    if (mode.find('=') != std::string::npos) mode = "run";
+    if (mode == "check") return run_check(argc, argv);
+    if (mode == "sweep") return run_sweep(argc, argv);
+    if (mode != "run" && mode != "parallel") {
+        std::cerr << "Usage: London_Breakout [run|parallel|sweep|check] [days=N] [threads=N] [data=FILE]\n";
+        return 1;
+    }
+
+    // --- Intraday simulation setup (synthetic, or an MT5 M5 bar export with data=FILE)
+    Params p;
+    int days = 0;
+    uint64_t threads = 0;
+    std::string err;
+    if (!read_days(argc, argv, 120, p, days, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const double S0 = 100.0;
+    const uint32_t seed = 7;
+
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    std::vector<Bar> bars;
+    if (path.empty()) bars = generate_bars(days, p, S0, seed);
+    else if (!load_session_bars(path, p, bars, days)) return 1;
+    SessionRangeIndex index(bars, 2 * p.bars_per_day);
+
+    std::vector<Trade> trades;
+    if (mode == "parallel") {
+        trades = run_parallel(bars, p, days, index, ctr::thread_count((int)threads));
+    } else {
+        trades = run_serial(bars, p, days, index);
     }
 
     // --- Reporting
@@ -197,6 +684,7 @@ int main() {
     }
 
     std::cout << "London Breakout (standalone C++)\n";
+    if (!path.empty()) std::cout << "Data: " << path << "\n";
     std::cout << "Days: " << days
               << " | Trades: " << trades.size()
               << " | Wins: " << wins
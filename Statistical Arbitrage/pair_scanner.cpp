@@ -0,0 +1,526 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define SCANNER_AVX2 1
+#endif
+
+#include "../Common/ctr_rng.hpp"
+#include "../Common/pairs_strategy.hpp"
+#include "../Common/util.hpp"
+
+// Pair-universe scanner: screens every pair of a universe for hedge ratio,
+// spread half-life and an Engle-Granger (ADF on OLS residuals) statistic,
+// then runs the rolling OLS + z-score strategy on the top-K pairs.
+//
+// All per-pair statistics are functions of three cross-moment matrices of the
+// demeaned log-prices X (T x N) and their first differences D:
+//   G  = X'X        (levels, t = 0..T-1)
+//   C  = X_lag'D    (lagged levels x differences, t = 0..T-2)
+//   GD = D'D        (differences, t = 0..T-2)
+// These are computed with a blocked, multi-threaded SIMD kernel; each pair is
+// then scored in O(1).
+
+// --- Column-major, padded and 32-byte aligned matrix of log-prices.
+// Column i (one instrument) is contiguous: col(i)[t], t < rows; the stride is
+// rounded up to a multiple of 4 doubles so every column starts aligned.
+class ColumnMatrix {
+public:
+    ColumnMatrix(int rows, int cols)
+        : rows_(rows), cols_(cols), ld_((rows + 3) & ~3),
+          data_(nullptr, &std::free) {
+        size_t bytes = sizeof(double) * (size_t)ld_ * cols_;
+        data_.reset(static_cast<double*>(std::aligned_alloc(32, (bytes + 31) & ~size_t(31))));
+        std::memset(data_.get(), 0, bytes);
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    double* col(int i) { return data_.get() + (size_t)ld_ * i; }
+    const double* col(int i) const { return data_.get() + (size_t)ld_ * i; }
+
+private:
+    int rows_, cols_, ld_;
+    std::unique_ptr<double, decltype(&std::free)> data_;
+};
+
+// --- Synthetic universe: clusters of instruments cointegrated with a cluster
+// factor (log p = log 100 + beta * F + AR(1) noise), plus independent random walks.
+// Draws are counter-based (Common/ctr_rng.hpp): bar t of instrument i comes from
+// block t / kStepBlock of path i, its (walk, beta) from path kSetup + i, and
+// factor c from path kFactor + c. Nothing depends on which thread generates which
+// series, so the data do not depend on the thread count.
+static ColumnMatrix generate_universe(int N, int T, unsigned seed, int n_threads) {
+    const int cluster_size = 10;
+    const int n_clusters = std::max(1, N / cluster_size);
+    const double sigma_f = 0.0010; // factor vol per bar
+    const double sigma_u = 0.0008; // idiosyncratic vol per bar
+    const double phi     = 0.98;   // AR(1) of cointegrated noise
+    const double p_walk  = 0.30;   // share of pure random walks
+    const uint64_t kFactor = 1ull << 32, kSetup = 2ull << 32;
+
+    std::vector<std::vector<double>> F(n_clusters, std::vector<double>(T));
+    ctr::for_blocks(n_clusters, n_threads, [&](uint32_t c, size_t, size_t) {
+        double v = 0.0;
+        for (int t0 = 0; t0 < T; t0 += (int)ctr::kStepBlock) {
+            ctr::Stream rng(seed, kFactor + c, (uint32_t)(t0 / ctr::kStepBlock));
+            for (int t = t0, e = std::min(T, t0 + (int)ctr::kStepBlock); t < e; ++t) { v += sigma_f * rng.normal(); F[c][t] = v; }
+        }
+    }, 1);
+
+    ColumnMatrix X(T, N);
+    ctr::for_blocks(N, n_threads, [&](uint32_t i, size_t, size_t) {
+        ctr::Stream setup(seed, kSetup + i, 0);
+        const auto& f = F[i % n_clusters];
+        bool walk = setup.uniform() < p_walk;
+        double beta = 0.5 + setup.uniform();
+        double u = 0.0, w = 0.0;
+        double* x = X.col(i);
+        for (int t0 = 0; t0 < T; t0 += (int)ctr::kStepBlock) {
+            ctr::Stream rng(seed, i, (uint32_t)(t0 / ctr::kStepBlock));
+            for (int t = t0, e = std::min(T, t0 + (int)ctr::kStepBlock); t < e; ++t) {
+                if (walk) { w += sigma_f * rng.normal(); x[t] = std::log(100.0) + w; }
+                else      { u = phi * u + sigma_u * rng.normal(); x[t] = std::log(100.0) + beta * f[t] + u; }
+            }
+        }
+    }, 1);
+    return X;
+}
+
+// --- Blocked cross-moment kernel: out(i, j) = sum_t a_i(t) * b_j(t), t in [0, n),
+// where a_i(t) is X(t, i) or the difference X(t+1, i) - X(t, i) (likewise for b).
+
+enum class Term { LEVEL, DIFF };
+
+template <Term TA, Term TB>
+static inline double dot_scalar(const double* a, const double* b, int t0, int t1) {
+    double s = 0.0;
+    for (int t = t0; t < t1; ++t) {
+        double av = (TA == Term::LEVEL) ? a[t] : a[t+1] - a[t];
+        double bv = (TB == Term::LEVEL) ? b[t] : b[t+1] - b[t];
+        s += av * bv;
+    }
+    return s;
+}
+
+// 2 x 4 micro-kernel over rows [t0, t1): acc[r][c] += sum a_r * b_c.
+template <Term TA, Term TB>
+static inline void micro_2x4(const double* a0, const double* a1,
+                             const double* b0, const double* b1, const double* b2, const double* b3,
+                             int t0, int t1, double acc[2][4]) {
+    int t = t0;
+#ifdef SCANNER_AVX2
+    auto ld = [](const double* p, int at, Term term) {
+        return term == Term::LEVEL ? _mm256_loadu_pd(p + at)
+                                   : _mm256_sub_pd(_mm256_loadu_pd(p + at + 1), _mm256_loadu_pd(p + at));
+    };
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c02 = _mm256_setzero_pd(), c03 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd(), c12 = _mm256_setzero_pd(), c13 = _mm256_setzero_pd();
+    for (; t + 4 <= t1; t += 4) {
+        __m256d x0 = ld(a0, t, TA), x1 = ld(a1, t, TA);
+        __m256d y0 = ld(b0, t, TB), y1 = ld(b1, t, TB), y2 = ld(b2, t, TB), y3 = ld(b3, t, TB);
+        c00 = _mm256_fmadd_pd(x0, y0, c00); c01 = _mm256_fmadd_pd(x0, y1, c01);
+        c02 = _mm256_fmadd_pd(x0, y2, c02); c03 = _mm256_fmadd_pd(x0, y3, c03);
+        c10 = _mm256_fmadd_pd(x1, y0, c10); c11 = _mm256_fmadd_pd(x1, y1, c11);
+        c12 = _mm256_fmadd_pd(x1, y2, c12); c13 = _mm256_fmadd_pd(x1, y3, c13);
+    }
+    auto hsum = [](__m256d v) {
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    };
+    acc[0][0] += hsum(c00); acc[0][1] += hsum(c01); acc[0][2] += hsum(c02); acc[0][3] += hsum(c03);
+    acc[1][0] += hsum(c10); acc[1][1] += hsum(c11); acc[1][2] += hsum(c12); acc[1][3] += hsum(c13);
+#endif
+    const double* a[2] = {a0, a1};
+    const double* b[4] = {b0, b1, b2, b3};
+    for (int r = 0; r < 2; ++r)
+        for (int c = 0; c < 4; ++c)
+            acc[r][c] += dot_scalar<TA, TB>(a[r], b[c], t, t1);
+}
+
+// out is N x N row-major. If `symmetric`, only tiles with bj >= bi are computed
+// and mirrored. Tiles are handed out to the worker pool through an atomic counter.
+template <Term TA, Term TB>
+static void cross_moments(const ColumnMatrix& X, int n_rows, bool symmetric,
+                          std::vector<double>& out, int n_threads) {
+    const int N = X.cols();
+    const int TB_COLS = 64;     // column tile (64 x 64 outputs)
+    const int T_CHUNK = 512;    // row chunk: 128 columns x 512 rows stay in L2
+    const int nb = (N + TB_COLS - 1) / TB_COLS;
+
+    std::vector<std::pair<int,int>> tiles;
+    for (int bi = 0; bi < nb; ++bi)
+        for (int bj = symmetric ? bi : 0; bj < nb; ++bj) tiles.push_back({bi, bj});
+
+    out.assign((size_t)N * N, 0.0);
+    std::atomic<int> next{0};
+
+    auto worker = [&]() {
+        std::vector<double> tile(TB_COLS * TB_COLS);
+        for (int k; (k = next.fetch_add(1)) < (int)tiles.size(); ) {
+            int i0 = tiles[k].first * TB_COLS, i1 = std::min(N, i0 + TB_COLS);
+            int j0 = tiles[k].second * TB_COLS, j1 = std::min(N, j0 + TB_COLS);
+            std::fill(tile.begin(), tile.end(), 0.0);
+
+            for (int t0 = 0; t0 < n_rows; t0 += T_CHUNK) {
+                int t1 = std::min(n_rows, t0 + T_CHUNK);
+                for (int i = i0; i < i1; i += 2) {
+                    int ia = i, ib = std::min(i + 1, i1 - 1);
+                    for (int j = j0; j < j1; j += 4) {
+                        int jc[4];
+                        for (int c = 0; c < 4; ++c) jc[c] = std::min(j + c, j1 - 1);
+                        double acc[2][4] = {};
+                        micro_2x4<TA, TB>(X.col(ia), X.col(ib), X.col(jc[0]), X.col(jc[1]),
+                                          X.col(jc[2]), X.col(jc[3]), t0, t1, acc);
+                        // edge lanes duplicate the last row/column and are dropped
+                        for (int r = 0; r < 2 && i + r < i1; ++r)
+                            for (int c = 0; c < 4 && j + c < j1; ++c)
+                                tile[(i + r - i0) * TB_COLS + (j + c - j0)] += acc[r][c];
+                    }
+                }
+            }
+
+            for (int i = i0; i < i1; ++i)
+                for (int j = j0; j < j1; ++j) {
+                    double v = tile[(i - i0) * TB_COLS + (j - j0)];
+                    out[(size_t)i * N + j] = v;
+                    if (symmetric) out[(size_t)j * N + i] = v;
+                }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int k = 1; k < n_threads; ++k) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+// --- Per-pair statistics
+
+struct PairStats {
+    int x = -1, y = -1;   // y ≈ a + beta x (log-prices)
+    double beta = 0.0;
+    double adf_t = 0.0;   // Engle-Granger: t-stat of gamma in de(t) = gamma e(t-1) + eps
+    double half_life = INFINITY;   // bars; infinite if not mean-reverting or the fit is degenerate
+};
+
+constexpr int kMaxInstruments = 1 << 15;   // N x N moment matrices indexed with int
+
+struct Moments {
+    int N = 0, T = 0;
+    std::vector<double> G, C, GD;
+    std::vector<double> mean; // column means removed from X
+    std::vector<double> last; // demeaned X(T-1, i), for G_lag = G - last last'
+
+    double g(int i, int j) const  { return G[(size_t)i * N + j]; }
+    double gl(int i, int j) const { return G[(size_t)i * N + j] - last[i] * last[j]; }
+    double c(int i, int j) const  { return C[(size_t)i * N + j]; }
+    double gd(int i, int j) const { return GD[(size_t)i * N + j]; }
+};
+
+// Engle-Granger statistics of y on x from the cross moments, O(1).
+static PairStats score_pair(const Moments& M, int x, int y) {
+    PairStats s;
+    s.x = x; s.y = y;
+    double gxx = M.g(x, x);
+    if (gxx <= 0.0) return s;
+    double b = M.g(x, y) / gxx;
+    s.beta = b;
+
+    // residual e = y - b x (demeaned), lagged / differenced sums
+    double s_ee = M.gl(y, y) - 2.0 * b * M.gl(x, y) + b * b * M.gl(x, x);
+    double s_ed = M.c(y, y) - b * (M.c(y, x) + M.c(x, y)) + b * b * M.c(x, x);
+    double s_dd = M.gd(y, y) - 2.0 * b * M.gd(x, y) + b * b * M.gd(x, x);
+    if (s_ee <= 0.0) return s;
+
+    int n = M.T - 1;
+    double gamma = s_ed / s_ee;
+    double sigma2 = std::max(s_dd - gamma * s_ed, 0.0) / std::max(n - 1, 1);
+    double se = std::sqrt(sigma2 / s_ee);
+    s.adf_t = (se > 0.0) ? gamma / se : 0.0;
+    s.half_life = (gamma < 0.0 && gamma > -1.0) ? -std::log(2.0) / std::log1p(gamma) : INFINITY;
+    return s;
+}
+
+// Direct per-pair computation on the raw columns (reference for the check mode).
+static PairStats score_pair_direct(const ColumnMatrix& X, int x, int y) {
+    const int T = X.rows();
+    const double* px = X.col(x);
+    const double* py = X.col(y);
+    double mx = 0.0, my = 0.0;
+    for (int t = 0; t < T; ++t) { mx += px[t]; my += py[t]; }
+    mx /= T; my /= T;
+    double num = 0.0, den = 0.0;
+    for (int t = 0; t < T; ++t) { num += (px[t]-mx) * (py[t]-my); den += (px[t]-mx) * (px[t]-mx); }
+    double b = num / den;
+
+    std::vector<double> e(T);
+    for (int t = 0; t < T; ++t) e[t] = (py[t]-my) - b * (px[t]-mx);
+    double s_ee = 0.0, s_ed = 0.0, s_dd = 0.0;
+    for (int t = 1; t < T; ++t) {
+        double de = e[t] - e[t-1];
+        s_ee += e[t-1] * e[t-1];
+        s_ed += e[t-1] * de;
+        s_dd += de * de;
+    }
+    PairStats s;
+    s.x = x; s.y = y; s.beta = b;
+    double gamma = s_ed / s_ee;
+    double sigma2 = std::max(s_dd - gamma * s_ed, 0.0) / (T - 2);
+    s.adf_t = gamma / std::sqrt(sigma2 / s_ee);
+    s.half_life = (gamma < 0.0 && gamma > -1.0) ? -std::log(2.0) / std::log1p(gamma) : INFINITY;
+    return s;
+}
+
+static Moments compute_moments(ColumnMatrix& X, int n_threads) {
+    const int N = X.cols(), T = X.rows();
+
+    Moments M;
+    M.N = N; M.T = T;
+    M.mean.resize(N);
+
+    // demean each column in place (the OLS intercept is absorbed)
+    for (int i = 0; i < N; ++i) {
+        double* x = X.col(i);
+        double m = 0.0;
+        for (int t = 0; t < T; ++t) m += x[t];
+        m /= T;
+        for (int t = 0; t < T; ++t) x[t] -= m;
+        M.mean[i] = m;
+    }
+
+    M.last.resize(N);
+    for (int i = 0; i < N; ++i) M.last[i] = X.col(i)[T-1];
+
+    cross_moments<Term::LEVEL, Term::LEVEL>(X, T,     true,  M.G,  n_threads);
+    cross_moments<Term::LEVEL, Term::DIFF >(X, T - 1, false, M.C,  n_threads);
+    cross_moments<Term::DIFF,  Term::DIFF >(X, T - 1, true,  M.GD, n_threads);
+    return M;
+}
+
+// Score all N(N-1)/2 pairs (both regression directions, keeping the more
+// stationary one) and keep the top K by ADF statistic (most negative first).
+static std::vector<PairStats> top_pairs(const Moments& M, int K, double max_half_life, int n_threads) {
+    auto better = [](const PairStats& a, const PairStats& b) { return a.adf_t < b.adf_t; };
+    const int N = M.N;
+    std::vector<std::vector<PairStats>> heaps(n_threads);
+    std::atomic<int> next{0};
+
+    auto worker = [&](int w) {
+        auto& heap = heaps[w]; // max-heap on adf_t: top() is the worst kept pair
+        for (int i; (i = next.fetch_add(1)) < N; ) {
+            for (int j = i + 1; j < N; ++j) {
+                PairStats s1 = score_pair(M, i, j);
+                PairStats s2 = score_pair(M, j, i);
+                const PairStats& s = better(s1, s2) ? s1 : s2;
+                if (!(s.half_life <= max_half_life)) continue;
+                if ((int)heap.size() < K) { heap.push_back(s); std::push_heap(heap.begin(), heap.end(), better); }
+                else if (better(s, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), better);
+                    heap.back() = s;
+                    std::push_heap(heap.begin(), heap.end(), better);
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int k = 1; k < n_threads; ++k) pool.emplace_back(worker, k);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    std::vector<PairStats> all;
+    for (auto& h : heaps) all.insert(all.end(), h.begin(), h.end());
+    std::sort(all.begin(), all.end(), [&](const PairStats& a, const PairStats& b) {
+        if (a.adf_t != b.adf_t) return a.adf_t < b.adf_t;
+        return std::make_pair(a.x, a.y) < std::make_pair(b.x, b.y);
+    });
+    if ((int)all.size() > K) all.resize(K);
+    return all;
+}
+
+// --- Rolling OLS + z-score strategy of pairs_trading (Common/pairs_strategy.hpp),
+// run on one screened pair with the incremental (O(1) per step) hedge model.
+
+struct StrategyResult {
+    int trades = 0, wins = 0;
+    double pnl = 0.0;
+};
+
+// Log-prices of pair s from the demeaned matrix (column means added back).
+static std::vector<pairs::PairPoint> pair_series(const ColumnMatrix& X, const Moments& M, const PairStats& s) {
+    std::vector<pairs::PairPoint> data(X.rows());
+    const double* px = X.col(s.x);
+    const double* py = X.col(s.y);
+    for (int t = 0; t < X.rows(); ++t) data[t] = {px[t] + M.mean[s.x], py[t] + M.mean[s.y]};
+    return data;
+}
+
+static StrategyResult run_pair_strategy(const std::vector<pairs::PairPoint>& data, const pairs::Params& p) {
+    StrategyResult res;
+    for (const auto& tr : pairs::run_strategy(data, p, pairs::IncrementalModel(data, p))) {
+        res.trades++;
+        if (tr.pnl >= 0) res.wins++;
+        res.pnl += tr.pnl;
+    }
+    return res;
+}
+
+// --- Command line: [check] key=value ... (n=instruments t=bars k=top-K threads= seed=)
+// Thread counts are pinned (1 vs 3) so the check means the same on any machine.
+static int run_check() {
+    const int N = 37, T = 5003; // deliberately not multiples of the tile/vector sizes
+    const int K = 10;
+    const double max_half_life = 500.0;
+    int failures = 0;
+
+    ColumnMatrix X = generate_universe(N, T, 11, 3);
+    ColumnMatrix X1 = generate_universe(N, T, 11, 1);
+    ColumnMatrix raw = generate_universe(N, T, 11, 1);
+    bool same = true;
+    for (int i = 0; i < N; ++i)
+        same = same && std::memcmp(X.col(i), raw.col(i), sizeof(double) * T) == 0;
+    if (!same) failures++;
+    std::cout << "Universe across thread counts (3 vs 1): " << (same ? "identical" : "DIFFERENT") << "\n";
+    Moments M = compute_moments(X, 3);
+    Moments M1 = compute_moments(X1, 1);
+
+    double max_rel = 0.0;
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j) {
+            if (i == j) continue;
+            PairStats a = score_pair(M, i, j);
+            PairStats b = score_pair_direct(raw, i, j);
+            max_rel = std::max(max_rel, std::fabs(a.beta - b.beta) / std::max(std::fabs(b.beta), 1e-12));
+            max_rel = std::max(max_rel, std::fabs(a.adf_t - b.adf_t) / std::max(std::fabs(b.adf_t), 1e-12));
+        }
+    bool ok = max_rel < 1e-6;
+    if (!ok) failures++;
+    std::cout << "Cross-moment scoring vs direct per-pair OLS/ADF: max rel diff = "
+              << std::scientific << std::setprecision(3) << max_rel << std::defaultfloat
+              << (ok ? "  OK" : "  FAILED") << "\n";
+
+    // top-K selection: same pairs, same order, same statistics on 1 and 3 threads
+    std::vector<PairStats> top1 = top_pairs(M1, K, max_half_life, 1);
+    std::vector<PairStats> top3 = top_pairs(M, K, max_half_life, 3);
+    same = !top1.empty() && top1.size() == top3.size();
+    for (size_t k = 0; same && k < top1.size(); ++k)
+        same = top1[k].x == top3[k].x && top1[k].y == top3[k].y && top1[k].adf_t == top3[k].adf_t &&
+               top1[k].beta == top3[k].beta && top1[k].half_life == top3[k].half_life;
+    if (!same) failures++;
+    std::cout << "Top " << K << " pairs across thread counts (3 vs 1): " << (same ? "identical" : "DIFFERENT") << "\n";
+
+    // a flat instrument has no fit against anything: none of its pairs is kept
+    {
+        ColumnMatrix flat = generate_universe(N, T, 11, 1);
+        std::fill(flat.col(0), flat.col(0) + T, 1.0);
+        Moments MF = compute_moments(flat, 1);
+        bool kept = false;
+        for (const auto& s : top_pairs(MF, N * N, max_half_life, 1)) kept = kept || s.x == 0 || s.y == 0;
+        if (kept) failures++;
+        std::cout << "Flat instrument in the screen: " << (kept ? "KEPT" : "excluded") << "\n";
+    }
+
+    // strategy on the screened pairs: incremental hedge model vs full rescans
+    pairs::Params p;
+    int n_trades = 0;
+    same = true;
+    for (const auto& s : top1) {
+        std::vector<pairs::PairPoint> data = pair_series(X1, M1, s);
+        auto t_ref = pairs::run_strategy(data, p, pairs::RescanModel{data, p});
+        auto t_new = pairs::run_strategy(data, p, pairs::IncrementalModel(data, p));
+        same = same && t_ref.size() == t_new.size();
+        for (size_t i = 0; same && i < t_ref.size(); ++i)
+            same = t_ref[i].entry == t_new[i].entry && t_ref[i].exit == t_new[i].exit &&
+                   t_ref[i].side == t_new[i].side && std::fabs(t_ref[i].pnl - t_new[i].pnl) < 1e-10;
+        n_trades += (int)t_ref.size();
+    }
+    if (!same) failures++;
+    std::cout << "Strategy on the top pairs, incremental vs rescan (" << n_trades << " trades): "
+              << (same ? "OK" : "FAILED") << "\n";
+
+    std::cout << "Pair scanner check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "run";
+    if (mode == "check") return run_check();
+
+    // --- Strategy params (pairs_trading defaults: L_beta = L_z = 200,
+    // z_entry 2.0, z_exit 0.5, max_hold 400)
+    const pairs::Params p;
+
+    // --- Universe and screening parameters: n instruments, t bars, k pairs kept
+    uint64_t n, t, k, threads;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "n", 200, 2, kMaxInstruments, n, err) ||
+        !util::arg_count_in(argc, argv, "t", 20000, std::max(p.L_beta, p.L_z) + 2, INT_MAX, t, err) ||
+        !util::arg_count_in(argc, argv, "k", 10, 1, INT_MAX, k, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int N = (int)n, T = (int)t, K = (int)k;
+    const int n_threads = ctr::thread_count((int)threads);
+    const unsigned seed = (unsigned)util::arg_u64(argc, argv, "seed", 42);
+    const double max_half_life = 500.0;                        // bars
+    const double eg_crit_5pct = -3.34;                         // Engle-Granger, 2 variables
+
+    auto t0 = std::chrono::steady_clock::now();
+    ColumnMatrix X = generate_universe(N, T, seed, n_threads);
+    auto t1 = std::chrono::steady_clock::now();
+
+    Moments M = compute_moments(X, n_threads);
+    auto t2 = std::chrono::steady_clock::now();
+    std::vector<PairStats> top = top_pairs(M, K, max_half_life, n_threads);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto secs = [](auto a, auto b) { return std::chrono::duration<double>(b - a).count(); };
+    double n_pairs = 0.5 * N * (N - 1.0);
+
+    std::cout << "Pair universe scanner (synthetic log-prices) - standalone C++\n";
+    std::cout << "Instruments: " << N << " | Bars: " << T << " | Pairs: " << (long long)n_pairs
+              << " | Threads: " << n_threads
+#ifdef SCANNER_AVX2
+              << " | Kernel: AVX2/FMA\n";
+#else
+              << " | Kernel: scalar\n";
+#endif
+    std::cout << std::fixed << std::setprecision(3)
+              << "Generate: " << secs(t0, t1) << "s | Cross moments: " << secs(t1, t2)
+              << "s | Scoring: " << secs(t2, t3) << "s ("
+              << std::setprecision(1) << n_pairs / std::max(secs(t2, t3), 1e-9) / 1e6 << "M pairs/s)\n\n";
+
+    std::cout << std::setw(6) << "y" << std::setw(6) << "x"
+              << std::setw(10) << "beta" << std::setw(10) << "ADF t"
+              << std::setw(11) << "half-life" << std::setw(6) << "EG5%"
+              << std::setw(8) << "trades" << std::setw(8) << "win%" << std::setw(12) << "PnL(log)" << "\n";
+
+    for (const auto& s : top) {
+        StrategyResult r = run_pair_strategy(pair_series(X, M, s), p);
+
+        std::cout << std::setw(6) << s.y << std::setw(6) << s.x
+                  << std::setw(10) << std::setprecision(4) << s.beta
+                  << std::setw(10) << std::setprecision(2) << s.adf_t
+                  << std::setw(11) << std::setprecision(1) << s.half_life
+                  << std::setw(6) << (s.adf_t < eg_crit_5pct ? "yes" : "no")
+                  << std::setw(8) << r.trades
+                  << std::setw(8) << (r.trades ? 100.0 * r.wins / r.trades : 0.0)
+                  << std::setw(12) << std::setprecision(4) << r.pnl << "\n";
+    }
+
+    return 0;
+}
@@ -1,53 +1,102 @@
+#include <climits>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <random>
+#include <string>
 #include <vector>
 
+#include "../Common/async_writer.hpp"
+#include "../Common/columnar.hpp"
+#include "../Common/ctr_rng.hpp"
+#include "../Common/util.hpp"
+
 struct PairPoint {
     double x;
     double y;
 };
 
+// Step t draws (dx, eps) from block t / kStepBlock of path 0 (Common/ctr_rng.hpp).
+// Draws are filled block by block on n_threads threads and x is accumulated in one
+// pass, so the series does not depend on the thread count.
 std::vector<PairPoint> generate_cointegrated_pair(
     int T,
     double beta = 1.25,
     double noise_sigma_low = 0.5,
     double noise_sigma_high = 1.5,
-    unsigned seed = 42
+    unsigned seed = 42,
+    int n_threads = 0
 ) {
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
-
-    std::vector<PairPoint> data;
-    data.reserve(T);
+    std::vector<PairPoint> data(T);
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1) {
+        ctr::Stream rng(seed, 0, b);
+        for (size_t t = t0; t < t1; ++t) {
+            data[t].x = rng.normal();
+            data[t].y = rng.normal();
+        }
+    });
 
     double x = 100.0;
-    double y = beta * x;
 
     for (int t = 0; t < T; ++t) {
         // latent random walk for x
-        double dx = 0.2 * N(rng);
+        double dx = 0.2 * data[t].x;
         x += dx;
 
         // regime change in noise
         double sigma = (t < T/2) ? noise_sigma_low : noise_sigma_high;
 
         // y cointegrated with x
-        double eps = sigma * N(rng);
-        y = beta * x + eps;
-
-        data.push_back({x, y});
+        double eps = sigma * data[t].y;
+        data[t] = {x, beta * x + eps};
     }
 
     return data;
 }
 
-int main() {
-    auto series = generate_cointegrated_pair(3000);
-
-    for (const auto& p : series) {
-        std::cout << p.x << " " << p.y << "\n";
+// Columnar output (x, y as f64), readable with col::Reader (e.g. pairs_trading data=FILE).
+static int write_columnar(const std::string& path, const std::vector<PairPoint>& series) {
+    col::Writer w;
+    if (!w.open(path, {{"x", col::Type::F64}, {"y", col::Type::F64}}, series.size())) {
+        std::cerr << w.error() << "\n";
+        return 1;
+    }
+    for (const auto& p : series) w.append(p.x, p.y);
+    if (!w.close()) {
+        std::cerr << w.error() << "\n";
+        return 1;
     }
+    return 0;
+}
 
+// Text output to stdout: "x y" per point, written by a background thread.
+static int write_text(const std::vector<PairPoint>& series) {
+    aout::Writer out;
+    out.open_fd(1);
+    for (const auto& p : series) out << p.x << ' ' << p.y << '\n';
+    if (!out.close()) {
+        std::cerr << out.error() << "\n";
+        return 1;
+    }
     return 0;
 }
+
+// ./synthetic_pairs [n=T]                text to stdout
+// ./synthetic_pairs write FILE [n=T]     columnar binary file
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    const bool to_file = (mode == "write");
+    if (to_file ? (argc < 3 || std::strchr(argv[2], '=') != nullptr)
+                : !(mode.empty() || mode.compare(0, 2, "n=") == 0)) {
+        std::cerr << "Usage: synthetic_pairs [n=T] | synthetic_pairs write FILE [n=T]\n";
+        return 1;
+    }
+    uint64_t n = 0;
+    if (!util::arg_count(argc, argv, "n", 3000, n) || n == 0 || n > INT_MAX) {
+        std::cerr << "n= must be a count in [1, " << INT_MAX << "]\n";
+        return 1;
+    }
+    const int T = (int)n;
+    if (to_file) return write_columnar(argv[2], generate_cointegrated_pair(T));
+    return write_text(generate_cointegrated_pair(T));
+}
@@ -2,10 +2,25 @@
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
-#include <random>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ATR_AVX2 1
+#endif
+
+#include "../Common/ctr_rng.hpp"
+#include "../Common/ensemble.hpp"
+#include "../Common/mt5_csv.hpp"
+#include "../Common/util.hpp"
 
 enum class PosState { FLAT=0, LONG=1, SHORT=-1 };
 
@@ -21,6 +36,32 @@ struct Trade {
     double pnl=0.0; // signed
 };
 
+struct Params {
+    // --- ATR parameters
+    int atrFast = 14;
+    int atrSlow = 50;
+    double mult = 1.50;
+
+    // --- Risk parameters (percent of entry)
+    bool useSLTP = true;
+    double alphaSL = 0.008; // 0.8%
+    double alphaTP = 0.016; // 1.6%
+};
+
+// Every column of the bar store starts on a cache line.
+using Column = std::vector<double, util::AlignedAllocator<double>>;
+
+// Columnar bar store: one contiguous, aligned array per field.
+struct BarStore {
+    Column open, high, low, close;
+
+    explicit BarStore(int T = 0) : open(T), high(T), low(T), close(T) {}
+
+    int size() const { return (int)close.size(); }
+    Bar bar(int t) const { return {open[t], high[t], low[t], close[t]}; }
+    void set(int t, const Bar& b) { open[t] = b.open; high[t] = b.high; low[t] = b.low; close[t] = b.close; }
+};
+
 static double true_range(const Bar& b, double prev_close) {
     double tr1 = b.high - b.low;
     double tr2 = std::fabs(b.high - prev_close);
@@ -35,14 +76,104 @@ static double sma(const std::vector<double>& x, int end_incl, int win) {
     return s / win;
 }
 
-int main() {
-    // --- Synthetic OHLC generation with volatility regimes
-    const int T = 5000;
-    const double S0 = 100.0;
-    const uint32_t seed = 123;
-    std::mt19937 rng(seed);
-    std::normal_distribution<double> N(0.0, 1.0);
+// True range of every bar: tr[0] = 0, tr[t] = max(H-L, |H-C[t-1]|, |L-C[t-1]|).
+// AVX2 path processes 4 bars per iteration; results are identical to the scalar path.
+static void true_range_batch(const BarStore& bars, double* tr) {
+    const int T = bars.size();
+    if (T == 0) return;
+    const double* H = bars.high.data();
+    const double* L = bars.low.data();
+    const double* C = bars.close.data();
+    tr[0] = 0.0;
+    int t = 1;
+#ifdef ATR_AVX2
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    for (; t + 4 <= T; t += 4) {
+        __m256d h  = _mm256_loadu_pd(H + t);
+        __m256d l  = _mm256_loadu_pd(L + t);
+        __m256d pc = _mm256_loadu_pd(C + t - 1);
+        __m256d r1 = _mm256_sub_pd(h, l);
+        __m256d r2 = _mm256_andnot_pd(sign, _mm256_sub_pd(h, pc));
+        __m256d r3 = _mm256_andnot_pd(sign, _mm256_sub_pd(l, pc));
+        _mm256_storeu_pd(tr + t, _mm256_max_pd(_mm256_max_pd(r1, r2), r3));
+    }
+#endif
+    for (; t < T; ++t) tr[t] = std::max({H[t] - L[t], std::fabs(H[t] - C[t-1]), std::fabs(L[t] - C[t-1])});
+}
+
+// Compensated prefix sums of the true range: any window sum in O(1), shared by
+// every ATR window (single run and sweep alike, so both see identical ATR values).
+struct TRPrefix {
+    std::vector<double> hi, lo; // hi[k] + lo[k] = tr[0] + ... + tr[k-1]
+
+    TRPrefix() = default;
+    TRPrefix(const double* tr, int T) { build(tr, T); }
+
+    // (Re)computes the sums for tr[0 .. T), reusing the arrays' capacity.
+    void build(const double* tr, int T) {
+        hi.assign(T + 1, 0.0);
+        lo.assign(T + 1, 0.0);
+        util::CompensatedSum s;
+        for (int k = 0; k < T; ++k) {
+            s.add(tr[k]);
+            hi[k+1] = s.sum;
+            lo[k+1] = s.comp;
+        }
+    }
+
+    int size() const { return (int)hi.size() - 1; }
+
+    // ATR over tr[t-win+1 .. t] for t >= win, 0 before (same convention as the
+    // original per-index sma() precompute).
+    double atr(int t, int win) const {
+        if (t < win) return 0.0;
+        int e = t + 1, b = e - win;
+        return ((hi[e] - hi[b]) + (lo[e] - lo[b])) / win;
+    }
+};
+
+// Batch ATR series for one window, O(1) per index.
+static void atr_series(const TRPrefix& ps, int win, double* out) {
+    for (int t = 0; t < ps.size(); ++t) out[t] = ps.atr(t, win);
+}
+
+// Streaming ATR: one update per closed bar (TR from the previous close, then a
+// ring-buffer rolling mean). value() matches the batch series at the same index
+// up to rounding.
+class StreamingATR {
+public:
+    explicit StreamingATR(int win) : buf_(win, 0.0), win_(win) {}
+
+    double update(const Bar& b) {
+        double tr = (n_ == 0) ? 0.0 : true_range(b, prev_close_);
+        prev_close_ = b.close;
+        if (n_ >= win_) s_.add(-buf_[head_]); // drop x[n-win] before adding x[n]
+        s_.add(tr);
+        buf_[head_] = tr;
+        if (++head_ == win_) head_ = 0;
+        ++n_;
+        return value();
+    }
+
+    bool ready() const { return n_ > win_; }
+    double value() const { return ready() ? s_.value() / win_ : 0.0; }
+
+private:
+    std::vector<double> buf_;
+    int win_;
+    int head_ = 0;
+    long long n_ = 0;
+    double prev_close_ = 0.0;
+    util::CompensatedSum s_;
+};
 
+// --- Synthetic OHLC generation with volatility regimes
+// Counter-based draws (Common/ctr_rng.hpp): bar t uses block t / kStepBlock of
+// path 0. Blocks store their close / high / low factors on n_threads threads (3
+// batch normals per bar, one exp over the block), then one pass chains the
+// closes, so the bars do not depend on the thread count.
+static void fill_bars(BarStore& bars, double S0, uint32_t seed, int n_threads) {
+    const int T = bars.size();
     auto sigma_regime = [&](int t){
         // alternating regimes
         if (t < 1500) return 0.0008;      // low vol
@@ -51,53 +182,58 @@ int main() {
         return 0.0018;                   // high again
     };
 
-    std::vector<Bar> bars(T);
+    ctr::for_blocks(T, n_threads, [&](uint32_t b, size_t t0, size_t t1){
+        const size_t len = t1 - t0;
+        double z[3 * ctr::kStepBlock];   // per-thread scratch on the stack, no allocation per block
+        ctr::Stream(seed, 0, b).normals(z, 3 * len);
+        for(size_t i=0;i<len;i++){
+            double sigma = sigma_regime((int)(t0 + i));
+            z[3*i]   = -0.5*sigma*sigma + sigma*z[3*i];
+            z[3*i+1] = std::fabs(sigma*z[3*i+1]);
+            z[3*i+2] = std::fabs(sigma*z[3*i+2]);
+        }
+        ctr::exp_batch(z, 3 * len);
+        for(size_t i=0;i<len;i++){
+            bars.close[t0+i] = z[3*i];
+            bars.high[t0+i]  = z[3*i+1];
+            bars.low[t0+i]   = z[3*i+2];
+        }
+    });
+
     double last = S0;
     for(int t=0;t<T;t++){
-        double sigma = sigma_regime(t);
-        double z1=N(rng), z2=N(rng), z3=N(rng);
-
         double open = last;
-        double close = open * std::exp(-0.5*sigma*sigma + sigma*z1);
+        double close = open * bars.close[t];
 
-        double high = std::max(open, close) * std::exp(std::fabs(sigma*z2));
-        double low  = std::min(open, close) / std::exp(std::fabs(sigma*z3));
+        double high = std::max(open, close) * bars.high[t];
+        double low  = std::min(open, close) / bars.low[t];
 
-        bars[t] = {open, high, low, close};
+        bars.set(t, {open, high, low, close});
         last = close;
     }
+}
 
-    // --- ATR parameters
-    const int atrFast = 14;
-    const int atrSlow = 50;
-    const double mult = 1.50;
-
-    // --- Breakout definition: Close(t) vs High/Low(t-1)
-    // (we use closed-bar logic; decision at t uses bars[t-1] and indicators up to t-1)
-    // --- Risk parameters (percent of entry)
-    const bool useSLTP = true;
-    const double alphaSL = 0.008; // 0.8%
-    const double alphaTP = 0.016; // 1.6%
-
-    // --- Precompute TR and ATR series
-    std::vector<double> tr(T, 0.0);
-    for(int t=1;t<T;t++){
-        tr[t] = true_range(bars[t], bars[t-1].close);
-    }
+static BarStore generate_bars(int T, double S0, uint32_t seed, int n_threads = 0) {
+    BarStore bars(T);
+    fill_bars(bars, S0, seed, n_threads);
+    return bars;
+}
 
-    std::vector<double> atrF(T, 0.0), atrS(T, 0.0);
-    for(int t=0;t<T;t++){
-        if(t >= atrFast) atrF[t] = sma(tr, t, atrFast);
-        if(t >= atrSlow) atrS[t] = sma(tr, t, atrSlow);
-    }
+// --- Breakout definition: Close(t) vs High/Low(t-1)
+// (we use closed-bar logic; decision at t uses bars[t-1] and indicators up to t-1)
+// expansion(i) is the ATR expansion predicate on closed bar i.
+// Fills `trades` (cleared first, capacity kept) with the trades of one run.
+template <class Expansion>
+static void run_strategy(const BarStore& bars, const Params& p, Expansion&& expansion_at,
+                         std::vector<Trade>& trades) {
+    const int T = bars.size();
 
     // --- Strategy state
     PosState pos = PosState::FLAT;
     double entry=0.0;
     int entry_idx=-1;
 
-    std::vector<Trade> trades;
-    trades.reserve(256);
+    trades.clear();
 
     auto open_pos = [&](int idx, PosState side, double px){
         pos = side;
@@ -123,30 +259,28 @@ int main() {
     };
 
     // --- Main loop (closed bars only)
-    for(int t = atrSlow + 2; t < T; ++t) {
+    for(int t = p.atrSlow + 2; t < T; ++t) {
         int sig_idx = t-1; // last closed bar
 
         // --- If in position: evaluate SL/TP first
-        if(useSLTP && pos != PosState::FLAT) {
+        if(p.useSLTP && pos != PosState::FLAT) {
             int s = static_cast<int>(pos);
-            double SL = entry * (1.0 - s * alphaSL);
-            double TP = entry * (1.0 + s * alphaTP);
-
-            const auto& b = bars[sig_idx];
+            double SL = entry * (1.0 - s * p.alphaSL);
+            double TP = entry * (1.0 + s * p.alphaTP);
 
-            bool hitSL = (s == +1) ? (b.low  <= SL) : (b.high >= SL);
-            bool hitTP = (s == +1) ? (b.high >= TP) : (b.low  <= TP);
+            bool hitSL = (s == +1) ? (bars.low[sig_idx]  <= SL) : (bars.high[sig_idx] >= SL);
+            bool hitTP = (s == +1) ? (bars.high[sig_idx] >= TP) : (bars.low[sig_idx]  <= TP);
 
             if(hitSL) { close_pos(sig_idx, SL, "SL"); continue; }
             if(hitTP) { close_pos(sig_idx, TP, "TP"); continue; }
         }
 
         // --- Signals on closed bar sig_idx
-        bool expansion = (atrF[sig_idx] > mult * atrS[sig_idx]);
+        bool expansion = expansion_at(sig_idx);
 
-        double C = bars[sig_idx].close;
-        double Hprev = bars[sig_idx-1].high;
-        double Lprev = bars[sig_idx-1].low;
+        double C = bars.close[sig_idx];
+        double Hprev = bars.high[sig_idx-1];
+        double Lprev = bars.low[sig_idx-1];
 
         bool breakoutUp   = (C > Hprev);
         bool breakoutDown = (C < Lprev);
@@ -167,8 +301,440 @@ int main() {
 
     // Close any open position at end
     if(pos != PosState::FLAT) {
-        close_pos(T-1, bars[T-1].close, "EOD");
+        close_pos(T-1, bars.close[T-1], "EOD");
     }
+}
+
+template <class Expansion>
+static std::vector<Trade> run_strategy(const BarStore& bars, const Params& p, Expansion&& expansion_at) {
+    std::vector<Trade> trades;
+    trades.reserve(256);
+    run_strategy(bars, p, expansion_at, trades);
+    return trades;
+}
+
+// --- Parameter sweep
+
+struct Summary {
+    int trades = 0, wins = 0;
+    double pnl = 0.0, maxDD = 0.0;
+};
+
+static Summary summarize(const std::vector<Trade>& trades) {
+    Summary s;
+    double equity = 0.0, peak = 0.0;
+    for (const auto& trd : trades) {
+        s.pnl += trd.pnl;
+        equity += trd.pnl;
+        peak = std::max(peak, equity);
+        s.maxDD = std::max(s.maxDD, peak - equity);
+        if (trd.pnl >= 0) s.wins++;
+    }
+    s.trades = (int)trades.size();
+    return s;
+}
+
+// --- Monte Carlo ensemble
+// Path k is the synthetic bar series of seed `seed + k` (path 0 is the default
+// run), with the same batch TR / ATR pipeline as a single run.
+
+struct EnsembleState {
+    BarStore bars;
+    Column tr, atrF, atrS;
+    TRPrefix ps;
+    std::vector<Trade> trades;
+};
+
+static ens::Path ensemble_path(EnsembleState& st, const Params& p, double S0, uint32_t seed) {
+    const int T = st.bars.size();
+    fill_bars(st.bars, S0, seed, 1);
+    true_range_batch(st.bars, st.tr.data());
+    st.ps.build(st.tr.data(), T);
+    atr_series(st.ps, p.atrFast, st.atrF.data());
+    atr_series(st.ps, p.atrSlow, st.atrS.data());
+    run_strategy(st.bars, p, [&](int i) { return st.atrF[i] > p.mult * st.atrS[i]; }, st.trades);
+    Summary s = summarize(st.trades);
+    return {s.pnl, s.maxDD, s.trades, s.wins};
+}
+
+static ens::Distribution run_paths(const Params& p, int T, double S0, uint32_t seed, uint64_t n_paths,
+                                   int n_threads) {
+    return ens::run(n_paths, n_threads,
+        [&]() {
+            EnsembleState st;
+            st.bars = BarStore(T);
+            st.tr.assign(T, 0.0);
+            st.atrF.assign(T, 0.0);
+            st.atrS.assign(T, 0.0);
+            st.trades.reserve(256);
+            return st;
+        },
+        [&](EnsembleState& st, uint64_t k) { return ensemble_path(st, p, S0, seed + (uint32_t)k); });
+}
+
+// Work-stealing pool: each worker owns a deque of job ids, pops from its back,
+// and steals from the front of another worker's deque once its own is empty.
+// fn(job, worker) must only write to state owned by `job` or `worker`.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int n_threads) : queues_(std::max(1, n_threads)) {}
+
+    int size() const { return (int)queues_.size(); }
+
+    template <class Fn>
+    void run(int n_jobs, Fn&& fn) {
+        const int W = size();
+        for (int j = 0; j < n_jobs; ++j) queues_[j % W].jobs.push_back(j);
+
+        auto worker = [&](int w) {
+            for (int job; pop(w, job) || steal(w, job); ) fn(job, w);
+        };
+        std::vector<std::thread> pool;
+        for (int w = 1; w < W; ++w) pool.emplace_back(worker, w);
+        worker(0);
+        for (auto& th : pool) th.join();
+    }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<int> jobs;
+    };
+
+    bool pop(int w, int& job) {
+        std::lock_guard<std::mutex> lk(queues_[w].m);
+        if (queues_[w].jobs.empty()) return false;
+        job = queues_[w].jobs.back();
+        queues_[w].jobs.pop_back();
+        return true;
+    }
+    bool steal(int w, int& job) {
+        for (int k = 1; k < size(); ++k) {
+            Queue& q = queues_[(w + k) % size()];
+            std::lock_guard<std::mutex> lk(q.m);
+            if (q.jobs.empty()) continue;
+            job = q.jobs.front();
+            q.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues_;
+};
+
+struct SweepGrid {
+    util::Range fast{5, 30, 5}, slow{30, 120, 10}, mult{1.1, 2.0, 0.1};
+    util::Range sl{0.008, 0.008, 1}, tp{0.016, 0.016, 1};
+};
+
+struct SweepRow {
+    Params p;
+    Summary s;
+};
+
+// Every combination of the grid, in grid order. The TR prefix sum is built once;
+// each (atrFast, atrSlow) pair is one job that derives both ATR series from it,
+// evaluates the expansion predicate for all mult values of the grid at once into
+// per-bar bitmasks, then simulates every (mult, SL, TP). Expansion bits use the
+// same comparison on the same ATR values as a single run, so rows match exactly.
+static std::vector<SweepRow> sweep_rows(const BarStore& bars, const Params& base, const SweepGrid& g,
+                                        int n_threads) {
+    const int T = bars.size();
+    Column tr(T, 0.0);
+    true_range_batch(bars, tr.data());
+    TRPrefix ps(tr.data(), T);
+
+    std::vector<std::pair<int,int>> windows;
+    for (int i = 0; i < g.fast.count(); ++i)
+        for (int j = 0; j < g.slow.count(); ++j) {
+            int f = (int)std::lround(g.fast.at(i)), sN = (int)std::lround(g.slow.at(j));
+            if (0 < f && f < sN && T > sN + 2) windows.push_back({f, sN});
+        }
+
+    const int n_mult = g.mult.count();
+    const int n_risk = g.sl.count() * g.tp.count();
+    const int n_words = (n_mult + 63) / 64;
+    std::vector<double> mults(n_mult);
+    for (int j = 0; j < n_mult; ++j) mults[j] = g.mult.at(j);
+
+    std::vector<SweepRow> rows(windows.size() * n_mult * n_risk);
+
+    struct Scratch { std::vector<double> atrF, atrS; std::vector<uint64_t> mask; };
+    WorkStealingPool pool(n_threads);
+    std::vector<Scratch> scratch(pool.size());
+
+    pool.run((int)windows.size(), [&](int job, int w) {
+        Scratch& sc = scratch[w];
+        sc.atrF.resize(T); sc.atrS.resize(T); sc.mask.assign((size_t)T * n_words, 0);
+
+        Params p = base;
+        p.atrFast = windows[job].first;
+        p.atrSlow = windows[job].second;
+        atr_series(ps, p.atrFast, sc.atrF.data());
+        atr_series(ps, p.atrSlow, sc.atrS.data());
+
+        // expansion bit j of bar t: atrF[t] > mult_j * atrS[t]
+        for (int t = 0; t < T; ++t) {
+            double f = sc.atrF[t], sl = sc.atrS[t];
+            uint64_t* m = &sc.mask[(size_t)t * n_words];
+            for (int j = 0; j < n_mult; ++j)
+                m[j >> 6] |= (uint64_t)(f > mults[j] * sl) << (j & 63);
+        }
+
+        for (int j = 0; j < n_mult; ++j) {
+            p.mult = mults[j];
+            const uint64_t* mw = sc.mask.data() + (j >> 6);
+            const int bit = j & 63;
+            for (int r = 0; r < n_risk; ++r) {
+                p.alphaSL = g.sl.at(r / g.tp.count());
+                p.alphaTP = g.tp.at(r % g.tp.count());
+                auto trades = run_strategy(bars, p, [&](int i) {
+                    return ((mw[(size_t)i * n_words] >> bit) & 1u) != 0;
+                });
+                rows[((size_t)job * n_mult + j) * n_risk + r] = {p, summarize(trades)};
+            }
+        }
+    });
+
+    return rows;
+}
+
+// Batch vs streaming vs original per-index rescan, on a long series.
+static int run_check() {
+    const int T = 200000;
+    BarStore bars = generate_bars(T, 100.0, 99);
+    int failures = 0;
+
+    // TR: SIMD kernel vs scalar definition (bit-exact)
+    std::vector<double> tr(T), tr_ref(T, 0.0);
+    true_range_batch(bars, tr.data());
+    for (int t = 1; t < T; ++t) tr_ref[t] = true_range(bars.bar(t), bars.close[t-1]);
+    if (tr != tr_ref) { failures++; std::cout << "TR kernel mismatch\n"; }
+
+    TRPrefix ps(tr.data(), T);
+    for (int win : {14, 50, 500}) {
+        std::vector<double> batch(T);
+        atr_series(ps, win, batch.data());
+        StreamingATR stream(win);
+
+        double max_rel = 0.0;
+        for (int t = 0; t < T; ++t) {
+            double s = stream.update(bars.bar(t));
+            double ref = (t >= win) ? sma(tr_ref, t, win) : 0.0;
+            double scale = std::max(std::fabs(ref), 1e-300);
+            max_rel = std::max(max_rel, std::fabs(batch[t] - ref) / scale);
+            max_rel = std::max(max_rel, std::fabs(s - ref) / scale);
+        }
+        bool ok = max_rel < 1e-12;
+        if (!ok) failures++;
+        std::cout << "ATR(" << win << ") batch/streaming vs rescan: max rel diff = "
+                  << std::scientific << std::setprecision(3) << max_rel << (ok ? "  OK" : "  FAILED") << "\n";
+    }
+
+    // sweep rows vs. single runs (trade count and PnL must be identical)
+    {
+        BarStore b5 = generate_bars(5000, 100.0, 123);
+        SweepGrid g;
+        std::vector<SweepRow> rows = sweep_rows(b5, Params{}, g, 3);
+        Column tr5(b5.size(), 0.0);
+        true_range_batch(b5, tr5.data());
+        TRPrefix ps5(tr5.data(), b5.size());
+        int mismatches = 0;
+        for (const auto& r : rows) {
+            Column f(b5.size()), sl(b5.size());
+            atr_series(ps5, r.p.atrFast, f.data());
+            atr_series(ps5, r.p.atrSlow, sl.data());
+            Summary s1 = summarize(run_strategy(b5, r.p, [&](int i) { return f[i] > r.p.mult * sl[i]; }));
+            if (s1.trades != r.s.trades || s1.pnl != r.s.pnl || s1.maxDD != r.s.maxDD) mismatches++;
+        }
+        if (mismatches) failures++;
+        std::cout << "Sweep rows vs single runs: " << rows.size() << " combinations, "
+                  << mismatches << " mismatches" << (mismatches ? "  FAILED" : "  OK") << "\n";
+    }
+
+    // generator: the same bars whatever the thread count
+    {
+        BarStore one = generate_bars(100003, 100.0, 99, 1);
+        bool same = true;
+        for (int th : {2, 3, 8}) {
+            BarStore b = generate_bars(100003, 100.0, 99, th);
+            same = same && b.open == one.open && b.high == one.high && b.low == one.low && b.close == one.close;
+        }
+        if (!same) failures++;
+        std::cout << "Generator across thread counts: " << (same ? "OK" : "FAILED") << "\n";
+    }
+
+    // ensemble: path 0 is the single run of the base seed, and the distributions
+    // do not depend on the thread count
+    {
+        Params p;
+        BarStore b = generate_bars(5000, 100.0, 123);
+        Column tr1(5000, 0.0), f(5000), sl(5000);
+        true_range_batch(b, tr1.data());
+        TRPrefix ps1(tr1.data(), 5000);
+        atr_series(ps1, p.atrFast, f.data());
+        atr_series(ps1, p.atrSlow, sl.data());
+        Summary s1 = summarize(run_strategy(b, p, [&](int i) { return f[i] > p.mult * sl[i]; }));
+        const ens::Distribution d1 = run_paths(p, 5000, 100.0, 123, 1, 1);
+        const ens::Distribution e1 = run_paths(p, 5000, 100.0, 123, 300, 1);
+        bool ok = d1.pnl.sum.value() == s1.pnl && d1.trades.sum.value() == s1.trades;
+        for (int th : {2, 3}) ok = ok && ens::same_distribution(e1, run_paths(p, 5000, 100.0, 123, 300, th));
+        if (!ok) failures++;
+        std::cout << "Ensemble path 0 vs single run, thread counts: " << (ok ? "OK" : "FAILED") << "\n";
+    }
+
+    std::cout << "ATR pipeline check: " << (failures == 0 ? "OK" : "FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// Distribution of PnL, win rate and drawdown over many independent paths.
+static int run_ensemble(int argc, char** argv, const Params& p, int T, double S0, uint32_t seed) {
+    // paths stay below 2^32: seeds are 32-bit
+    uint64_t n_paths, n, threads;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "paths", 10000, 1, UINT32_MAX, n_paths, err) ||
+        !util::arg_count_in(argc, argv, "n", T, p.atrSlow + 3, INT_MAX, n, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = (int)threads;
+    T = (int)n;
+    seed = (uint32_t)util::arg_u64(argc, argv, "seed", seed);
+
+    auto t0 = std::chrono::steady_clock::now();
+    ens::Distribution d = run_paths(p, T, S0, seed, n_paths, n_threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "ATR Expansion Breakout ensemble: " << n_paths << " paths x " << T << " bars, seeds "
+              << seed << ".." << seed + (uint32_t)(n_paths - 1) << ", ATR " << p.atrFast << "/" << p.atrSlow
+              << " mult=" << p.mult << "\n";
+    std::cout << "threads=" << ctr::thread_count(n_threads) << " time=" << secs << "s ("
+              << std::setprecision(0) << n_paths / secs << " paths/s)\n\n";
+    ens::print(std::cout, d);
+    return 0;
+}
+
+static int run_sweep(int argc, char** argv, const Params& base, int T, double S0, uint32_t seed) {
+    SweepGrid g;
+
+    for (int a = 2; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (util::parse_range(arg, "fast", g.fast) || util::parse_range(arg, "slow", g.slow) ||
+            util::parse_range(arg, "mult", g.mult) || util::parse_range(arg, "sl", g.sl) || util::parse_range(arg, "tp", g.tp)) continue;
+        bool scalar = false;   // read below
+        for (const char* key : {"n", "threads", "top", "data"}) scalar = scalar || util::arg_has_key(arg, key);
+        if (scalar) continue;
+        std::cerr << "Unknown sweep argument: " << arg
+                  << " (expected fast=, slow=, mult=, sl=, tp= as lo:hi:step, or n=, threads=, top=, data=FILE)\n";
+        return 1;
+    }
+    for (const auto& axis : {std::make_pair("fast", &g.fast), std::make_pair("slow", &g.slow), std::make_pair("mult", &g.mult), std::make_pair("sl", &g.sl), std::make_pair("tp", &g.tp)})
+        if (!axis.second->ok) {
+            std::cerr << util::range_error(axis.first) << "\n";
+            return 1;
+        }
+    if (util::grid_count({&g.fast, &g.slow, &g.mult, &g.sl, &g.tp}) == 0) {
+        std::cerr << "The grid has more than " << util::Range::kMaxCount << " combinations.\n";
+        return 1;
+    }
+
+    uint64_t n, threads, top_n;
+    std::string err;
+    if (!util::arg_count_in(argc, argv, "n", T, 1, INT_MAX, n, err) ||
+        !util::arg_count_in(argc, argv, "threads", 0, 0, util::kMaxThreads, threads, err) ||
+        !util::arg_count_in(argc, argv, "top", 20, 1, INT_MAX, top_n, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const int n_threads = ctr::thread_count((int)threads);
+    const int top = (int)top_n;
+
+    auto t0 = std::chrono::steady_clock::now();
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    BarStore bars;
+    if (path.empty()) bars = generate_bars((int)n, S0, seed);
+    else if (!mt5::load_ohlc(path, bars, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::vector<SweepRow> rows = sweep_rows(bars, base, g, n_threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (rows.empty()) {
+        std::cerr << "No valid (fast, slow) pair in the grid.\n";
+        return 1;
+    }
+
+    // rank by PnL, ties broken by the grid order (deterministic for any thread count)
+    std::stable_sort(rows.begin(), rows.end(), [](const SweepRow& x, const SweepRow& y) {
+        return x.s.pnl > y.s.pnl;
+    });
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "ATR Expansion Breakout parameter sweep (standalone C++)\n";
+    std::cout << "Bars: " << bars.size() << " | Combinations: " << rows.size()
+              << " | Threads: " << n_threads << " | Time: " << secs << "s\n\n";
+    std::cout << std::setw(5) << "fast" << std::setw(6) << "slow" << std::setw(7) << "mult"
+              << std::setw(8) << "SL%" << std::setw(8) << "TP%"
+              << std::setw(8) << "trades" << std::setw(10) << "win%"
+              << std::setw(12) << "PnL" << std::setw(12) << "maxDD" << "\n";
+    for (int k = 0; k < std::min(top, (int)rows.size()); ++k) {
+        const auto& r = rows[k];
+        double wr = r.s.trades > 0 ? 100.0 * r.s.wins / r.s.trades : 0.0;
+        std::cout << std::setw(5) << r.p.atrFast << std::setw(6) << r.p.atrSlow
+                  << std::setw(7) << std::setprecision(2) << r.p.mult
+                  << std::setw(8) << 100.0 * r.p.alphaSL << std::setw(8) << 100.0 * r.p.alphaTP
+                  << std::setw(8) << r.s.trades << std::setw(10) << wr
+                  << std::setw(12) << std::setprecision(4) << r.s.pnl << std::setw(12) << r.s.maxDD << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "run";
+    if (mode == "check") return run_check();
+
+    // --- Synthetic OHLC generation with volatility regimes, or an MT5 bar export (data=FILE)
+    int T = 5000;
+    const double S0 = 100.0;
+    const uint32_t seed = 123;
+    Params p;
+    // --- ATR parameters
+    p.atrFast = 14;
+    p.atrSlow = 50;
+    p.mult = 1.50;
+
+    // --- Risk parameters (percent of entry)
+    p.useSLTP = true;
+    p.alphaSL = 0.008; // 0.8%
+    p.alphaTP = 0.016; // 1.6%
+
+    // ensemble and sweep build (or load) their own bars
+    if (mode == "ensemble") return run_ensemble(argc, argv, p, T, S0, seed);
+    if (mode == "sweep") return run_sweep(argc, argv, p, T, S0, seed);
+
+    const std::string path = util::arg_string(argc, argv, "data", "");
+    BarStore bars;
+    std::string err;
+    if (path.empty()) bars = generate_bars(T, S0, seed);
+    else if (!mt5::load_ohlc(path, bars, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    T = bars.size();
+
+    // --- Precompute TR and ATR series (O(1) per bar)
+    Column tr(T, 0.0), atrF(T, 0.0), atrS(T, 0.0);
+    true_range_batch(bars, tr.data());
+    TRPrefix ps(tr.data(), T);
+    atr_series(ps, p.atrFast, atrF.data());
+    atr_series(ps, p.atrSlow, atrS.data());
+
+    std::vector<Trade> trades = run_strategy(bars, p, [&](int i) {
+        return atrF[i] > p.mult * atrS[i];
+    });
 
     // --- Reporting
     double total_pnl = 0.0;
@@ -179,6 +745,7 @@ int main() {
     }
 
     std::cout << "ATR Expansion Breakout (standalone C++)\n";
+    if (!path.empty()) std::cout << "Data: " << path << " (" << T << " bars)\n";
     std::cout << "Trades: " << trades.size()
               << " | Wins: " << wins
               << " | Losses: " << losses